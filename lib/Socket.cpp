@@ -87,6 +87,23 @@ UDPPacket::UDPPacket(size_t initSize) :
     address()
 { }
 
+// Room for IP_PKTINFO and SO_TIMESTAMPNS
+static constexpr size_t BATCH_CONTROL_SIZE =
+    CMSG_SPACE(sizeof(struct in_pktinfo)) + CMSG_SPACE(sizeof(struct timespec));
+
+UDPPacketBatch::UDPPacketBatch(size_t max_packets, size_t max_size) :
+    packets(max_packets),
+    m_max_size(max_size),
+    m_msgs(max_packets),
+    m_iovecs(max_packets),
+    m_addrs(max_packets),
+    m_control(max_packets * BATCH_CONTROL_SIZE)
+{
+    for (auto& p : packets) {
+        p.buffer.reserve(max_size);
+    }
+}
+
 
 UDPSocket::UDPSocket()
 {
@@ -325,6 +342,109 @@ UDPPacket UDPSocket::receive(size_t max_size)
     return packet;
 }
 
+size_t UDPSocket::receive_batch(UDPPacketBatch& batch)
+{
+    const size_t max_packets = batch.packets.size();
+    batch.num_packets = 0;
+
+    for (size_t i = 0; i < max_packets; i++) {
+        // Only the packets received last time were shrunk. This does not
+        // reallocate, the capacity was reserved.
+        batch.packets[i].buffer.resize(batch.m_max_size);
+
+        batch.m_iovecs[i].iov_base = batch.packets[i].buffer.data();
+        batch.m_iovecs[i].iov_len = batch.m_max_size;
+
+        struct msghdr& msg = batch.m_msgs[i].msg_hdr;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &batch.m_addrs[i];
+        msg.msg_namelen = sizeof(batch.m_addrs[i]);
+        msg.msg_iov = &batch.m_iovecs[i];
+        msg.msg_iovlen = 1;
+        msg.msg_control = &batch.m_control[i * BATCH_CONTROL_SIZE];
+        msg.msg_controllen = BATCH_CONTROL_SIZE;
+        batch.m_msgs[i].msg_len = 0;
+    }
+
+    const int ret = recvmmsg(m_sock, batch.m_msgs.data(), max_packets, MSG_DONTWAIT, nullptr);
+    if (ret == SOCKET_ERROR) {
+#if EAGAIN == EWOULDBLOCK
+        if (errno == EAGAIN)
+#else
+        if (errno == EAGAIN or errno == EWOULDBLOCK)
+#endif
+        {
+            return 0;
+        }
+        throw runtime_error(string("Can't receive data: ") + strerror(errno));
+    }
+
+    struct in_addr mcast_addr;
+    const bool filter_mcast = not m_multicast_source.empty() and
+        inet_pton(AF_INET, m_multicast_source.c_str(), &mcast_addr) == 1;
+
+    for (size_t i = 0; i < (size_t)ret; i++) {
+        struct msghdr& msg = batch.m_msgs[i].msg_hdr;
+
+        struct in_pktinfo *pktinfo = nullptr;
+        std::optional<chrono::system_clock::time_point> rx_timestamp;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
+                pktinfo = (struct in_pktinfo *)CMSG_DATA(cmsg);
+            }
+            else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                rx_timestamp = chrono::system_clock::time_point(
+                        chrono::duration_cast<chrono::system_clock::duration>(
+                            chrono::seconds(ts.tv_sec) + chrono::nanoseconds(ts.tv_nsec)));
+            }
+        }
+
+        if (filter_mcast and pktinfo and
+                pktinfo->ipi_addr.s_addr != mcast_addr.s_addr) {
+            // Ignore packet for different multicast group
+            continue;
+        }
+
+        // Keep the accepted packets at the beginning of the batch
+        auto& packet = batch.packets[batch.num_packets];
+        if (batch.num_packets != i) {
+            swap(packet.buffer, batch.packets[i].buffer);
+        }
+        packet.buffer.resize(batch.m_msgs[i].msg_len);
+        memcpy(&packet.address.addr, &batch.m_addrs[i], sizeof(batch.m_addrs[i]));
+        packet.rx_timestamp = rx_timestamp;
+        batch.num_packets++;
+    }
+
+    return batch.num_packets;
+}
+
+int UDPSocket::setReceiveBufferSize(int size)
+{
+    if (setsockopt(m_sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) == SOCKET_ERROR) {
+        throw runtime_error(string("Can't set receive buffer size: ") + strerror(errno));
+    }
+
+    int actual_size = 0;
+    socklen_t len = sizeof(actual_size);
+    if (getsockopt(m_sock, SOL_SOCKET, SO_RCVBUF, &actual_size, &len) == SOCKET_ERROR) {
+        throw runtime_error(string("Can't read receive buffer size: ") + strerror(errno));
+    }
+
+    // Linux doubles the value to account for its bookkeeping overhead
+    return actual_size / 2;
+}
+
+void UDPSocket::enableReceiveTimestamps()
+{
+    int enable = 1;
+    if (setsockopt(m_sock, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == SOCKET_ERROR) {
+        throw runtime_error(string("Can't enable receive timestamps: ") + strerror(errno));
+    }
+}
+
 void UDPSocket::send(UDPPacket& packet)
 {
     const int ret = sendto(m_sock, packet.buffer.data(), packet.buffer.size(), 0,
@@ -407,7 +527,8 @@ int UDPSocket::getPort() const
     return m_port;
 }
 
-void UDPReceiver::add_receive_port(int port, const string& bindto, const string& mcastaddr) {
+int UDPReceiver::add_receive_port(int port, const string& bindto,
+        const string& mcastaddr, int rcvbuf_size) {
     UDPSocket sock;
 
     if (IN_MULTICAST(ntohl(inet_addr(mcastaddr.c_str())))) {
@@ -417,7 +538,16 @@ void UDPReceiver::add_receive_port(int port, const string& bindto, const string&
         sock.reinit(port, bindto);
     }
 
+    int actual_size = 0;
+    if (rcvbuf_size > 0) {
+        actual_size = sock.setReceiveBufferSize(rcvbuf_size);
+    }
+
+    sock.enableReceiveTimestamps();
+
     m_sockets.push_back(std::move(sock));
+    m_batches.emplace_back(BATCH_SIZE, 2048);
+    return actual_size;
 }
 
 vector<UDPReceiver::ReceivedPacket> UDPReceiver::receive(int timeout_ms)
@@ -465,6 +595,49 @@ vector<UDPReceiver::ReceivedPacket> UDPReceiver::receive(int timeout_ms)
     }
 }
 
+size_t UDPReceiver::receive_batch(int timeout_ms, const packet_handler& handler)
+{
+    constexpr size_t MAX_FDS = 64;
+    struct pollfd fds[MAX_FDS];
+    if (m_sockets.size() > MAX_FDS) {
+        throw std::runtime_error("UDPReceiver only supports up to 64 ports");
+    }
+
+    for (size_t i = 0; i < m_sockets.size(); i++) {
+        fds[i].fd = m_sockets[i].getNativeSocket();
+        fds[i].events = POLLIN;
+    }
+
+    int retval = poll(fds, m_sockets.size(), timeout_ms);
+
+    if (retval == -1 and errno == EINTR) {
+        throw Interrupted();
+    }
+    else if (retval == -1) {
+        std::string errstr(strerror(errno));
+        throw std::runtime_error("UDP receive with poll() error: " + errstr);
+    }
+    else if (retval > 0) {
+        size_t num_received = 0;
+
+        for (size_t i = 0; i < m_sockets.size(); i++) {
+            if (fds[i].revents & POLLIN) {
+                auto& batch = m_batches[i];
+                m_sockets[i].receive_batch(batch);
+                for (size_t j = 0; j < batch.num_packets; j++) {
+                    handler(batch.packets[j], m_sockets[i].getPort(), i);
+                }
+                num_received += batch.num_packets;
+            }
+        }
+
+        return num_received;
+    }
+    else {
+        throw Timeout();
+    }
+}
+
 
 TCPSocket::TCPSocket()
 {
@@ -32,6 +32,8 @@
 #include <cstdlib>
 #include <atomic>
 #include <chrono>
+#include <deque>
+#include <functional>
 #include <list>
 #include <memory>
 #include <optional>
@@ -76,6 +78,36 @@ class UDPPacket
 
         std::vector<uint8_t> buffer;
         InetAddress address;
+
+        // Time at which the kernel received the packet, only set on
+        // sockets where receive timestamps are enabled.
+        std::optional<std::chrono::system_clock::time_point> rx_timestamp;
+};
+
+/** Preallocated packets for UDPSocket::receive_batch(). The packet buffers
+ *  and the headers given to the kernel are allocated once, and reused for
+ *  every call.
+ */
+class UDPPacketBatch
+{
+    public:
+        UDPPacketBatch(size_t max_packets, size_t max_size);
+        UDPPacketBatch(const UDPPacketBatch& other) = delete;
+        UDPPacketBatch& operator=(const UDPPacketBatch& other) = delete;
+        UDPPacketBatch(UDPPacketBatch&& other) = default;
+        UDPPacketBatch& operator=(UDPPacketBatch&& other) = default;
+
+        // The first num_packets entries contain the received packets
+        std::vector<UDPPacket> packets;
+        size_t num_packets = 0;
+
+    private:
+        friend class UDPSocket;
+        size_t m_max_size;
+        std::vector<struct mmsghdr> m_msgs;
+        std::vector<struct iovec> m_iovecs;
+        std::vector<struct sockaddr_in> m_addrs;
+        std::vector<uint8_t> m_control;
 };
 
 /**
@@ -120,6 +152,26 @@ class UDPSocket
         void send(const std::vector<uint8_t>& data, InetAddress destination);
         void send(const std::string& data, InetAddress destination);
         UDPPacket receive(size_t max_size);
+
+        /** Receive as many packets as fit into the batch with a single
+         *  recvmmsg() call, without blocking. Packets for a different
+         *  multicast group are skipped. Returns the number of packets
+         *  received, also available in batch.num_packets.
+         *  Throws a runtime_error on error.
+         */
+        size_t receive_batch(UDPPacketBatch& batch);
+
+        /** Set the size of the kernel receive buffer (SO_RCVBUF) in bytes,
+         *  and return the size actually in use, which the kernel limits
+         *  to net.core.rmem_max.
+         *  Throws a runtime_error on error.
+         */
+        int setReceiveBufferSize(int size);
+
+        /** Ask the kernel to timestamp received packets (SO_TIMESTAMPNS).
+         *  The timestamps are only read by receive_batch().
+         */
+        void enableReceiveTimestamps(void);
         void setMulticastSource(const char* source_addr);
         void setMulticastTTL(int ttl);
 
@@ -144,7 +196,11 @@ class UDPSocket
 /* UDP packet receiver supporting receiving from several ports at once */
 class UDPReceiver {
     public:
-        void add_receive_port(int port, const std::string& bindto, const std::string& mcastaddr);
+        /* Open a socket on the given port. If rcvbuf_size is not zero, set the
+         * size of its kernel receive buffer, and return the size the kernel
+         * actually granted. Returns 0 otherwise. */
+        int add_receive_port(int port, const std::string& bindto,
+                const std::string& mcastaddr, int rcvbuf_size = 0);
 
         struct ReceivedPacket {
             std::vector<uint8_t> packetdata;
@@ -159,10 +215,25 @@ class UDPReceiver {
          * on error. */
         std::vector<ReceivedPacket> receive(int timeout_ms);
 
+        /* Called for every packet received by receive_batch(). The packet is
+         * only valid until the handler returns. The sockets are numbered
+         * in the order of the add_receive_port() calls. */
+        using packet_handler = std::function<void(const UDPPacket& packet,
+                int port_received_on, size_t socket_index)>;
+
+        /* Like receive(), but reads up to BATCH_SIZE packets from every
+         * readable socket with one system call, into buffers that are reused
+         * from one call to the next. The packets carry their kernel receive
+         * timestamp. Returns the number of packets given to the handler. */
+        size_t receive_batch(int timeout_ms, const packet_handler& handler);
+
+        static constexpr size_t BATCH_SIZE = 32;
+
     private:
         void m_run(void);
 
         std::vector<UDPSocket> m_sockets;
+        std::vector<UDPPacketBatch> m_batches;
 };
 
 class TCPSocket {
@@ -235,6 +306,10 @@ class TCPClient {
          * Throws a runtime_error on error */
         ssize_t recv(void *buffer, size_t length, int flags, int timeout_ms);
 
+        /* The socket to wait on when polling several clients at once. It
+         * changes on every reconnection. */
+        SOCKET get_sockfd(void) const { return m_sock.get_sockfd(); }
+
     private:
         void reconnect(void);
         TCPSocket m_sock;
@@ -31,7 +31,8 @@
 #include <functional>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
+#include <vector>
+#include <algorithm>
 #include <utility>
 #include <cassert>
 
@@ -41,6 +42,10 @@
  *
  * The queue can make the consumer block until an element
  * is available, or a wakeup requested.
+ *
+ * The elements are kept in a ring buffer that only grows, so that
+ * passing elements through the queue does not allocate memory once it
+ * has reached its working size. T must be default constructible.
  */
 
 /* Class thrown by blocking pop to tell the consumer
@@ -198,7 +203,7 @@ public:
             return false;
         }
 
-        popped_value = the_queue.front();
+        popped_value = std::move(the_queue.front());
         the_queue.pop_front();
 
         lock.unlock();
@@ -233,14 +238,60 @@ public:
     {
         std::vector<R> result;
         std::unique_lock<std::mutex> lock(the_mutex);
-        for (const T& elem : the_queue) {
-            result.push_back(func(elem));
+        for (size_t i = 0; i < the_queue.size(); i++) {
+            result.push_back(func(the_queue[i]));
         }
         return result;
     }
 
 private:
-    std::deque<T> the_queue;
+    class ring_t {
+    public:
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        T& front() { return m_slots[m_head]; }
+        const T& operator[](size_t i) const { return m_slots[index(i)]; }
+
+        void push_back(const T& val) {
+            grow_if_full();
+            m_slots[index(m_size)] = val;
+            m_size++;
+        }
+
+        void emplace_back(T&& val) {
+            grow_if_full();
+            m_slots[index(m_size)] = std::move(val);
+            m_size++;
+        }
+
+        void pop_front() {
+            // Release what the element holds, but keep the slot
+            m_slots[m_head] = T();
+            m_head = index(1);
+            m_size--;
+        }
+
+    private:
+        size_t index(size_t i) const { return (m_head + i) % m_slots.size(); }
+
+        void grow_if_full() {
+            if (m_size == m_slots.size()) {
+                std::vector<T> slots(std::max<size_t>(2 * m_slots.size(), 8));
+                for (size_t i = 0; i < m_size; i++) {
+                    slots[i] = std::move(m_slots[index(i)]);
+                }
+                m_slots.swap(slots);
+                m_head = 0;
+            }
+        }
+
+        std::vector<T> m_slots;
+        size_t m_head = 0;
+        size_t m_size = 0;
+    };
+
+    ring_t the_queue;
     mutable std::mutex the_mutex;
     std::condition_variable the_rx_notification;
     std::condition_variable the_tx_notification;
@@ -25,8 +25,14 @@
 #    include <netinet/in.h>
 #endif
 #include <stdio.h>
+#include <stddef.h>
 #include <fcntl.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#  define CRC16_HAVE_PCLMUL 1
+#  include <immintrin.h>
+#endif
+
 //#define CCITT       0x1021
 
 uint8_t crc8tab[256] = {
@@ -168,6 +174,11 @@ uint32_t crc32tab[256] = {
     0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
 };
 
+static uint16_t crc16_bytewise(uint16_t l_crc, const uint8_t *data, size_t l_nb);
+
+/* Selected at startup, according to the CPU features */
+static uint16_t (*crc16_impl)(uint16_t, const uint8_t*, size_t) = crc16_bytewise;
+
 // This function can be used to create a new table with a different polynom
 void init_crc8tab(uint8_t l_code, uint8_t l_init)
 {
@@ -209,6 +220,9 @@ void init_crc16tab(uint16_t l_code, uint16_t l_init)
         crc ^= 0xff00;
         crc16tab[i] = crc;
     }
+
+    // The faster implementations are only valid for the default table
+    crc16_impl = crc16_bytewise;
 }
 
 
@@ -244,9 +258,8 @@ uint8_t crc8(uint8_t l_crc, const void *lp_data, unsigned l_nb)
 }
 
 
-uint16_t crc16(uint16_t l_crc, const void *lp_data, unsigned l_nb)
+static uint16_t crc16_bytewise(uint16_t l_crc, const uint8_t *data, size_t l_nb)
 {
-    const uint8_t* data = (const uint8_t*)lp_data;
     while (l_nb--) {
         l_crc =
             (l_crc << 8) ^ crc16tab[(l_crc >> 8) ^ *(data++)];
@@ -254,6 +267,157 @@ uint16_t crc16(uint16_t l_crc, const void *lp_data, unsigned l_nb)
     return (l_crc);
 }
 
+/* Slicing-by-8: crc16slice[k][b] is the CRC of byte b followed by k zero
+ * bytes, which lets us process eight bytes with independent lookups. */
+static uint16_t crc16slice[8][256];
+
+static void init_crc16slice(void)
+{
+    unsigned k, b;
+    for (b = 0; b < 256; ++b) {
+        crc16slice[0][b] = crc16tab[b];
+    }
+    for (k = 1; k < 8; ++k) {
+        for (b = 0; b < 256; ++b) {
+            const uint16_t prev = crc16slice[k-1][b];
+            crc16slice[k][b] = (uint16_t)(prev << 8) ^ crc16tab[prev >> 8];
+        }
+    }
+}
+
+static uint16_t crc16_slice8(uint16_t l_crc, const uint8_t *data, size_t l_nb)
+{
+    while (l_nb >= 8) {
+        l_crc = crc16slice[7][data[0] ^ (l_crc >> 8)] ^
+                crc16slice[6][data[1] ^ (l_crc & 0xff)] ^
+                crc16slice[5][data[2]] ^
+                crc16slice[4][data[3]] ^
+                crc16slice[3][data[4]] ^
+                crc16slice[2][data[5]] ^
+                crc16slice[1][data[6]] ^
+                crc16slice[0][data[7]];
+        data += 8;
+        l_nb -= 8;
+    }
+    return crc16_bytewise(l_crc, data, l_nb);
+}
+
+#if CRC16_HAVE_PCLMUL
+/* Carry-less multiplication CRC, see Intel's "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ Instruction".
+ *
+ * The bytes are loaded in reverse order, so that bit i of a 128-bit lane is
+ * the coefficient of x^i of the message polynomial. A lane X followed by d
+ * bits of message is congruent to X * x^d, which we fold into the next lane
+ * by multiplying both 64-bit halves by x^(d+64) mod P and x^d mod P. The
+ * remaining lane is reduced with the tables.
+ */
+#define CRC16_POLY 0x1021
+
+/* x^(d+64) mod P in the high half, x^d mod P in the low half */
+static __m128i crc16_fold512, crc16_fold384, crc16_fold256, crc16_fold128;
+
+static uint64_t crc16_xpow_mod(unsigned n)
+{
+    uint32_t r = 1;
+    while (n--) {
+        r <<= 1;
+        if (r & 0x10000) {
+            r ^= 0x10000 | CRC16_POLY;
+        }
+    }
+    return r;
+}
+
+__attribute__((target("pclmul,ssse3")))
+static __m128i crc16_fold_constant(unsigned d)
+{
+    return _mm_set_epi64x(
+            (long long)crc16_xpow_mod(d + 64),
+            (long long)crc16_xpow_mod(d));
+}
+
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i crc16_fold(__m128i x, __m128i k)
+{
+    return _mm_xor_si128(
+            _mm_clmulepi64_si128(x, k, 0x11),
+            _mm_clmulepi64_si128(x, k, 0x00));
+}
+
+__attribute__((target("pclmul,ssse3")))
+static uint16_t crc16_pclmul(uint16_t l_crc, const uint8_t *data, size_t l_nb)
+{
+    const __m128i bswap = _mm_set_epi8(
+            0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i x0, x1, x2, x3;
+    uint8_t last[16];
+
+    if (l_nb < 64) {
+        return crc16_slice8(l_crc, data, l_nb);
+    }
+
+#define CRC16_LOAD(p) _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p)), bswap)
+    x0 = CRC16_LOAD(data);
+    x1 = CRC16_LOAD(data + 16);
+    x2 = CRC16_LOAD(data + 32);
+    x3 = CRC16_LOAD(data + 48);
+    data += 64;
+    l_nb -= 64;
+
+    /* The initial value is added to the first 16 bits of the message */
+    x0 = _mm_xor_si128(x0, _mm_slli_si128(_mm_cvtsi32_si128(l_crc), 14));
+
+    while (l_nb >= 64) {
+        x0 = _mm_xor_si128(crc16_fold(x0, crc16_fold512), CRC16_LOAD(data));
+        x1 = _mm_xor_si128(crc16_fold(x1, crc16_fold512), CRC16_LOAD(data + 16));
+        x2 = _mm_xor_si128(crc16_fold(x2, crc16_fold512), CRC16_LOAD(data + 32));
+        x3 = _mm_xor_si128(crc16_fold(x3, crc16_fold512), CRC16_LOAD(data + 48));
+        data += 64;
+        l_nb -= 64;
+    }
+
+    x0 = _mm_xor_si128(
+            _mm_xor_si128(crc16_fold(x0, crc16_fold384), crc16_fold(x1, crc16_fold256)),
+            _mm_xor_si128(crc16_fold(x2, crc16_fold128), x3));
+
+    while (l_nb >= 16) {
+        x0 = _mm_xor_si128(crc16_fold(x0, crc16_fold128), CRC16_LOAD(data));
+        data += 16;
+        l_nb -= 16;
+    }
+#undef CRC16_LOAD
+
+    _mm_storeu_si128((__m128i*)last, _mm_shuffle_epi8(x0, bswap));
+    l_crc = crc16_slice8(0, last, sizeof(last));
+
+    return crc16_slice8(l_crc, data, l_nb);
+}
+#endif
+
+__attribute__((constructor))
+static void init_crc16_impl(void)
+{
+    init_crc16slice();
+    crc16_impl = crc16_slice8;
+
+#if CRC16_HAVE_PCLMUL
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")) {
+        crc16_fold512 = crc16_fold_constant(512);
+        crc16_fold384 = crc16_fold_constant(384);
+        crc16_fold256 = crc16_fold_constant(256);
+        crc16_fold128 = crc16_fold_constant(128);
+        crc16_impl = crc16_pclmul;
+    }
+#endif
+}
+
+uint16_t crc16(uint16_t l_crc, const void *lp_data, unsigned l_nb)
+{
+    return crc16_impl(l_crc, (const uint8_t*)lp_data, l_nb);
+}
+
 
 uint32_t crc32(uint32_t l_crc, const void *lp_data, unsigned l_nb)
 {
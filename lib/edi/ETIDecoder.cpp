@@ -67,9 +67,14 @@ void ETIDecoder::setMaxDelay(int num_af_packets)
     m_dispatcher.setMaxDelay(num_af_packets);
 }
 
+void ETIDecoder::setRedundantSources(bool enable)
+{
+    m_dispatcher.setRedundantSources(enable);
+}
+
 #define AFPACKET_HEADER_LEN 10 // includes SYNC
 
-bool ETIDecoder::decode_starptr(const std::vector<uint8_t>& value, const tag_name_t& /*n*/)
+bool ETIDecoder::decode_starptr(const byte_view& value, const tag_name_t& /*n*/)
 {
     if (value.size() != 0x40 / 8) {
         etiLog.log(warn, "Incorrect length %02lx for *PTR", value.size());
@@ -89,7 +94,7 @@ bool ETIDecoder::decode_starptr(const std::vector<uint8_t>& value, const tag_nam
     return true;
 }
 
-bool ETIDecoder::decode_deti(const std::vector<uint8_t>& value, const tag_name_t& /*n*/)
+bool ETIDecoder::decode_deti(const byte_view& value, const tag_name_t& /*n*/)
 {
     /*
     uint16_t detiHeader = fct | (fcth << 8) | (rfudf << 13) | (ficf << 14) | (atstf << 15);
@@ -168,13 +173,8 @@ bool ETIDecoder::decode_deti(const std::vector<uint8_t>& value, const tag_name_t
 
 
     if (fc.ficf) {
-        vector<uint8_t> fic(fic_length);
-        copy(   value.begin() + i,
-                value.begin() + i + fic_length,
-                fic.begin());
+        m_data_collector.update_fic(value.sub(i, fic_length));
         i += fic_length;
-
-        m_data_collector.update_fic(std::move(fic));
     }
 
     if (rfudf) {
@@ -195,8 +195,13 @@ bool ETIDecoder::decode_deti(const std::vector<uint8_t>& value, const tag_name_t
     return true;
 }
 
-bool ETIDecoder::decode_estn(const std::vector<uint8_t>& value, const tag_name_t& name)
+bool ETIDecoder::decode_estn(const byte_view& value, const tag_name_t& name)
 {
+    if (value.size() < 3) {
+        etiLog.level(warn) << "EDI: ESTn tag too short";
+        return false;
+    }
+
     uint32_t sstc = read_24b(value.begin());
 
     eti_stc_data stc;
@@ -211,29 +216,28 @@ bool ETIDecoder::decode_estn(const std::vector<uint8_t>& value, const tag_name_t
         etiLog.level(warn) << "EDI: rfa field in ESTn tag non-null";
     }
 
-    copy(   value.begin() + 3,
-            value.end(),
-            back_inserter(stc.mst));
+    stc.mst = value.sub(3, value.size() - 3);
 
-    m_data_collector.add_subchannel(std::move(stc));
+    m_data_collector.add_subchannel(stc);
 
     return true;
 }
 
-bool ETIDecoder::decode_stardmy(const std::vector<uint8_t>&, const tag_name_t&)
+bool ETIDecoder::decode_stardmy(const byte_view&, const tag_name_t&)
 {
     return true;
 }
 
-bool ETIDecoder::decode_afpacket(std::vector<uint8_t>&& value)
+bool ETIDecoder::decode_afpacket(const byte_view& value)
 {
-    m_received_tagpacket.afpacket = std::move(value);
+    m_received_tagpacket.afpacket = value;
     return true;
 }
 
 void ETIDecoder::packet_completed()
 {
     m_received_tagpacket.seq = m_dispatcher.get_seq_info();
+    m_received_tagpacket.rx_timestamp = m_dispatcher.get_rx_timestamp();
 
     ReceivedTagPacket tp;
     swap(tp, m_received_tagpacket);
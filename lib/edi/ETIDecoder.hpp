@@ -45,22 +45,27 @@ struct eti_fc_data {
     uint8_t fct(void) const { return dlfc % 250; }
 };
 
-// Information for a subchannel available in EDI
+// Information for a subchannel available in EDI. The MST refers to the
+// received AF packet, and is only valid during the add_subchannel call.
 struct eti_stc_data {
     uint8_t stream_index;
     uint8_t scid;
     uint16_t sad;
     uint8_t tpl;
-    std::vector<uint8_t> mst;
+    byte_view mst;
 
     // Return the length of the MST in multiples of 64 bits
     uint16_t stl(void) const { return mst.size() / 8; }
 };
 
 struct ReceivedTagPacket {
-    std::vector<uint8_t> afpacket;
+    // Only valid during the assemble call
+    byte_view afpacket;
     frame_timestamp_t timestamp;
     seq_info_t seq;
+
+    // Time at which the packet completing this AF packet was received
+    std::optional<std::chrono::system_clock::time_point> rx_timestamp;
 };
 
 
@@ -80,7 +85,8 @@ class ETIDataCollector {
         // Update the data for the frame characterisation
         virtual void update_fc_data(const eti_fc_data& fc_data) = 0;
 
-        virtual void update_fic(std::vector<uint8_t>&& fic) = 0;
+        // The FIC is only valid during the call
+        virtual void update_fic(const byte_view& fic) = 0;
 
         virtual void update_err(uint8_t err) = 0;
 
@@ -92,7 +98,7 @@ class ETIDataCollector {
 
         virtual void update_rfu(uint16_t rfu) = 0;
 
-        virtual void add_subchannel(eti_stc_data&& stc) = 0;
+        virtual void add_subchannel(const eti_stc_data& stc) = 0;
 
         // Tell the consumer that the AFPacket is complete, and include
         // the raw received TAGs
@@ -127,13 +133,18 @@ class ETIDecoder {
          */
         void setMaxDelay(int num_af_packets);
 
+        /* Drop the copies of packets received over redundant paths,
+         * see TagDispatcher::setRedundantSources.
+         */
+        void setRedundantSources(bool enable);
+
     private:
-        bool decode_starptr(const std::vector<uint8_t>& value, const tag_name_t& n);
-        bool decode_deti(const std::vector<uint8_t>& value, const tag_name_t& n);
-        bool decode_estn(const std::vector<uint8_t>& value, const tag_name_t& n);
-        bool decode_stardmy(const std::vector<uint8_t>& value, const tag_name_t& n);
+        bool decode_starptr(const byte_view& value, const tag_name_t& n);
+        bool decode_deti(const byte_view& value, const tag_name_t& n);
+        bool decode_estn(const byte_view& value, const tag_name_t& n);
+        bool decode_stardmy(const byte_view& value, const tag_name_t& n);
 
-        bool decode_afpacket(std::vector<uint8_t>&& value);
+        bool decode_afpacket(const byte_view& value);
 
         void packet_completed();
 
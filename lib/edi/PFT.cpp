@@ -27,6 +27,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <algorithm>
+#include <map>
 #include "crc.h"
 #include "PFT.hpp"
 #include "Log.h"
@@ -35,6 +36,14 @@ extern "C" {
 #include "fec/fec.h"
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define PFT_SSSE3_KERNEL 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define PFT_NEON_KERNEL 1
+#endif
+
 namespace EdiDecoder {
 namespace PFT {
 
@@ -42,6 +51,13 @@ using namespace std;
 
 const findex_t NUM_AFBUILDERS_TO_KEEP = 10;
 
+// Number of Pseq worth of late fragments in a row, about one second, after
+// which we assume the sender restarted.
+const size_t NUM_LATE_PSEQ_BEFORE_RESTART = 40;
+
+// Upper bound for Fcount * Plen of the fragments we accept
+const size_t MAX_AF_BUILDER_SIZE = 1 << 22;
+
 static bool checkCRC(const uint8_t *buf, size_t size)
 {
     const uint16_t crc_from_packet = read_16b(buf + size - 2);
@@ -57,6 +73,22 @@ class FECDecoder {
         FECDecoder() {
             m_rs_handler = init_rs_char(
                     symsize, gfPoly, firstRoot, primElem, nroots, pad);
+            init_syndrome_tables();
+
+#if defined(PFT_SSSE3_KERNEL)
+            if (__builtin_cpu_supports("ssse3")) {
+                m_kernel = kernel_t::SSSE3;
+            }
+#elif defined(PFT_NEON_KERNEL)
+            // Advanced SIMD is mandatory on AArch64
+            m_kernel = kernel_t::NEON;
+#endif
+
+            if (m_kernel != kernel_t::Scalar and not check_kernel()) {
+                etiLog.level(error) << "PFT: SIMD syndrome computation does "
+                    "not match libfec, using the scalar version";
+                m_kernel = kernel_t::Scalar;
+            }
         }
         FECDecoder(const FECDecoder& other) = delete;
         FECDecoder& operator=(const FECDecoder& other) = delete;
@@ -69,7 +101,7 @@ class FECDecoder {
         // Known positions of erasures should be given in eras_pos to
         // improve decoding probability. After calling this function
         // eras_pos will contain the positions of the corrected errors.
-        int decode(vector<uint8_t> &data, vector<int> &eras_pos) {
+        int decode(vector<uint8_t> &data, vector<int> &eras_pos) const {
             assert(data.size() == N);
             const size_t no_eras = eras_pos.size();
 
@@ -84,36 +116,259 @@ class FECDecoder {
 
         // return -1 in case of failure, non-negative value if errors
         // were corrected. No known erasures.
-        int decode(vector<uint8_t> &data) {
+        int decode(vector<uint8_t> &data) const {
             assert(data.size() == N);
             int num_err = decode_rs_char(m_rs_handler, data.data(), nullptr, 0);
             return num_err;
         }
 
+        // Return true if all syndromes of the shortened codeword made of
+        // data_len data bytes and the parity bytes are zero, i.e. if the
+        // chunk was received without errors and needs no decoding.
+        bool is_codeword(const uint8_t *data, size_t data_len, const uint8_t *parity) const;
+
+        // Position in the padded 255-byte chunk of byte ix of a shortened
+        // codeword with data_len data bytes
+        static int padded_position(size_t ix, size_t data_len) {
+            return (int)(ix < data_len ? ix : ix + (K - data_len));
+        }
+
+        static constexpr size_t N = 255;
+        static constexpr size_t K = 207;
+
     private:
+        void init_syndrome_tables();
+
+        // Check the selected syndrome kernel against the scalar one on
+        // codewords encoded by libfec, with and without errors.
+        bool check_kernel() const;
+
+        bool is_codeword_scalar(const uint8_t *data, size_t data_len, const uint8_t *parity) const;
+#if defined(PFT_SSSE3_KERNEL)
+        bool is_codeword_ssse3(const uint8_t *data, size_t data_len, const uint8_t *parity) const;
+#elif defined(PFT_NEON_KERNEL)
+        bool is_codeword_neon(const uint8_t *data, size_t data_len, const uint8_t *parity) const;
+#endif
+
+        enum class kernel_t { Scalar, SSSE3, NEON };
+        kernel_t m_kernel = kernel_t::Scalar;
+
         void* m_rs_handler;
 
-        const int firstRoot = 1; // Discovered by analysing EDI dump
-        const int gfPoly = 0x11d;
+        static constexpr int firstRoot = 1; // Discovered by analysing EDI dump
+        static constexpr int gfPoly = 0x11d;
 
         // The encoding has to be 255, 207 always, because the chunk has to
         // be padded at the end, and not at the beginning as libfec would
         // do
-        const size_t N = 255;
-        const size_t K = 207;
-        const int primElem = 1;
-        const int symsize = 8;
-        const size_t nroots = N - K; // For EDI PFT, this must be 48
-        const size_t pad = ((1 << symsize) - 1) - N; // is 255-N
-
+        static constexpr int primElem = 1;
+        static constexpr int symsize = 8;
+        static constexpr size_t nroots = N - K; // For EDI PFT, this must be 48
+        static constexpr size_t pad = ((1 << symsize) - 1) - N; // is 255-N
+
+        /* The syndromes are S_i = sum_p c[p] alpha^((firstRoot+i)*(254-p)),
+         * where c[p] is byte p of the padded chunk. They are accumulated
+         * over the bytes of the chunk, the products of one byte with the
+         * 48 powers of alpha being computed with a table lookup per nibble
+         * of the powers:
+         *   d * v = d * (v & 0x0F) + d * (v & 0xF0)
+         * which can be done with 16-byte shuffles on SSSE3 and NEON. */
+
+        // m_powers[p][i] = alpha^((firstRoot+i)*(254-p))
+        alignas(16) uint8_t m_powers[N][nroots];
+
+        // m_mul_lo[d][x] = d * x, m_mul_hi[d][x] = d * (x << 4)
+        alignas(16) uint8_t m_mul_lo[256][16];
+        alignas(16) uint8_t m_mul_hi[256][16];
 };
 
-size_t Fragment::loadData(const std::vector<uint8_t> &buf)
+void FECDecoder::init_syndrome_tables()
+{
+    uint8_t gf_exp[255];
+    int gf_log[256];
+    int x = 1;
+    for (int i = 0; i < 255; i++) {
+        gf_exp[i] = (uint8_t)x;
+        gf_log[x] = i;
+        x <<= 1;
+        if (x & 0x100) {
+            x ^= gfPoly;
+        }
+    }
+
+    auto gf_mul = [&](int a, int b) -> uint8_t {
+        if (a == 0 or b == 0) {
+            return 0;
+        }
+        return gf_exp[(gf_log[a] + gf_log[b]) % 255];
+    };
+
+    for (size_t p = 0; p < N; p++) {
+        for (size_t i = 0; i < nroots; i++) {
+            const size_t e = ((firstRoot + i) * primElem * (N - 1 - p)) % 255;
+            m_powers[p][i] = gf_exp[e];
+        }
+    }
+
+    for (int d = 0; d < 256; d++) {
+        for (int n = 0; n < 16; n++) {
+            m_mul_lo[d][n] = gf_mul(d, n);
+            m_mul_hi[d][n] = gf_mul(d, n << 4);
+        }
+    }
+}
+
+bool FECDecoder::is_codeword(const uint8_t *data, size_t data_len, const uint8_t *parity) const
+{
+    assert(data_len <= K);
+
+    switch (m_kernel) {
+#if defined(PFT_SSSE3_KERNEL)
+        case kernel_t::SSSE3:
+            return is_codeword_ssse3(data, data_len, parity);
+#elif defined(PFT_NEON_KERNEL)
+        case kernel_t::NEON:
+            return is_codeword_neon(data, data_len, parity);
+#endif
+        default:
+            return is_codeword_scalar(data, data_len, parity);
+    }
+}
+
+bool FECDecoder::is_codeword_scalar(const uint8_t *data, size_t data_len, const uint8_t *parity) const
 {
-    return loadData(buf, 0);
+    uint8_t syndromes[nroots] = {};
+
+    auto accumulate = [&](uint8_t d, const uint8_t *powers) {
+        if (d == 0) {
+            return;
+        }
+        for (size_t i = 0; i < nroots; i++) {
+            syndromes[i] ^= m_mul_lo[d][powers[i] & 0x0F] ^ m_mul_hi[d][powers[i] >> 4];
+        }
+    };
+
+    // The padding bytes between data_len and K are zero
+    for (size_t p = 0; p < data_len; p++) {
+        accumulate(data[p], m_powers[p]);
+    }
+    for (size_t p = 0; p < nroots; p++) {
+        accumulate(parity[p], m_powers[K + p]);
+    }
+
+    uint8_t any = 0;
+    for (size_t i = 0; i < nroots; i++) {
+        any |= syndromes[i];
+    }
+    return any == 0;
 }
 
-size_t Fragment::loadData(const std::vector<uint8_t> &buf, int received_on_port)
+#if defined(PFT_SSSE3_KERNEL)
+// Add d * powers[i] to the three syndrome vectors s, with the products of
+// d with all nibbles in lo and hi
+__attribute__((target("ssse3")))
+static inline void gf_accumulate_ssse3(__m128i s[3],
+        const uint8_t *lo, const uint8_t *hi, const uint8_t *powers)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i vlo = _mm_load_si128((const __m128i*)lo);
+    const __m128i vhi = _mm_load_si128((const __m128i*)hi);
+    for (size_t j = 0; j < 3; j++) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(powers + 16 * j));
+        s[j] = _mm_xor_si128(s[j], _mm_xor_si128(
+                    _mm_shuffle_epi8(vlo, _mm_and_si128(v, mask)),
+                    _mm_shuffle_epi8(vhi, _mm_and_si128(_mm_srli_epi16(v, 4), mask))));
+    }
+}
+
+__attribute__((target("ssse3")))
+bool FECDecoder::is_codeword_ssse3(const uint8_t *data, size_t data_len, const uint8_t *parity) const
+{
+    static_assert(nroots == 48, "The syndrome computation works on three 16-byte vectors");
+
+    __m128i s[3] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+
+    // The padding bytes between data_len and K are zero
+    for (size_t p = 0; p < data_len; p++) {
+        gf_accumulate_ssse3(s, m_mul_lo[data[p]], m_mul_hi[data[p]], m_powers[p]);
+    }
+    for (size_t p = 0; p < nroots; p++) {
+        gf_accumulate_ssse3(s, m_mul_lo[parity[p]], m_mul_hi[parity[p]], m_powers[K + p]);
+    }
+
+    const __m128i any = _mm_or_si128(s[0], _mm_or_si128(s[1], s[2]));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) == 0xFFFF;
+}
+#elif defined(PFT_NEON_KERNEL)
+bool FECDecoder::is_codeword_neon(const uint8_t *data, size_t data_len, const uint8_t *parity) const
+{
+    static_assert(nroots == 48, "The syndrome computation works on three 16-byte vectors");
+
+    uint8x16_t s0 = vdupq_n_u8(0);
+    uint8x16_t s1 = vdupq_n_u8(0);
+    uint8x16_t s2 = vdupq_n_u8(0);
+    const uint8x16_t mask = vdupq_n_u8(0x0F);
+
+    auto accumulate = [&](uint8_t d, const uint8_t *powers) {
+        const uint8x16_t lo = vld1q_u8(m_mul_lo[d]);
+        const uint8x16_t hi = vld1q_u8(m_mul_hi[d]);
+        const uint8x16_t v0 = vld1q_u8(powers);
+        const uint8x16_t v1 = vld1q_u8(powers + 16);
+        const uint8x16_t v2 = vld1q_u8(powers + 32);
+        s0 = veorq_u8(s0, veorq_u8(vqtbl1q_u8(lo, vandq_u8(v0, mask)), vqtbl1q_u8(hi, vshrq_n_u8(v0, 4))));
+        s1 = veorq_u8(s1, veorq_u8(vqtbl1q_u8(lo, vandq_u8(v1, mask)), vqtbl1q_u8(hi, vshrq_n_u8(v1, 4))));
+        s2 = veorq_u8(s2, veorq_u8(vqtbl1q_u8(lo, vandq_u8(v2, mask)), vqtbl1q_u8(hi, vshrq_n_u8(v2, 4))));
+    };
+
+    // The padding bytes between data_len and K are zero
+    for (size_t p = 0; p < data_len; p++) {
+        accumulate(data[p], m_powers[p]);
+    }
+    for (size_t p = 0; p < nroots; p++) {
+        accumulate(parity[p], m_powers[K + p]);
+    }
+
+    return vmaxvq_u8(vorrq_u8(s0, vorrq_u8(s1, s2))) == 0;
+}
+#endif
+
+bool FECDecoder::check_kernel() const
+{
+    uint8_t chunk[K];
+    uint8_t parity[nroots];
+    uint32_t lcg = 1;
+
+    for (const size_t data_len : {K, (size_t)100, (size_t)1}) {
+        for (size_t i = 0; i < K; i++) {
+            lcg = lcg * 1103515245 + 12345;
+            chunk[i] = i < data_len ? (uint8_t)(lcg >> 16) : 0;
+        }
+        encode_rs_char(m_rs_handler, chunk, parity);
+
+        if (not is_codeword(chunk, data_len, parity) or
+                not is_codeword_scalar(chunk, data_len, parity)) {
+            return false;
+        }
+
+        // Single byte errors in the data and in the parity
+        for (const size_t pos : {(size_t)0, data_len - 1, K + 7}) {
+            uint8_t& b = pos < K ? chunk[pos] : parity[pos - K];
+            for (const uint8_t e : {0x01, 0x10, 0xA5}) {
+                b ^= e;
+                const bool ok = is_codeword(chunk, data_len, parity);
+                const bool ok_scalar = is_codeword_scalar(chunk, data_len, parity);
+                b ^= e;
+                if (ok or ok_scalar) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t Fragment::loadData(const byte_view& buf, int received_on_port)
 {
     const size_t header_len = 14;
     if (buf.size() < header_len) {
@@ -186,11 +441,9 @@ size_t Fragment::loadData(const std::vector<uint8_t> &buf, int received_on_port)
     }
 #endif
 
-    _payload.clear();
+    _payload = byte_view();
     if (_valid) {
-        copy( buf.begin()+index,
-                buf.begin()+index+_Plen,
-                back_inserter(_payload));
+        _payload = buf.sub(index, _Plen);
         index += _Plen;
     }
 
@@ -198,15 +451,46 @@ size_t Fragment::loadData(const std::vector<uint8_t> &buf, int received_on_port)
 }
 
 
+
 AFBuilder::AFBuilder(pseq_t Pseq, findex_t Fcount, size_t lifetime)
+{
+    reset(Pseq, Fcount, lifetime);
+}
+
+void AFBuilder::reset(pseq_t Pseq, findex_t Fcount, size_t lifetime)
 {
     _Pseq = Pseq;
     _Fcount = Fcount;
     assert(lifetime > 0);
     lifeTime = lifetime;
+
+    discardFragments();
+}
+
+void AFBuilder::discardFragments()
+{
+    _slots.assign(_Fcount, slot_t());
+    _stride = 0;
+    _num_fragments = 0;
+    _af_packet.clear();
 }
 
-void AFBuilder::pushPFTFrag(const Fragment &frag)
+void AFBuilder::setStride(size_t stride)
+{
+    // Move the fragments already received to their new offset, starting
+    // with the last one so that none gets overwritten.
+    _slab.resize(_Fcount * stride);
+    if (_stride > 0) {
+        for (size_t j = _Fcount; j-- > 0; ) {
+            if (_slots[j].present) {
+                memmove(&_slab[j * stride], &_slab[j * _stride], _slots[j].len);
+            }
+        }
+    }
+    _stride = stride;
+}
+
+bool AFBuilder::pushPFTFrag(const Fragment &frag)
 {
     if (_Pseq != frag.Pseq()) {
         throw logic_error("Invalid PFT fragment Pseq");
@@ -215,24 +499,39 @@ void AFBuilder::pushPFTFrag(const Fragment &frag)
     if (_Fcount != frag.Fcount()) {
         etiLog.level(warn) << "Discarding fragment with invalid fcount";
     }
+    else if (frag.Findex() >= _Fcount) {
+        etiLog.level(warn) << "Discarding fragment with invalid findex";
+    }
     else {
         const auto Findex = frag.Findex();
-        const bool fragment_already_received = _fragments.count(Findex);
+        slot_t& slot = _slots[Findex];
 
-        if (not fragment_already_received) {
-            bool consistent = true;
-            if (_fragments.size() > 0) {
-                consistent = frag.checkConsistency(_fragments.cbegin()->second);
-            }
+        if (not slot.present) {
+            const bool consistent = (_num_fragments == 0) or frag.checkConsistency(_first);
 
             if (consistent) {
-                _fragments[Findex] = frag;
+                const auto& payload = frag.payload();
+                if (payload.size() > _stride) {
+                    setStride(payload.size());
+                }
+
+                copy(payload.begin(), payload.end(), _slab.data() + Findex * _stride);
+                slot.present = true;
+                slot.len = (uint16_t)payload.size();
+                slot.received_on_port = frag.received_on_port;
+
+                if (_num_fragments == 0) {
+                    _first = frag;
+                }
+                _num_fragments++;
+                return true;
             }
             else {
                 etiLog.level(warn) << "Discard fragment";
             }
         }
     }
+    return false;
 }
 
 bool Fragment::checkConsistency(const Fragment& other) const
@@ -261,55 +560,34 @@ bool Fragment::checkConsistency(const Fragment& other) const
 }
 
 
+
 AFBuilder::decode_attempt_result_t AFBuilder::canAttemptToDecode()
 {
-    if (_fragments.empty()) {
+    if (_num_fragments == 0) {
         return AFBuilder::decode_attempt_result_t::no;
     }
 
-    if (_fragments.size() == _Fcount) {
+    if (_num_fragments == _Fcount) {
         return AFBuilder::decode_attempt_result_t::yes;
     }
 
-    /* Check that all fragments are consistent */
-    const Fragment& first = _fragments.begin()->second;
-    if (not std::all_of(_fragments.begin(), _fragments.end(),
-            [&](const pair<int, Fragment>& pair) {
-                const Fragment& frag = pair.second;
-                return first.checkConsistency(frag) and _Pseq == frag.Pseq();
-            }) ) {
-        _fragments.clear();
-        throw runtime_error("Inconsistent PFT fragments");
-    }
-
-    // Calculate the minimum number of fragments necessary to apply FEC.
-    // This can't be done with the last fragment that may have a
-    // smaller size
+    // All fragments are consistent with the first one, which was checked
+    // when they were pushed. When FEC is used, they all have the same Plen.
     // ETSI TS 102 821 V1.4.1 ch 7.4.4
-    auto frag_it = _fragments.begin();
-    if (frag_it->second.Fcount() == _Fcount - 1) {
-        frag_it++;
+    if (_first.FEC()) {
+        const uint16_t _Plen = _first.Plen();
 
-        if (frag_it == _fragments.end()) {
+        /* max number of RS chunks that may have been sent */
+        const uint32_t _cmax = (_Fcount*_Plen) / (_first.RSk()+48);
+        if (_cmax == 0) {
             return AFBuilder::decode_attempt_result_t::no;
         }
-    }
-
-    const Fragment& frag = frag_it->second;
-
-    if ( frag.FEC() )
-    {
-        const uint16_t _Plen = frag.Plen();
-
-        /* max number of RS chunks that may have been sent */
-        const uint32_t _cmax = (_Fcount*_Plen) / (frag.RSk()+48);
-        assert(_cmax > 0);
 
         /* Receiving _rxmin fragments does not guarantee that decoding
          * will succeed! */
         const uint32_t _rxmin = _Fcount - (_cmax*48)/_Plen;
 
-        if (_fragments.size() >= _rxmin) {
+        if (_num_fragments >= _rxmin) {
             return AFBuilder::decode_attempt_result_t::maybe;
         }
     }
@@ -317,7 +595,7 @@ AFBuilder::decode_attempt_result_t AFBuilder::canAttemptToDecode()
     return AFBuilder::decode_attempt_result_t::no;
 }
 
-std::vector<uint8_t> AFBuilder::extractAF()
+const std::vector<uint8_t>& AFBuilder::extractAF()
 {
     if (not _af_packet.empty()) {
         return _af_packet;
@@ -326,125 +604,129 @@ std::vector<uint8_t> AFBuilder::extractAF()
     bool ok = false;
 
     if (canAttemptToDecode() != AFBuilder::decode_attempt_result_t::no) {
-        auto frag_it = _fragments.begin();
-        if (frag_it->second.Fcount() == _Fcount - 1) {
-            frag_it++;
-
-            if (frag_it == _fragments.end()) {
-                throw runtime_error("Invalid attempt at extracting AF");
-            }
-        }
-
-        const Fragment& ref_frag = frag_it->second;
-        const auto RSk = ref_frag.RSk();
-        const auto RSz = ref_frag.RSz();
-        const auto Plen = ref_frag.Plen();
-
-        if ( ref_frag.FEC() )
+        if ( _first.FEC() )
         {
-            const uint32_t cmax = (_Fcount*Plen) / (RSk+48);
-
-            // Keep track of erasures (missing fragments) for
-            // every chunk
-            map<int, vector<int> > erasures;
-
+            const size_t RSk = _first.RSk();
+            const size_t RSz = _first.RSz();
+            const size_t Plen = _first.Plen();
+            const size_t chunk_len = RSk + 48;
+            const uint32_t cmax = (_Fcount*Plen) / chunk_len;
 
             // Assemble fragments into a RS block, immediately
-            // deinterleaving it.
-            vector<uint8_t> rs_block(Plen * _Fcount);
+            // deinterleaving it. Missing fragments are filled with zeros.
+            _rs_block.resize(Plen * _Fcount);
             for (size_t j = 0; j < _Fcount; j++) {
-                const bool fragment_present = _fragments.count(j);
-                if (fragment_present) {
-                    const auto& fragment = _fragments.at(j).payload();
-
-                    if (j != _Fcount - 1 and fragment.size() != Plen) {
-                        _fragments.clear();
-                        throw runtime_error("Incorrect fragment length " +
-                                to_string(fragment.size()) + " " +
-                                to_string(Plen));
-                    }
+                const slot_t& slot = _slots[j];
+                const uint8_t *fragment = _slab.data() + j * _stride;
 
-                    if (j == _Fcount - 1 and fragment.size() > Plen) {
-                        _fragments.clear();
-                        throw runtime_error("Incorrect last fragment length " +
-                                to_string(fragment.size()) + " " +
-                                to_string(Plen));
-                    }
+                if (slot.present and j != _Fcount - 1 and slot.len != Plen) {
+                    discardFragments();
+                    throw runtime_error("Incorrect fragment length " +
+                            to_string(slot.len) + " " + to_string(Plen));
+                }
 
-                    size_t k = 0;
-                    for (; k < fragment.size(); k++) {
-                        rs_block[k * _Fcount + j] = fragment[k];
-                    }
+                if (slot.present and j == _Fcount - 1 and slot.len > Plen) {
+                    discardFragments();
+                    throw runtime_error("Incorrect last fragment length " +
+                            to_string(slot.len) + " " + to_string(Plen));
+                }
 
-                    for (; k < Plen; k++) {
-                        rs_block[k * _Fcount + j] = 0x00;
-                    }
+                const size_t len = slot.present ? slot.len : 0;
+                size_t k = 0;
+                for (; k < len; k++) {
+                    _rs_block[k * _Fcount + j] = fragment[k];
                 }
-                else {
-                    // fill with zeros if fragment is missing
-                    for (size_t k = 0; k < Plen; k++) {
-                        rs_block[k * _Fcount + j] = 0x00;
 
-                        const size_t chunk_ix = (k * _Fcount + j) / (RSk + 48);
-                        const size_t chunk_offset = (k * _Fcount + j) % (RSk + 48);
-                        erasures[chunk_ix].push_back(chunk_offset);
-                    }
+                for (; k < Plen; k++) {
+                    _rs_block[k * _Fcount + j] = 0x00;
                 }
             }
 
             // The RS block is a concatenation of chunks of RSk bytes + 48 parity
             // followed by RSz padding
 
-            FECDecoder fec;
+            // The tables are only computed once, and only read afterwards
+            static const FECDecoder fec;
+            _chunk.resize(FECDecoder::N);
+            _eras_pos.reserve(FECDecoder::N - FECDecoder::K);
+            _af_packet.reserve(cmax * RSk);
+
             for (size_t i = 0; i < cmax; i++) {
+                const uint8_t *block_begin = _rs_block.data() + chunk_len * i;
+
+                // Keep track of erasures (bytes of missing fragments)
+                _eras_pos.clear();
+                if (_num_fragments != _Fcount) {
+                    for (size_t offset = 0; offset < chunk_len; offset++) {
+                        const size_t j = (chunk_len * i + offset) % _Fcount;
+                        if (not _slots[j].present) {
+                            _eras_pos.push_back(FECDecoder::padded_position(offset, RSk));
+                        }
+                    }
+                }
+
+                // Most chunks arrive without errors, check the syndromes
+                // before we copy and decode them.
+                if (_eras_pos.empty() and
+                        fec.is_codeword(block_begin, RSk, block_begin + RSk)) {
+                    _af_packet.insert(_af_packet.end(), block_begin, block_begin + RSk);
+                    continue;
+                }
+
+                // More erasures than parity bytes cannot be corrected
+                if (_eras_pos.size() > FECDecoder::N - FECDecoder::K) {
+                    _af_packet.clear();
+                    return _af_packet;
+                }
+
                 // We need to pad the chunk ourself
-                vector<uint8_t> chunk(255);
-                const auto& block_begin = rs_block.begin() + (RSk + 48) * i;
-                copy(block_begin, block_begin + RSk, chunk.begin());
-                // bytes between RSk and 207 are 0x00 already
+                copy(block_begin, block_begin + RSk, _chunk.begin());
+                fill(_chunk.begin() + RSk, _chunk.begin() + FECDecoder::K, 0x00);
                 copy(block_begin + RSk, block_begin + RSk + 48,
-                        chunk.begin() + 207);
+                        _chunk.begin() + FECDecoder::K);
 
                 int errors_corrected = -1;
-                if (erasures.count(i)) {
-                    errors_corrected = fec.decode(chunk, erasures[i]);
+                if (not _eras_pos.empty()) {
+                    errors_corrected = fec.decode(_chunk, _eras_pos);
                 }
                 else {
-                    errors_corrected = fec.decode(chunk);
+                    errors_corrected = fec.decode(_chunk);
                 }
 
                 if (errors_corrected == -1) {
                     _af_packet.clear();
-                    return {};
+                    return _af_packet;
                 }
 
 #if 0
                 if (errors_corrected > 0) {
                     etiLog.log(debug, "Corrected %d errors at ", errors_corrected);
-                    for (const auto &index : erasures[i]) {
+                    for (const auto &index : _eras_pos) {
                         etiLog.log(debug, " %d", index);
                     }
                     etiLog.log(debug, "\n");
                 }
 #endif
 
-                _af_packet.insert(_af_packet.end(), chunk.begin(), chunk.begin() + RSk);
+                _af_packet.insert(_af_packet.end(), _chunk.begin(), _chunk.begin() + RSk);
             }
 
-            _af_packet.resize(_af_packet.size() - RSz);
+            if (RSz <= _af_packet.size()) {
+                _af_packet.resize(_af_packet.size() - RSz);
+            }
+            else {
+                _af_packet.clear();
+            }
         }
         else {
             // No FEC: just assemble fragments
 
             for (size_t j = 0; j < _Fcount; ++j) {
-                const bool fragment_present = _fragments.count(j);
-                if (fragment_present)
+                const slot_t& slot = _slots[j];
+                if (slot.present)
                 {
-                    const auto& fragment = _fragments.at(j);
-
-                    _af_packet.insert(_af_packet.end(),
-                       fragment.payload().begin(),
-                       fragment.payload().end());
+                    const uint8_t *fragment = _slab.data() + j * _stride;
+                    _af_packet.insert(_af_packet.end(), fragment, fragment + slot.len);
                 }
                 else {
                     throw logic_error("Missing fragment");
@@ -457,8 +739,8 @@ std::vector<uint8_t> AFBuilder::extractAF()
             ok = checkCRC(_af_packet.data(), _af_packet.size());
 
             if (not ok) {
-                etiLog.log(debug, "CRC error after AF reconstruction from %zu/%u"
-                        " PFT fragments\n", _fragments.size(), _Fcount);
+                etiLog.log(debug, "CRC error after AF reconstruction from %u/%u"
+                        " PFT fragments\n", _num_fragments, _Fcount);
             }
         }
     }
@@ -475,7 +757,7 @@ std::string AFBuilder::visualise()
     stringstream ss;
     ss << "|";
     for (size_t i = 0; i < _Fcount; i++) {
-        if (_fragments.count(i)) {
+        if (_slots[i].present) {
             ss << ".";
         }
         else {
@@ -489,22 +771,24 @@ std::string AFBuilder::visualise()
 std::string AFBuilder::visualise_fragment_origins() const
 {
     stringstream ss;
-    if (_fragments.size() == 0) {
+    if (_num_fragments == 0) {
         return "No fragments";
     }
     else {
-        ss << _fragments.size() << " fragments: ";
+        ss << _num_fragments << " fragments: ";
     }
 
     std::map<int, size_t> port_count;
 
-    for (const auto& f : _fragments) {
-        port_count[f.second.received_on_port]++;
+    for (const auto& slot : _slots) {
+        if (slot.present) {
+            port_count[slot.received_on_port]++;
+        }
     }
 
     for (const auto& p : port_count) {
         ss << "p" << p.first << " " <<
-            std::round(100.0 * ((double)p.second) / (double)_fragments.size()) << "% ";
+            std::round(100.0 * ((double)p.second) / (double)_num_fragments) << "% ";
     }
 
     ss << "\n";
@@ -512,42 +796,160 @@ std::string AFBuilder::visualise_fragment_origins() const
     return ss.str();
 }
 
-void PFT::pushPFTFrag(const Fragment &fragment)
+PFT::PFT()
+{
+    resizePool();
+}
+
+size_t PFT::poolSizeFor(size_t max_delay)
+{
+    // Fragments of the NUM_AFBUILDERS_TO_KEEP previous Pseq, and of up to
+    // max_delay Pseq ahead of m_next_pseq usually arrive. Leave some
+    // margin so that two Pseq in flight rarely share a slot.
+    const size_t min_size = NUM_AFBUILDERS_TO_KEEP + 2 * max_delay + 2;
+    size_t size = 1;
+    while (size < min_size and size < 0x10000) {
+        size <<= 1;
+    }
+    return size;
+}
+
+void PFT::resizePool()
+{
+    m_builders.clear();
+    m_builders.resize(poolSizeFor(m_max_delay));
+    m_num_active = 0;
+}
+
+void PFT::growPool()
+{
+    // Active builders occupy distinct slots, and still do in a pool twice
+    // as large.
+    vector<builder_slot_t> pool(m_builders.size() * 2);
+    for (auto& slot : m_builders) {
+        if (slot.active) {
+            pool[slot.builder.Pseq() & (pool.size() - 1)] = std::move(slot);
+        }
+    }
+    m_builders = std::move(pool);
+
+    etiLog.log(debug, "Grow PFT pool to %zu\n", m_builders.size());
+}
+
+AFBuilder *PFT::findBuilder(pseq_t pseq)
+{
+    auto& slot = m_builders[pseq & (m_builders.size() - 1)];
+    if (slot.active and slot.builder.Pseq() == pseq) {
+        return &slot.builder;
+    }
+    return nullptr;
+}
+
+void PFT::eraseBuilder(pseq_t pseq)
+{
+    auto& slot = m_builders[pseq & (m_builders.size() - 1)];
+    if (slot.active and slot.builder.Pseq() == pseq) {
+        slot.active = false;
+        m_num_active--;
+    }
+}
+
+void PFT::clearBuilders()
+{
+    for (auto& slot : m_builders) {
+        slot.active = false;
+    }
+    m_num_active = 0;
+}
+
+bool PFT::pushPFTFrag(const Fragment &fragment)
 {
+    // Refuse headers that would make us allocate unreasonable amounts
+    // of memory.
+    if (fragment.Fcount() == 0 or
+            (size_t)fragment.Fcount() * std::max<size_t>(fragment.Plen(), 1) > MAX_AF_BUILDER_SIZE) {
+        etiLog.level(warn) << "Discarding fragment with invalid fcount";
+        return false;
+    }
+
+    // A Pseq behind m_next_pseq was already decoded or abandoned. Its
+    // fragments arrive late over a slower path when the same stream is
+    // received several times, and must not occupy a builder. Only a sender
+    // restart gives us many of them in a row. With a single path, they
+    // only come from a restart, and are taken at once.
+    if (m_redundant_sources and m_next_pseq_valid and
+            (pseq_t)(fragment.Pseq() - m_next_pseq) >= 0x8000) {
+        const size_t max_late_fragments = fragment.Fcount() *
+            std::max(m_max_delay, NUM_LATE_PSEQ_BEFORE_RESTART);
+        if (++m_num_late_fragments <= max_late_fragments) {
+            return false;
+        }
+
+        etiLog.level(debug) << "Pseq restarted at " << fragment.Pseq();
+        clearBuilders();
+    }
+    m_num_late_fragments = 0;
+
     // Start decoding the first pseq we receive. In normal
-    // operation without interruptions, the map should
+    // operation without interruptions, the pool should
     // never become empty
-    if (m_afbuilders.empty()) {
+    if (m_num_active == 0) {
         m_next_pseq = fragment.Pseq();
+        m_next_pseq_valid = true;
         etiLog.log(debug,"Initialise next_pseq to %u\n", m_next_pseq);
     }
 
-    if (m_afbuilders.count(fragment.Pseq()) == 0) {
+    // A Pseq that still has to be decoded must not be evicted, make
+    // room by growing the pool instead. This only happens when the decoding
+    // is far behind the reception.
+    auto is_pending = [&](pseq_t pseq) -> bool {
+        return (pseq_t)(pseq - m_next_pseq) < 0x8000;
+    };
+
+    while (m_builders.size() < 0x10000) {
+        const auto& s = m_builders[fragment.Pseq() & (m_builders.size() - 1)];
+        if (s.active and s.builder.Pseq() != fragment.Pseq() and
+                is_pending(s.builder.Pseq())) {
+            growPool();
+        }
+        else {
+            break;
+        }
+    }
+
+    auto& slot = m_builders[fragment.Pseq() & (m_builders.size() - 1)];
+    if (not slot.active or slot.builder.Pseq() != fragment.Pseq()) {
+        if (slot.active) {
+            etiLog.log(debug, "Dropping pseq %u to make room for %u\n",
+                    slot.builder.Pseq(), fragment.Pseq());
+        }
+        else {
+            slot.active = true;
+            m_num_active++;
+        }
+
         // The AFBuilder wants to know the lifetime in number of fragments,
         // we know the delay in number of AF packets. Every AF packet
         // is cut into Fcount fragments.
         const size_t lifetime = fragment.Fcount() * m_max_delay;
-
-        // Build the afbuilder in the map in-place
-        m_afbuilders.emplace(std::piecewise_construct,
-                /* key */
-                std::forward_as_tuple(fragment.Pseq()),
-                /* builder */
-                std::forward_as_tuple(fragment.Pseq(), fragment.Fcount(), lifetime));
+        slot.builder.reset(fragment.Pseq(), fragment.Fcount(), lifetime);
     }
 
-    auto& p = m_afbuilders.at(fragment.Pseq());
-    p.pushPFTFrag(fragment);
+    const bool is_new = slot.builder.pushPFTFrag(fragment);
 
     if (m_verbose) {
         etiLog.log(debug, "Got frag %u:%u, afbuilders: ",
                 fragment.Pseq(), fragment.Findex());
-        for (auto &k : m_afbuilders) {
-            const bool isNextPseq = (m_next_pseq == k.first);
-            etiLog.level(debug) << (isNextPseq ? "->" : "  ") <<
-                k.first << " " << k.second.visualise();
+        for (auto &s : m_builders) {
+            if (s.active) {
+                const bool isNextPseq = (m_next_pseq == s.builder.Pseq());
+                etiLog.level(debug) << (isNextPseq ? "->" : "  ") <<
+                    s.builder.Pseq() << " " << s.builder.visualise();
+            }
         }
     }
+
+    return is_new;
 }
 
 
@@ -555,21 +957,22 @@ afpacket_pft_t PFT::getNextAFPacket()
 {
     afpacket_pft_t af;
 
-    if (m_afbuilders.count(m_next_pseq) == 0) {
-        if (m_afbuilders.size() > m_max_delay) {
-            m_afbuilders.clear();
+    AFBuilder *next_builder = findBuilder(m_next_pseq);
+    if (next_builder == nullptr) {
+        if (m_num_active > m_max_delay) {
+            clearBuilders();
             etiLog.level(debug) << " Reinit";
         }
 
         return af;
     }
 
-    auto &builder = m_afbuilders.at(m_next_pseq);
+    auto &builder = *next_builder;
 
     using dar_t = AFBuilder::decode_attempt_result_t;
 
     if (builder.canAttemptToDecode() == dar_t::yes) {
-        auto afpacket = builder.extractAF();
+        const auto& afpacket = builder.extractAF();
         // Empty AF Packet can happen if CRC is wrong
         if (m_verbose) {
             etiLog.level(debug) << "Fragment origin stats: " << builder.visualise_fragment_origins();
@@ -585,7 +988,7 @@ afpacket_pft_t PFT::getNextAFPacket()
 
         if (builder.lifeTime == 0) {
             // Attempt Reed-Solomon decoding
-            auto afpacket = builder.extractAF();
+            const auto& afpacket = builder.extractAF();
 
             if (afpacket.empty()) {
                 etiLog.log(debug, "pseq %d timed out after RS", m_next_pseq);
@@ -615,6 +1018,23 @@ afpacket_pft_t PFT::getNextAFPacket()
 void PFT::setMaxDelay(size_t num_af_packets)
 {
     m_max_delay = num_af_packets;
+
+    if (m_num_active == 0) {
+        resizePool();
+    }
+    else {
+        // The delay can change while Pseq are in flight, keep them. The
+        // new delay applies to the Pseq that arrive from now on.
+        while (m_builders.size() < poolSizeFor(m_max_delay)) {
+            growPool();
+        }
+    }
+}
+
+void PFT::setRedundantSources(bool enable)
+{
+    m_redundant_sources = enable;
+    m_num_late_fragments = 0;
 }
 
 void PFT::setVerbose(bool enable)
@@ -624,9 +1044,7 @@ void PFT::setVerbose(bool enable)
 
 void PFT::incrementNextPseq()
 {
-    if (m_afbuilders.count(m_next_pseq - NUM_AFBUILDERS_TO_KEEP) > 0) {
-        m_afbuilders.erase(m_next_pseq - NUM_AFBUILDERS_TO_KEEP);
-    }
+    eraseBuilder(m_next_pseq - NUM_AFBUILDERS_TO_KEEP);
 
     m_next_pseq++;
 }
@@ -24,8 +24,8 @@
 #include <cstdio>
 #include <cstdint>
 #include <vector>
-#include <map>
 #include <string>
+#include "byte_view.hpp"
 
 namespace EdiDecoder {
 namespace PFT {
@@ -39,12 +39,11 @@ class Fragment
         int received_on_port = 0;
 
         // Load the data for one fragment from buf into
-        // the Fragment.
+        // the Fragment. The payload is not copied, and refers to buf.
         // \returns the number of bytes of useful data found in buf
         // A non-zero return value doesn't imply a valid fragment
         // the isValid() method must be used to verify this.
-        size_t loadData(const std::vector<uint8_t> &buf, int received_on_port);
-        size_t loadData(const std::vector<uint8_t> &buf);
+        size_t loadData(const byte_view& buf, int received_on_port = 0);
 
         bool isValid() const { return _valid; }
         pseq_t Pseq() const { return _Pseq; }
@@ -54,13 +53,13 @@ class Fragment
         uint16_t Plen() const { return _Plen; }
         uint8_t RSk() const { return _RSk; }
         uint8_t RSz() const { return _RSz; }
-        const std::vector<uint8_t>& payload() const
+        const byte_view& payload() const
             { return _payload; }
 
         bool checkConsistency(const Fragment& other) const;
 
     private:
-        std::vector<uint8_t> _payload;
+        byte_view _payload;
 
         pseq_t _Pseq = 0;
         findex_t _Findex = 0;
@@ -77,6 +76,10 @@ class Fragment
 
 /* The AFBuilder collects Fragments and builds an Application Frame
  * out of them. It does error correction if necessary
+ *
+ * The payloads are copied into a slab with one slot of equal size per
+ * Findex, so that the fragments can arrive in any order. The builders are
+ * reused for successive Pseq, and keep their buffers.
  */
 class AFBuilder
 {
@@ -96,22 +99,31 @@ class AFBuilder
             return "?";
         }
 
+        AFBuilder() = default;
         AFBuilder(pseq_t Pseq, findex_t Fcount, size_t lifetime);
 
-        void pushPFTFrag(const Fragment &frag);
+        // Forget all fragments, and start collecting those of Pseq
+        void reset(pseq_t Pseq, findex_t Fcount, size_t lifetime);
+
+        // Returns true if the fragment was added, false if it was
+        // a copy of one we already have, or invalid
+        bool pushPFTFrag(const Fragment &frag);
+
+        pseq_t Pseq() const { return _Pseq; }
 
         /* Assess if it may be possible to decode this AF packet */
         decode_attempt_result_t canAttemptToDecode();
 
         /* Try to build the AF with received fragments.
          * Apply error correction if necessary (missing packets/CRC errors)
-         * \return an empty vector if building the AF is not possible
+         * \return an empty vector if building the AF is not possible. The
+         * vector is owned by the builder, and stays valid until reset.
          */
-        std::vector<uint8_t> extractAF();
+        const std::vector<uint8_t>& extractAF();
 
         std::pair<findex_t, findex_t>
             numberOfFragments(void) const {
-                return {_fragments.size(), _Fcount};
+                return {_num_fragments, _Fcount};
             }
 
         std::string visualise();
@@ -121,31 +133,59 @@ class AFBuilder
         /* The user of this instance can keep track of the lifetime of this
          * builder
          */
-        size_t lifeTime;
+        size_t lifeTime = 0;
 
     private:
+        void discardFragments();
+        void setStride(size_t stride);
+
+        struct slot_t {
+            bool present = false;
+            uint16_t len = 0;
+            int received_on_port = 0;
+        };
+
+        // One slot per Findex, and the payload of fragment Findex at
+        // offset Findex * _stride in _slab
+        std::vector<slot_t> _slots;
+        std::vector<uint8_t> _slab;
+        size_t _stride = 0;
+        findex_t _num_fragments = 0;
+
+        // Header of the first fragment received, the others have to be
+        // consistent with it. Its payload is not used.
+        Fragment _first;
 
-        // A map from fragment index to fragment
-        std::map<findex_t, Fragment> _fragments;
+        // Buffers for the error correction
+        std::vector<uint8_t> _rs_block;
+        std::vector<uint8_t> _chunk;
+        std::vector<int> _eras_pos;
 
         // cached version of decoded AF packet
-        mutable std::vector<uint8_t> _af_packet;
+        std::vector<uint8_t> _af_packet;
 
-        pseq_t _Pseq;
-        findex_t _Fcount;
+        pseq_t _Pseq = 0;
+        findex_t _Fcount = 0;
 };
 
 struct afpacket_pft_t
 {
     // validity of the struct is given by af_packet begin empty or not.
-    std::vector<uint8_t> af_packet;
+    // It refers to a buffer of the PFT, and stays valid until the next
+    // fragment is pushed.
+    byte_view af_packet;
     pseq_t pseq = 0;
 };
 
 class PFT
 {
     public:
-        void pushPFTFrag(const Fragment &fragment);
+        PFT();
+
+        /* Returns true if the fragment was new, false if it was dropped,
+         * because we already have it or because its Pseq was already
+         * decoded. */
+        bool pushPFTFrag(const Fragment &fragment);
 
         /* Try to build the AF packet for the next pseq. This might
          * skip one or more pseq according to the maximum delay setting.
@@ -155,21 +195,50 @@ class PFT
         afpacket_pft_t getNextAFPacket();
 
         /* Set the maximum delay in number of AF Packets before we
-         * abandon decoding a given pseq.
+         * abandon decoding a given pseq. Can be changed while receiving.
          */
         void setMaxDelay(size_t num_af_packets);
 
+        /* Drop the fragments of Pseq that were already decoded, which
+         * arrive over the slower paths when the same stream is received
+         * several times. Disabled by default, a lower Pseq then restarts
+         * the reassembly at once. */
+        void setRedundantSources(bool enable);
+
         /* Enable verbose fprintf */
         void setVerbose(bool enable);
 
     private:
         void incrementNextPseq();
 
-        pseq_t m_next_pseq;
+        AFBuilder *findBuilder(pseq_t pseq);
+        void eraseBuilder(pseq_t pseq);
+        void clearBuilders();
+        static size_t poolSizeFor(size_t max_delay);
+        void resizePool();
+        void growPool();
+
+        pseq_t m_next_pseq = 0;
+
+        // Set once the first fragment was received. With redundant sources,
+        // fragments behind m_next_pseq are dropped, also after the pool
+        // was cleared.
+        bool m_next_pseq_valid = false;
         size_t m_max_delay = 10; // in AF packets
 
-        // Keep one AFBuilder for each Pseq
-        std::map<pseq_t, AFBuilder> m_afbuilders;
+        // Keep one AFBuilder for each Pseq, in a pool indexed by the lower
+        // bits of the Pseq. Its size is a power of two, larger than the
+        // number of Pseq that are usually in flight at the same time.
+        struct builder_slot_t {
+            bool active = false;
+            AFBuilder builder;
+        };
+        std::vector<builder_slot_t> m_builders;
+        size_t m_num_active = 0;
+
+        // Number of consecutive fragments of already decoded Pseq
+        size_t m_num_late_fragments = 0;
+        bool m_redundant_sources = false;
 
         bool m_verbose = 0;
 };
@@ -0,0 +1,60 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+   http://opendigitalradio.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace EdiDecoder {
+
+/* Non-owning view of a range of bytes, used to hand over the content of a
+ * received packet or of a TAG without copying it. The bytes belong to the
+ * packet being decoded, a view is therefore only valid until the function
+ * it was given to returns. */
+class byte_view {
+    public:
+        byte_view() = default;
+        byte_view(const uint8_t *data, size_t size) :
+            m_data(data), m_size(size) {}
+        byte_view(const std::vector<uint8_t>& vec) :
+            m_data(vec.data()), m_size(vec.size()) {}
+
+        const uint8_t *data() const { return m_data; }
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        const uint8_t *begin() const { return m_data; }
+        const uint8_t *end() const { return m_data + m_size; }
+        uint8_t operator[](size_t i) const { return m_data[i]; }
+
+        // The len bytes starting at offset
+        byte_view sub(size_t offset, size_t len) const {
+            return byte_view(m_data + offset, len);
+        }
+
+    private:
+        const uint8_t *m_data = nullptr;
+        size_t m_size = 0;
+};
+
+}
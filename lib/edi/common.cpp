@@ -131,7 +131,7 @@ std::string tag_name_to_human_readable(const tag_name_t& name)
 
 TagDispatcher::TagDispatcher(std::function<void()>&& af_packet_completed) :
     m_af_packet_completed(std::move(af_packet_completed)),
-    m_afpacket_handler([](std::vector<uint8_t>&& /*ignore*/){})
+    m_afpacket_handler([](const byte_view& /*ignore*/){})
 {
 }
 
@@ -142,6 +142,9 @@ void TagDispatcher::set_verbose(bool verbose)
 
 void TagDispatcher::push_bytes(const vector<uint8_t> &buf)
 {
+    // Streams carry no receive timestamps
+    m_last_rx_timestamp.reset();
+
     if (buf.empty()) {
         m_input_data.clear();
         m_last_sequences.seq_valid = false;
@@ -150,9 +153,14 @@ void TagDispatcher::push_bytes(const vector<uint8_t> &buf)
 
     copy(buf.begin(), buf.end(), back_inserter(m_input_data));
 
-    while (m_input_data.size() > 2) {
-        if (m_input_data[0] == 'A' and m_input_data[1] == 'F') {
-            const auto r = decode_afpacket(m_input_data);
+    // Consumed bytes are only removed from m_input_data once at the end
+    size_t pos = 0;
+
+    while (m_input_data.size() - pos > 2) {
+        const byte_view data(m_input_data.data() + pos, m_input_data.size() - pos);
+
+        if (data[0] == 'A' and data[1] == 'F') {
+            const auto r = decode_afpacket(data);
             bool leave_loop = false;
             switch (r.st) {
                 case decode_state_e::Ok:
@@ -169,36 +177,27 @@ void TagDispatcher::push_bytes(const vector<uint8_t> &buf)
                     break;
             }
 
-            if (r.num_bytes_consumed) {
-                vector<uint8_t> remaining_data;
-                copy(m_input_data.begin() + r.num_bytes_consumed,
-                        m_input_data.end(),
-                        back_inserter(remaining_data));
-                m_input_data = remaining_data;
-            }
+            pos += r.num_bytes_consumed;
 
             if (leave_loop) {
                 break;
             }
         }
-        else if (m_input_data[0] == 'P' and m_input_data[1] == 'F') {
+        else if (data[0] == 'P' and data[1] == 'F') {
             PFT::Fragment fragment;
-            const size_t fragment_bytes = fragment.loadData(m_input_data);
+            const size_t fragment_bytes = fragment.loadData(data);
 
             if (fragment_bytes == 0) {
                 // We need to refill our buffer
                 break;
             }
 
-            vector<uint8_t> remaining_data;
-            copy(m_input_data.begin() + fragment_bytes,
-                    m_input_data.end(),
-                    back_inserter(remaining_data));
-            m_input_data = remaining_data;
-
+            // The fragment refers to m_input_data, which stays unchanged
+            // until the end of the loop
             if (fragment.isValid()) {
                 m_pft.pushPFTFrag(fragment);
             }
+            pos += fragment_bytes;
 
             auto af = m_pft.getNextAFPacket();
             if (not af.af_packet.empty()) {
@@ -221,21 +220,28 @@ void TagDispatcher::push_bytes(const vector<uint8_t> &buf)
             }
         }
         else {
-            etiLog.log(warn, "Unknown 0x%02x!", *m_input_data.data());
-            m_input_data.erase(m_input_data.begin());
+            etiLog.log(warn, "Unknown 0x%02x!", data[0]);
+            pos++;
         }
     }
+
+    m_input_data.erase(m_input_data.begin(), m_input_data.begin() + pos);
 }
 
 void TagDispatcher::push_packet(const Packet &packet)
 {
     auto& buf = packet.buf;
+    m_last_rx_timestamp = packet.rx_timestamp;
 
     if (buf.size() < 2) {
         throw std::invalid_argument("Not enough bytes to read EDI packet header");
     }
 
     if (buf[0] == 'A' and buf[1] == 'F') {
+        if (isStaleAFPacket(buf)) {
+            return;
+        }
+
         const auto r = decode_afpacket(buf);
         m_last_sequences.pseq_valid = false;
 
@@ -248,8 +254,10 @@ void TagDispatcher::push_packet(const Packet &packet)
         PFT::Fragment fragment;
         fragment.loadData(buf, packet.received_on_port);
 
-        if (fragment.isValid()) {
-            m_pft.pushPFTFrag(fragment);
+        // Copies of fragments we already have, received over another path,
+        // must not count towards the timeout of the pending Pseq.
+        if (not fragment.isValid() or not m_pft.pushPFTFrag(fragment)) {
+            return;
         }
 
         auto af = m_pft.getNextAFPacket();
@@ -271,14 +279,52 @@ void TagDispatcher::push_packet(const Packet &packet)
     }
 }
 
+// Number of AF packets with an old SEQ in a row, about one second, after
+// which we assume the sender restarted. When receiving over several paths,
+// their delay difference must stay below that.
+static const size_t NUM_STALE_AFPACKETS_BEFORE_RESTART = 40;
+
 void TagDispatcher::setMaxDelay(int num_af_packets)
 {
+    m_max_delay = num_af_packets;
     m_pft.setMaxDelay(num_af_packets);
 }
 
+void TagDispatcher::setRedundantSources(bool enable)
+{
+    m_redundant_sources = enable;
+    m_num_stale_afpackets = 0;
+    m_pft.setRedundantSources(enable);
+}
+
+bool TagDispatcher::isStaleAFPacket(const std::vector<uint8_t>& buf)
+{
+    if (not m_redundant_sources or buf.size() < 8 or not m_last_sequences.seq_valid) {
+        return false;
+    }
+
+    // When the same stream is received over several paths, the copies of an
+    // AF packet that arrive after the first one carry a SEQ that was already
+    // decoded. Only a sender restart gives us many of them in a row.
+    const uint16_t seq = read_16b(buf.begin() + 6);
+    const uint16_t seq_diff = seq - m_last_sequences.seq;
+
+    if (seq_diff == 0 or seq_diff >= 0x8000) {
+        if (++m_num_stale_afpackets <= std::max(m_max_delay, NUM_STALE_AFPACKETS_BEFORE_RESTART)) {
+            return true;
+        }
+
+        // decode_afpacket() will take this SEQ as the initial one
+        m_last_sequences.seq_valid = false;
+    }
+
+    m_num_stale_afpackets = 0;
+    return false;
+}
+
 
 TagDispatcher::decode_result_t TagDispatcher::decode_afpacket(
-        const std::vector<uint8_t> &input_data)
+        const byte_view& input_data)
 {
     if (input_data.size() < AFPACKET_HEADER_LEN) {
         return {decode_state_e::MissingData, 0};
@@ -327,9 +373,7 @@ TagDispatcher::decode_result_t TagDispatcher::decode_afpacket(
     }
 
     uint16_t crc = 0xffff;
-    for (size_t i = 0; i < AFPACKET_HEADER_LEN + taglength; i++) {
-        crc = crc16(crc, &input_data[i], 1);
-    }
+    crc = crc16(crc, input_data.data(), AFPACKET_HEADER_LEN + taglength);
     crc ^= 0xffff;
 
     uint16_t packet_crc = read_16b(input_data.begin() + AFPACKET_HEADER_LEN + taglength);
@@ -339,17 +383,9 @@ TagDispatcher::decode_result_t TagDispatcher::decode_afpacket(
         return {decode_state_e::Error, AFPACKET_HEADER_LEN + taglength + crclen};
     }
     else {
-        vector<uint8_t> afpacket(AFPACKET_HEADER_LEN + taglength + crclen);
-        copy(input_data.begin(),
-                input_data.begin() + AFPACKET_HEADER_LEN + taglength + crclen,
-                afpacket.begin());
-        m_afpacket_handler(std::move(afpacket));
-
-        vector<uint8_t> payload(taglength);
-        copy(input_data.begin() + AFPACKET_HEADER_LEN,
-                input_data.begin() + AFPACKET_HEADER_LEN + taglength,
-                payload.begin());
+        m_afpacket_handler(input_data.sub(0, AFPACKET_HEADER_LEN + taglength + crclen));
 
+        const auto payload = input_data.sub(AFPACKET_HEADER_LEN, taglength);
         auto result = decode_tagpacket(payload) ? decode_state_e::Ok : decode_state_e::Error;
         return {result, AFPACKET_HEADER_LEN + taglength + crclen};
     }
@@ -366,7 +402,7 @@ void TagDispatcher::register_afpacket_handler(afpacket_handler&& h)
 }
 
 
-bool TagDispatcher::decode_tagpacket(const vector<uint8_t> &payload)
+bool TagDispatcher::decode_tagpacket(const byte_view& payload)
 {
     size_t length = 0;
 
@@ -399,14 +435,11 @@ bool TagDispatcher::decode_tagpacket(const vector<uint8_t> &payload)
         const array<uint8_t, 4> tag_name({
                (uint8_t)tag_sz[0], (uint8_t)tag_sz[1], (uint8_t)tag_sz[2], (uint8_t)tag_sz[3]
                });
-        vector<uint8_t> tag_value(taglength);
-        copy(   payload.begin() + i+8,
-                payload.begin() + i+8+taglength,
-                tag_value.begin());
+        const auto tag_value = payload.sub(i + 8, taglength);
 
         bool tagsuccess = true;
         bool found = false;
-        for (auto tag_handler : m_handlers) {
+        for (const auto& tag_handler : m_handlers) {
             if (    (tag_handler.first.size() == 4 and tag == tag_handler.first) or
                     (tag_handler.first.size() == 3 and tag.substr(0, 3) == tag_handler.first) or
                     (tag_handler.first.size() == 2 and tag.substr(0, 2) == tag_handler.first) or
@@ -434,7 +467,7 @@ bool TagDispatcher::decode_tagpacket(const vector<uint8_t> &payload)
     return success;
 }
 
-odr_version_data parse_odr_version_data(const std::vector<uint8_t>& data)
+odr_version_data parse_odr_version_data(const byte_view& data)
 {
     if (data.size() < sizeof(uint32_t)) {
         return {};
@@ -21,9 +21,11 @@
 #pragma once
 
 #include "PFT.hpp"
+#include "byte_view.hpp"
 #include <functional>
 #include <map>
 #include <chrono>
+#include <optional>
 #include <string>
 #include <array>
 #include <vector>
@@ -86,6 +88,9 @@ struct Packet {
     std::vector<uint8_t> buf;
     int received_on_port;
 
+    // Time at which the kernel received the packet, if known
+    std::optional<std::chrono::system_clock::time_point> rx_timestamp;
+
     Packet(std::vector<uint8_t>&& b) : buf(b), received_on_port(0) { }
     Packet() {}
 };
@@ -126,23 +131,37 @@ class TagDispatcher {
          */
         void setMaxDelay(int num_af_packets);
 
+        /* Enable when the same stream is received over several paths. AF
+         * packets and PFT fragments that were already decoded are then
+         * dropped, and only a long run of them is taken as a sender
+         * restart. Otherwise an older SEQ or Pseq is accepted at once. */
+        void setRedundantSources(bool enable);
+
         /* Handler function for a tag. The first argument contains the tag value,
-         * the second argument contains the tag name */
-        using tag_handler = std::function<bool(const std::vector<uint8_t>&, const tag_name_t&)>;
+         * the second argument contains the tag name. The value points into
+         * the AF packet, and is only valid during the call. */
+        using tag_handler = std::function<bool(const byte_view&, const tag_name_t&)>;
 
         /* Register a handler for a tag. If the tag string can be length 0, 1, 2, 3 or 4.
          * If is shorter than 4, it will perform a longest match on the tag name.
          */
         void register_tag(const std::string& tag, tag_handler&& h);
 
-        /* The complete AF packet can also be retrieved */
-        using afpacket_handler = std::function<void(std::vector<uint8_t>&&)>;
+        /* The complete AF packet can also be retrieved. It is valid until
+         * the af_packet_completed function returns. */
+        using afpacket_handler = std::function<void(const byte_view&)>;
         void register_afpacket_handler(afpacket_handler&& h);
 
         seq_info_t get_seq_info() const {
             return m_last_sequences;
         }
 
+        /* Receive timestamp of the packet that completed the last AF packet,
+         * i.e. the last PFT fragment needed to reassemble it. */
+        std::optional<std::chrono::system_clock::time_point> get_rx_timestamp() const {
+            return m_last_rx_timestamp;
+        }
+
     private:
         enum class decode_state_e {
             Ok, MissingData, Error
@@ -154,11 +173,19 @@ class TagDispatcher {
             size_t num_bytes_consumed;
         };
 
-        decode_result_t decode_afpacket(const std::vector<uint8_t> &input_data);
-        bool decode_tagpacket(const std::vector<uint8_t> &payload);
+        /* Tell if an AF packet carries a SEQ that was already decoded, or an
+         * older one, and should be dropped. */
+        bool isStaleAFPacket(const std::vector<uint8_t>& buf);
+
+        decode_result_t decode_afpacket(const byte_view& input_data);
+        bool decode_tagpacket(const byte_view& payload);
 
         PFT::PFT m_pft;
         seq_info_t m_last_sequences;
+        size_t m_max_delay = 10; // in AF packets
+        size_t m_num_stale_afpackets = 0;
+        bool m_redundant_sources = false;
+        std::optional<std::chrono::system_clock::time_point> m_last_rx_timestamp;
         std::vector<uint8_t> m_input_data;
         std::map<std::string, tag_handler> m_handlers;
         std::function<void()> m_af_packet_completed;
@@ -173,6 +200,6 @@ struct odr_version_data {
     uint32_t uptime_s;
 };
 
-odr_version_data parse_odr_version_data(const std::vector<uint8_t>& data);
+odr_version_data parse_odr_version_data(const byte_view& data);
 
 }
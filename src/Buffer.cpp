@@ -46,10 +46,13 @@ Buffer::Buffer(size_t len, const void *data)
 
 Buffer::Buffer(const Buffer& other)
 {
+    m_len = 0;
+    m_capacity = 0;
+    m_data = nullptr;
     setData(other.m_data, other.m_len);
 }
 
-Buffer::Buffer(Buffer&& other)
+Buffer::Buffer(Buffer&& other) noexcept
 {
     m_len = other.m_len;
     m_capacity = other.m_capacity;
@@ -94,7 +97,7 @@ Buffer& Buffer::operator=(const Buffer& other)
     return *this;
 }
 
-Buffer& Buffer::operator=(Buffer&& other)
+Buffer& Buffer::operator=(Buffer&& other) noexcept
 {
     if (&other != this) {
         m_len = other.m_len;
@@ -54,7 +54,7 @@ class Buffer {
 
         Buffer(size_t len = 0, const void *data = nullptr);
         Buffer(const Buffer& other);
-        Buffer(Buffer&& other);
+        Buffer(Buffer&& other) noexcept;
         Buffer(const std::vector<uint8_t>& vec);
         ~Buffer();
 
@@ -67,7 +67,7 @@ class Buffer {
          * Reallocates memory if needed. */
         void setData(const void *data, size_t len);
         Buffer& operator=(const Buffer& other);
-        Buffer& operator=(Buffer&& other);
+        Buffer& operator=(Buffer&& other) noexcept;
         Buffer& operator=(const std::vector<uint8_t>& buf);
 
         uint8_t operator[](size_t i) const;
@@ -0,0 +1,63 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "BufferPool.h"
+
+BufferPool::BufferPool(size_t max_free_buffers) :
+    m_free(std::make_shared<free_list_t>())
+{
+    m_free->max_free_buffers = max_free_buffers;
+}
+
+Buffer::sptr BufferPool::get()
+{
+    std::unique_ptr<Buffer> buf;
+    {
+        std::lock_guard<std::mutex> lock(m_free->mutex);
+        if (not m_free->buffers.empty()) {
+            buf = std::move(m_free->buffers.back());
+            m_free->buffers.pop_back();
+        }
+    }
+
+    if (not buf) {
+        buf = std::make_unique<Buffer>();
+    }
+
+    auto free_list = m_free;
+    return Buffer::sptr(buf.release(), [free_list](Buffer *b) {
+            std::unique_ptr<Buffer> released(b);
+            std::lock_guard<std::mutex> lock(free_list->mutex);
+            if (free_list->buffers.size() < free_list->max_free_buffers) {
+                free_list->buffers.push_back(std::move(released));
+            }
+        });
+}
+
+size_t BufferPool::num_free() const
+{
+    std::lock_guard<std::mutex> lock(m_free->mutex);
+    return m_free->buffers.size();
+}
+
@@ -0,0 +1,70 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include "Buffer.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* A pool of Buffers that get reused instead of being freed, so that whole
+ * frames can be handed from one thread to another without copying them,
+ * and without allocating new memory for every frame.
+ *
+ * get() returns a Buffer that goes back to the pool once the last reference
+ * to it is released, whichever thread that happens in. At most
+ * max_free_buffers are kept for reuse, the others get freed. The pool may
+ * be destroyed while some of its buffers are still in use.
+ */
+class BufferPool
+{
+public:
+    BufferPool(size_t max_free_buffers);
+    BufferPool(const BufferPool& other) = delete;
+    BufferPool& operator=(const BufferPool& other) = delete;
+
+    // Get a buffer from the pool, or a new one if none is free. Its
+    // content and length are those it had when it was released.
+    Buffer::sptr get();
+
+    // Number of buffers waiting to be reused
+    size_t num_free() const;
+
+private:
+    // Shared with the deleters of the buffers in use
+    struct free_list_t {
+        std::mutex mutex;
+        size_t max_free_buffers = 0;
+        std::vector<std::unique_ptr<Buffer> > buffers;
+    };
+
+    std::shared_ptr<free_list_t> m_free;
+};
+
@@ -31,6 +31,7 @@
 
 #include <cstdint>
 #include <algorithm>
+#include <sstream>
 
 #include "INIReader.h"
 
@@ -38,6 +39,7 @@
 #include "Utils.h"
 #include "Log.h"
 #include "Events.h"
+#include "EtiFileIndex.h"
 
 
 using namespace std;
@@ -84,6 +86,24 @@ static FFTEngine parse_fft_engine(const std::string &fft_engine_setting)
     throw std::runtime_error("Configuration error");
 }
 
+static ResamplerType parse_resampler(const std::string &resampler_setting)
+{
+    string resampler_minuscule(resampler_setting);
+    std::transform(resampler_minuscule.begin(), resampler_minuscule.end(),
+            resampler_minuscule.begin(), ::tolower);
+
+    if (resampler_minuscule == "fft") {
+        return ResamplerType::FFT;
+    }
+    else if (resampler_minuscule == "polyphase") {
+        return ResamplerType::POLYPHASE;
+    }
+
+    cerr << "Modulator resampler setting '" << resampler_setting <<
+        "' not recognised." << endl;
+    throw std::runtime_error("Configuration error");
+}
+
 static void parse_configfile(
         const std::string& configuration_file,
         mod_settings_t& mod_settings)
@@ -133,13 +153,63 @@ static void parse_configfile(
     if (pt.GetInteger("input.loop", 0) == 1) {
         mod_settings.loop = true;
     }
+    if (pt.GetInteger("input.preload", 0) == 1) {
+        mod_settings.preload = true;
+    }
+
+    const std::string start_frame = pt.Get("input.start_frame", "");
+    const std::string start_time = pt.Get("input.start_time", "");
+    if (not start_frame.empty() and not start_time.empty()) {
+        std::cerr << "       input: start_frame and start_time cannot both be set.\n";
+        throw std::runtime_error("Configuration error");
+    }
+    else if (not start_frame.empty()) {
+        mod_settings.start_position = start_frame;
+    }
+    else if (not start_time.empty()) {
+        try {
+            EtiFileIndex::parse_time(start_time);
+        }
+        catch (const std::invalid_argument& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            std::cerr << "       input: invalid start_time.\n";
+            throw std::runtime_error("Configuration error");
+        }
+        mod_settings.start_position = "@" + start_time;
+    }
 
     mod_settings.inputTransport = pt.Get("input.transport", "file");
 
     mod_settings.edi_max_delay_ms = pt.GetReal("input.edi_max_delay", 0.0);
+    mod_settings.edi_adaptive_delay = pt.GetInteger("input.edi_adaptive_delay", 0) == 1;
+    if (mod_settings.edi_adaptive_delay) {
+        mod_settings.edi_min_delay_ms = pt.GetReal("input.edi_min_delay", mod_settings.edi_min_delay_ms);
+        if (mod_settings.edi_max_delay_ms == 0.0f) {
+            mod_settings.edi_max_delay_ms = 480.0f;
+        }
+        mod_settings.edi_target_loss = pt.GetReal("input.edi_target_loss", mod_settings.edi_target_loss);
+
+        if (mod_settings.edi_min_delay_ms < 24.0f or
+                mod_settings.edi_min_delay_ms > mod_settings.edi_max_delay_ms) {
+            std::cerr << "       EDI input: edi_min_delay must be at least 24 and not larger than edi_max_delay.\n";
+            throw std::runtime_error("Configuration error");
+        }
+
+        if (mod_settings.edi_target_loss <= 0.0 or mod_settings.edi_target_loss >= 0.5) {
+            std::cerr << "       EDI input: edi_target_loss must be between 0 and 0.5.\n";
+            throw std::runtime_error("Configuration error");
+        }
+    }
+    mod_settings.edi_rcvbuf_size = pt.GetInteger("input.edi_rcvbuf", 0);
 
     mod_settings.inputName = pt.Get("input.source", "/dev/stdin");
 
+    std::stringstream redundant_sources(pt.Get("input.edi_redundant_sources", ""));
+    std::string redundant_source;
+    while (redundant_sources >> redundant_source) {
+        mod_settings.edi_redundant_sources.push_back(redundant_source);
+    }
+
     // log parameters:
     const string events_endpoint = pt.Get("log.events_endpoint", "");
     if (not events_endpoint.empty()) {
@@ -184,6 +254,8 @@ static void parse_configfile(
     mod_settings.gainMode = parse_gainmode(gainMode_setting);
     mod_settings.gainmodeVariance = pt.GetReal("modulator.normalise_variance",
             mod_settings.gainmodeVariance);
+    mod_settings.gainNumThreads = pt.GetInteger("modulator.gain_num_threads",
+            mod_settings.gainNumThreads);
 
     mod_settings.dabMode = pt.GetInteger("modulator.mode", mod_settings.dabMode);
     mod_settings.clockRate = pt.GetInteger("modulator.dac_clk_rate", (size_t)0);
@@ -191,13 +263,30 @@ static void parse_configfile(
             mod_settings.digitalgain);
 
     mod_settings.outputRate = pt.GetInteger("modulator.rate", mod_settings.outputRate);
+
+    const string resampler_setting = pt.Get("modulator.resampler", "fft");
+    mod_settings.resampler = parse_resampler(resampler_setting);
+    const long resampler_taps = pt.GetInteger("modulator.resampler_taps",
+            mod_settings.resamplerTapsPerPhase);
+    if (resampler_taps < 2 or resampler_taps > 1024) {
+        std::cerr << "       modulator: resampler_taps must be between 2 and 1024.\n";
+        throw std::runtime_error("Configuration error");
+    }
+    mod_settings.resamplerTapsPerPhase = resampler_taps;
+    mod_settings.resamplerStopband = pt.GetReal("modulator.resampler_stopband",
+            mod_settings.resamplerStopband);
     mod_settings.ofdmWindowOverlap = pt.GetInteger("modulator.ofdmwindowing",
             mod_settings.ofdmWindowOverlap);
+    mod_settings.ofdmOversampling = pt.GetInteger("modulator.ofdm_oversampling",
+            mod_settings.ofdmOversampling);
 
     // FIR Filter parameters:
     if (pt.GetInteger("firfilter.enabled", 0) == 1) {
         mod_settings.filterTapsFilename =
             pt.Get("firfilter.filtertapsfile", "default");
+
+        mod_settings.filterNumThreads =
+            pt.GetInteger("firfilter.num_threads", 0);
     }
 
     // Poly coefficients:
@@ -207,6 +296,21 @@ static void parse_configfile(
 
         mod_settings.polyNumThreads =
             pt.GetInteger("poly.num_threads", 0);
+
+        mod_settings.polyPinThreads =
+            (pt.GetInteger("poly.pin_threads", 0) == 1);
+    }
+
+    // Memory polynomial coefficients:
+    if (pt.GetInteger("memorypoly.enabled", 0) == 1) {
+        mod_settings.memoryPolyCoefFilename =
+            pt.Get("memorypoly.coeffile", "dpd/memorypoly.coef");
+
+        mod_settings.memoryPolyNumThreads =
+            pt.GetInteger("memorypoly.num_threads", 0);
+
+        mod_settings.memoryPolyPinThreads =
+            (pt.GetInteger("memorypoly.pin_threads", 0) == 1);
     }
 
     // Crest factor reduction
@@ -342,6 +446,20 @@ static void parse_configfile(
 
         outputsoapy_conf.dpdFeedbackServerPort = pt.GetInteger("soapyoutput.dpd_port", 0);
 
+        outputsoapy_conf.sampleFormat = pt.Get("soapyoutput.format", "complexf");
+        if (outputsoapy_conf.sampleFormat != "complexf" and
+                outputsoapy_conf.sampleFormat != "sc12") {
+            std::cerr << "       soapy output: invalid format " <<
+                outputsoapy_conf.sampleFormat << "\n";
+            throw std::runtime_error("Configuration error");
+        }
+        else if (outputsoapy_conf.sampleFormat != "complexf" and
+                outputsoapy_conf.dpdFeedbackServerPort > 0) {
+            // The DPD feedback server expects complexf TX samples
+            std::cerr << "       soapy output: dpd_port requires format complexf.\n";
+            throw std::runtime_error("Configuration error");
+        }
+
         mod_settings.useSoapyOutput = true;
     }
 #endif // defined(HAVE_SOAPYSDR)
@@ -432,10 +550,88 @@ static void parse_configfile(
     }
 #endif // defined(HAVE_BLADERF)
 
+    else if (output_selected == "simulated") {
+        auto& outputsim_conf = mod_settings.sdr_device_config;
+        auto& sim_conf = mod_settings.simulated_config;
+        sim_conf.iq_filename = pt.Get("simulatedoutput.filename", "");
+        sim_conf.fifo_ms = pt.GetInteger("simulatedoutput.fifo_ms", 200);
+        outputsim_conf.txgain = pt.GetReal("simulatedoutput.txgain", 0.0);
+        outputsim_conf.frequency = pt.GetReal("simulatedoutput.frequency", 0);
+        std::string chan = pt.Get("simulatedoutput.channel", "");
+        outputsim_conf.dabMode = mod_settings.dabMode;
+
+        if (outputsim_conf.frequency != 0 && chan != "") {
+            std::cerr << "       simulated output: cannot define both frequency and channel.\n";
+            throw std::runtime_error("Configuration error");
+        }
+        else if (chan != "") {
+            outputsim_conf.frequency = parse_channel(chan);
+        }
+
+        if (sim_conf.fifo_ms == 0) {
+            std::cerr << "       simulated output: fifo_ms must be positive.\n";
+            throw std::runtime_error("Configuration error");
+        }
+
+        outputsim_conf.rxgain = pt.GetReal("simulatedoutput.rxgain", 0.0);
+        outputsim_conf.dpdFeedbackServerPort = pt.GetInteger("simulatedoutput.dpd_port", 0);
+
+        const std::string pa_model = pt.Get("simulatedoutput.pa_model", "none");
+        if (pa_model == "none") {
+            sim_conf.pa_model = Output::SimulatedConfig::pa_model_t::None;
+        }
+        else if (pa_model == "rapp") {
+            sim_conf.pa_model = Output::SimulatedConfig::pa_model_t::Rapp;
+            sim_conf.rapp_smoothness = pt.GetReal("simulatedoutput.rapp_smoothness", sim_conf.rapp_smoothness);
+            sim_conf.rapp_saturation = pt.GetReal("simulatedoutput.rapp_saturation", sim_conf.rapp_saturation);
+            if (sim_conf.rapp_smoothness <= 0 or sim_conf.rapp_saturation <= 0) {
+                std::cerr << "       simulated output: rapp parameters must be positive.\n";
+                throw std::runtime_error("Configuration error");
+            }
+        }
+        else if (pa_model == "saleh") {
+            sim_conf.pa_model = Output::SimulatedConfig::pa_model_t::Saleh;
+            sim_conf.saleh_alpha_a = pt.GetReal("simulatedoutput.saleh_alpha_a", sim_conf.saleh_alpha_a);
+            sim_conf.saleh_beta_a = pt.GetReal("simulatedoutput.saleh_beta_a", sim_conf.saleh_beta_a);
+            sim_conf.saleh_alpha_phi = pt.GetReal("simulatedoutput.saleh_alpha_phi", sim_conf.saleh_alpha_phi);
+            sim_conf.saleh_beta_phi = pt.GetReal("simulatedoutput.saleh_beta_phi", sim_conf.saleh_beta_phi);
+        }
+        else {
+            std::cerr << "       simulated output: invalid pa_model " << pa_model << "\n";
+            throw std::runtime_error("Configuration error");
+        }
+
+        std::stringstream taps(pt.Get("simulatedoutput.pa_memory_taps", ""));
+        float tap = 0.0f;
+        while (taps >> tap) {
+            sim_conf.memory_taps.push_back(tap);
+        }
+        if (not taps.eof()) {
+            std::cerr << "       simulated output: invalid pa_memory_taps.\n";
+            throw std::runtime_error("Configuration error");
+        }
+
+        sim_conf.rx_delay = pt.GetReal("simulatedoutput.rx_delay", 0.0);
+        sim_conf.rx_noise = pt.GetReal("simulatedoutput.rx_noise", 0.0);
+        if (sim_conf.rx_delay < 0 or sim_conf.rx_noise < 0) {
+            std::cerr << "       simulated output: rx_delay and rx_noise cannot be negative.\n";
+            throw std::runtime_error("Configuration error");
+        }
+
+        mod_settings.useSimulatedOutput = true;
+    }
+
 #if defined(HAVE_ZEROMQ)
     else if (output_selected == "zmq") {
         mod_settings.outputName = pt.Get("zmqoutput.listen", "");
         mod_settings.zmqOutputSocketType = pt.Get("zmqoutput.socket_type", "");
+        mod_settings.zmqOutputFormat = pt.Get("zmqoutput.format", "complexf");
+        if (mod_settings.zmqOutputFormat != "complexf" and
+                mod_settings.zmqOutputFormat != "sc12") {
+            std::cerr << "       zmq output: invalid format " <<
+                mod_settings.zmqOutputFormat << "\n";
+            throw std::runtime_error("Configuration error");
+        }
         mod_settings.useZeroMQOutput = true;
     }
 #endif
@@ -445,9 +641,9 @@ static void parse_configfile(
     }
 
 
-#if defined(HAVE_OUTPUT_UHD) || defined(HAVE_DEXTER)
     mod_settings.sdr_device_config.enableSync = (pt.GetInteger("delaymanagement.synchronous", 0) == 1);
     mod_settings.sdr_device_config.muteNoTimestamps = (pt.GetInteger("delaymanagement.mutenotimestamps", 0) == 1);
+    mod_settings.sdr_device_config.compactQueue = (pt.GetInteger("delaymanagement.compact_queue", 0) == 1);
     if (mod_settings.sdr_device_config.enableSync) {
         std::string delay_mgmt = pt.Get("delaymanagement.management", "");
         std::string fixedoffset = pt.Get("delaymanagement.fixedoffset", "");
@@ -466,7 +662,6 @@ static void parse_configfile(
             throw std::runtime_error("Configuration error");
         }
     }
-#endif
 
 
     /* Read TII parameters from config file */
@@ -490,7 +685,7 @@ void parse_args(int argc, char **argv, mod_settings_t& mod_settings)
     }
 
     while (true) {
-        int c = getopt(argc, argv, "a:C:c:f:F:g:G:hlm:o:O:r:T:u:V");
+        int c = getopt(argc, argv, "a:C:c:f:F:g:G:hIlm:o:O:r:T:u:V");
         if (c == -1) {
             break;
         }
@@ -541,6 +736,9 @@ void parse_args(int argc, char **argv, mod_settings_t& mod_settings)
             mod_settings.sdr_device_config.txgain = strtod(optarg, NULL);
 #endif
             break;
+        case 'I':
+            mod_settings.build_file_index = true;
+            break;
         case 'l':
             mod_settings.loop = true;
             break;
@@ -32,6 +32,7 @@
 #endif
 
 #include <string>
+#include <vector>
 #include "GainControl.h"
 #include "TII.h"
 #include "output/SDRDevice.h"
@@ -42,12 +43,18 @@ enum class FFTEngine {
     DEXTER // fixed-point in FPGA
 };
 
+enum class ResamplerType {
+    FFT, // overlap-add in frequency domain
+    POLYPHASE // polyphase FIR filter
+};
+
 struct mod_settings_t {
     std::string startupCheck;
 
     std::string outputName;
     bool useZeroMQOutput = false;
     std::string zmqOutputSocketType = "";
+    std::string zmqOutputFormat = "complexf";
     bool useFileOutput = false;
     std::string fileOutputFormat = "complexf";
     bool fileOutputShowMetadata = false;
@@ -56,31 +63,56 @@ struct mod_settings_t {
     bool useDexterOutput = false;
     bool useLimeOutput = false;
     bool useBladeRFOutput = false;
+    bool useSimulatedOutput = false;
 
     FFTEngine fftEngine = FFTEngine::FFTW;
 
     size_t outputRate = 2048000;
+    ResamplerType resampler = ResamplerType::FFT;
+    size_t resamplerTapsPerPhase = 64;
+    float resamplerStopband = 80.0f;
+
+    // Generate the OFDM symbols at the output rate using a larger IFFT,
+    // when it is an integer multiple of 2048000
+    bool ofdmOversampling = true;
     size_t clockRate = 0;
     unsigned dabMode = 1;
     float digitalgain = 1.0f;
     float normalise = 1.0f;
     GainMode gainMode = GainMode::GAIN_VAR;
     float gainmodeVariance = 4.0f;
+    unsigned gainNumThreads = 1;
 
     // To handle the timestamp offset of the modulator
     double tist_offset_s = 0.0;
 
     bool loop = false;
+    bool preload = false;
+    // Where to start playing an ETI file, see InputFileReader::FindFrame
+    std::string start_position = "";
+    // Only build the index of the ETI file and exit
+    bool build_file_index = false;
     std::string inputName = "";
     std::string inputTransport = "file";
     float edi_max_delay_ms = 0.0f;
+    bool edi_adaptive_delay = false;
+    float edi_min_delay_ms = 48.0f;
+    double edi_target_loss = 0.001;
+    int edi_rcvbuf_size = 0;
+    std::vector<std::string> edi_redundant_sources;
 
     tii_config_t tiiConfig;
 
     std::string filterTapsFilename = "";
+    unsigned filterNumThreads = 0;
 
     std::string polyCoefFilename = "";
     unsigned polyNumThreads = 0;
+    bool polyPinThreads = false;
+
+    std::string memoryPolyCoefFilename = "";
+    unsigned memoryPolyNumThreads = 0;
+    bool memoryPolyPinThreads = false;
 
     // Settings for crest factor reduction
     bool enableCfr = false;
@@ -91,6 +123,7 @@ struct mod_settings_t {
     size_t ofdmWindowOverlap = 0;
 
     Output::SDRDeviceConfig sdr_device_config;
+    Output::SimulatedConfig simulated_config;
 
     bool showProcessTime = true;
 };
@@ -32,6 +32,8 @@
 
 #include <memory>
 #include <string>
+#include <mutex>
+#include <optional>
 #include <iostream>
 #include <cstdlib>
 #include <stdexcept>
@@ -58,8 +60,10 @@
 #include "output/Dexter.h"
 #include "output/Lime.h"
 #include "output/BladeRF.h"
+#include "output/Simulated.h"
 #include "OutputZeroMQ.h"
 #include "InputReader.h"
+#include "EtiFileIndex.h"
 #include "PcDebug.h"
 #include "FIRFilter.h"
 #include "RemoteControl.h"
@@ -99,6 +103,11 @@ class ModulatorData : public RemoteControllable {
         std::shared_ptr<InputReader> inputReader;
         std::shared_ptr<EtiReader> etiReader;
 
+        // For ETI files, the frame to jump to, set by the remote control
+        std::shared_ptr<InputFileReader> inputFileReader;
+        std::mutex seek_mutex;
+        std::optional<uint64_t> pending_seek;
+
         // For EDI
         std::shared_ptr<EdiInput> ediInput;
 
@@ -117,12 +126,37 @@ class ModulatorData : public RemoteControllable {
             RC_ADD_PARAMETER(ensemble_eid, "(Read-only) Ensemble ID");
             RC_ADD_PARAMETER(ensemble_services, "(Read-only, only JSON) Ensemble service information");
             RC_ADD_PARAMETER(num_services, "(Read-only) Number of services in the ensemble");
+            RC_ADD_PARAMETER(edi_queue_depth, "(Read-only) Number of decoded EDI frames waiting for the modulator");
+            RC_ADD_PARAMETER(edi_decode_time_us, "(Read-only) Average time to decode one EDI frame, in microseconds");
+            RC_ADD_PARAMETER(edi_rx_jitter_us, "(Read-only) Interarrival jitter of the EDI frames received over UDP, in microseconds");
+            RC_ADD_PARAMETER(edi_sources, "(Read-only, only JSON) Packets, losses and lag of every EDI source");
+            RC_ADD_PARAMETER(edi_delay_ms, "(Read-only) EDI reception delay in use, in milliseconds");
+            RC_ADD_PARAMETER(edi_delay_variation_ms, "(Read-only) Percentiles 50, 90, 99 and 99.9 of the EDI frame delay variation, in milliseconds");
+            RC_ADD_PARAMETER(edi_tist_margin_ms, "(Read-only) Smallest margin between the arrival of the EDI frames and their transmission time, in milliseconds");
+            RC_ADD_PARAMETER(seek, "Number of the next frame of the ETI input file. Set to a frame number, or to @ followed by a time, to jump there");
         }
 
         virtual ~ModulatorData() {}
 
         virtual void set_parameter(const std::string& parameter, const std::string& value) {
-            throw ParameterError("Parameter " + parameter + " is read-only");
+            if (parameter == "seek") {
+                if (not (inputFileReader and inputFileReader->IsSeekable())) {
+                    throw ParameterError("Seeking is only possible in ETI files");
+                }
+
+                try {
+                    // Does not wait if the index must be built
+                    const uint64_t frame_number = inputFileReader->FindFrame(value);
+                    std::lock_guard<std::mutex> lock(seek_mutex);
+                    pending_seek = frame_number;
+                }
+                catch (const std::invalid_argument& e) {
+                    throw ParameterError(e.what());
+                }
+            }
+            else {
+                throw ParameterError("Parameter " + parameter + " is read-only");
+            }
         }
 
         virtual const std::string get_parameter(const std::string& parameter) const {
@@ -138,7 +172,7 @@ class ModulatorData : public RemoteControllable {
             }
             else if (parameter == "ensemble_label") {
                 if (ediInput) {
-                    const auto ens = ediInput->ediReader.getEnsembleInfo();
+                    const auto ens = ediInput->collector.getEnsembleInfo();
                     if (ens) {
                         ss << FICDecoder::ConvertLabelToUTF8(ens->label, nullptr);
                     }
@@ -152,7 +186,7 @@ class ModulatorData : public RemoteControllable {
             }
             else if (parameter == "ensemble_eid") {
                 if (ediInput) {
-                    const auto ens = ediInput->ediReader.getEnsembleInfo();
+                    const auto ens = ediInput->collector.getEnsembleInfo();
                     if (ens) {
                         ss << ens->eid;
                     }
@@ -180,9 +214,72 @@ class ModulatorData : public RemoteControllable {
                     throw ParameterError("Not available yet");
                 }
             }
+            else if (parameter == "edi_queue_depth") {
+                if (ediInput) {
+                    ss << ediInput->getQueueDepth();
+                }
+                else {
+                    throw ParameterError("Not available yet");
+                }
+            }
+            else if (parameter == "edi_decode_time_us") {
+                if (ediInput) {
+                    ss << ediInput->getDecodeTime_us();
+                }
+                else {
+                    throw ParameterError("Not available yet");
+                }
+            }
+            else if (parameter == "edi_rx_jitter_us") {
+                if (ediInput) {
+                    ss << ediInput->collector.getRxJitter_us();
+                }
+                else {
+                    throw ParameterError("Not available yet");
+                }
+            }
+            else if (parameter == "edi_delay_ms") {
+                if (ediInput) {
+                    ss << ediInput->getDelayStats().delay_ms;
+                }
+                else {
+                    throw ParameterError("Not available yet");
+                }
+            }
+            else if (parameter == "edi_delay_variation_ms") {
+                if (ediInput) {
+                    const auto stats = ediInput->getDelayStats();
+                    ss << stats.p50_ms << " " << stats.p90_ms << " " <<
+                        stats.p99_ms << " " << stats.p999_ms;
+                }
+                else {
+                    throw ParameterError("Not available yet");
+                }
+            }
+            else if (parameter == "edi_tist_margin_ms") {
+                const auto stats = ediInput ?
+                    ediInput->getDelayStats() : EdiDelayEstimator::stats_t();
+                if (stats.tist_margin_ms) {
+                    ss << *stats.tist_margin_ms;
+                }
+                else {
+                    throw ParameterError("Not available yet");
+                }
+            }
+            else if (parameter == "seek") {
+                if (inputFileReader) {
+                    ss << inputFileReader->GetFrameNumber();
+                }
+                else {
+                    throw ParameterError("Not available yet");
+                }
+            }
             else if (parameter == "ensemble_services") {
                 throw ParameterError("ensemble_services is only available through 'showjson'");
             }
+            else if (parameter == "edi_sources") {
+                throw ParameterError("edi_sources is only available through 'showjson'");
+            }
             else {
                 ss << "Parameter '" << parameter <<
                     "' is not exported by controllable " << get_rc_name();
@@ -198,11 +295,36 @@ class ModulatorData : public RemoteControllable {
             map["running_since"].v = running_since;
             map["most_recent_edi_decoded"].v = most_recent_edi_decoded;
 
+            if (inputFileReader) {
+                map["seek"].v = inputFileReader->GetFrameNumber();
+            }
+            else {
+                map["seek"].v = nullopt;
+            }
+
             if (ediInput) {
                 map["edi_source"].v = ediInput->ediTransport.getTcpUri();
                 map["num_services"].v = ediInput->ediReader.getSubchannels().size();
+                map["edi_queue_depth"].v = ediInput->getQueueDepth();
+                map["edi_decode_time_us"].v = ediInput->getDecodeTime_us();
+                map["edi_rx_jitter_us"].v = ediInput->collector.getRxJitter_us();
+
+                const auto delay_stats = ediInput->getDelayStats();
+                map["edi_delay_ms"].v = delay_stats.delay_ms;
+                std::vector<json::value_t> delay_variation(4);
+                delay_variation[0].v = delay_stats.p50_ms;
+                delay_variation[1].v = delay_stats.p90_ms;
+                delay_variation[2].v = delay_stats.p99_ms;
+                delay_variation[3].v = delay_stats.p999_ms;
+                map["edi_delay_variation_ms"].v = delay_variation;
+                if (delay_stats.tist_margin_ms) {
+                    map["edi_tist_margin_ms"].v = *delay_stats.tist_margin_ms;
+                }
+                else {
+                    map["edi_tist_margin_ms"].v = nullopt;
+                }
 
-                const auto ens = ediInput->ediReader.getEnsembleInfo();
+                const auto ens = ediInput->collector.getEnsembleInfo();
                 if (ens) {
                     map["ensemble_label"].v = FICDecoder::ConvertLabelToUTF8(ens->label, nullptr);
                     map["ensemble_eid"].v = ens->eid;
@@ -214,7 +336,7 @@ class ModulatorData : public RemoteControllable {
 
                 std::vector<json::value_t> services;
 
-                for (const auto& s : ediInput->ediReader.getServiceInfo()) {
+                for (const auto& s : ediInput->collector.getServiceInfo()) {
                     auto service_map = make_shared<json::map_t>();
                     (*service_map)["sad"].v = s.second.subchannel.start;
                     (*service_map)["sid"].v = s.second.sid;
@@ -228,6 +350,20 @@ class ModulatorData : public RemoteControllable {
 
                 map["ensemble_services"].v = services;
 
+                std::vector<json::value_t> sources;
+                for (const auto& st : ediInput->ediTransport.getSourceStats()) {
+                    auto source_map = make_shared<json::map_t>();
+                    (*source_map)["uri"].v = st.uri;
+                    (*source_map)["packets"].v = st.num_packets;
+                    (*source_map)["missed"].v = st.num_missed;
+                    (*source_map)["first"].v = st.num_first;
+                    (*source_map)["lag_us"].v = st.lag_us;
+                    json::value_t v;
+                    v.v = source_map;
+                    sources.push_back(v);
+                }
+                map["edi_sources"].v = sources;
+
             }
             return map;
         }
@@ -241,7 +377,8 @@ enum class run_modulator_state_t {
     failure,    // Corresponds to all failures
     normal_end, // Number of frames to modulate was reached
     again,      // Restart the modulator part
-    reconfigure // Some sort of change of configuration we cannot handle happened
+    reconfigure,// Some sort of change of configuration we cannot handle happened
+    seek,       // The ETI file input jumped to another frame
 };
 
 static run_modulator_state_t run_modulator(const mod_settings_t& mod_settings, ModulatorData& m);
@@ -274,6 +411,12 @@ static shared_ptr<ModOutput> prepare_output(mod_settings_t& s)
 
             output = make_shared<OutputFile>(s.outputName, s.fileOutputShowMetadata);
         }
+        else if (s.fileOutputFormat == "sc12") {
+            // We must normalise the samples to the interval [-2047.0; 2047.0]
+            s.normalise = 2047.0f / normalise_factor;
+
+            output = make_shared<OutputFile>(s.outputName, s.fileOutputShowMetadata);
+        }
         else if (s.fileOutputFormat == "s8" or
                 s.fileOutputFormat == "u8") {
             // We must normalise the samples to the interval [-127.0; 127.0]
@@ -290,7 +433,13 @@ static shared_ptr<ModOutput> prepare_output(mod_settings_t& s)
     }
 #if defined(HAVE_OUTPUT_UHD)
     else if (s.useUHDOutput) {
-        s.normalise = 1.0f / normalise_factor;
+        if (s.sdr_device_config.compactQueue) {
+            /* We normalise to the sc16 range [-32768; 32767] */
+            s.normalise = 32767.0f / normalise_factor;
+        }
+        else {
+            s.normalise = 1.0f / normalise_factor;
+        }
         s.sdr_device_config.sampleRate = s.outputRate;
         s.sdr_device_config.fixedPoint = (s.fftEngine != FFTEngine::FFTW);
         auto uhddevice = make_shared<Output::UHD>(s.sdr_device_config);
@@ -300,8 +449,18 @@ static shared_ptr<ModOutput> prepare_output(mod_settings_t& s)
 #endif
 #if defined(HAVE_SOAPYSDR)
     else if (s.useSoapyOutput) {
-        /* We normalise the same way as for the UHD output */
-        s.normalise = 1.0f / normalise_factor;
+        if (s.sdr_device_config.sampleFormat == "sc12") {
+            /* We normalise to the 12-bit range [-2048; 2047] */
+            s.normalise = 2047.0f / normalise_factor;
+        }
+        else if (s.sdr_device_config.compactQueue) {
+            /* We normalise to the sc16 range [-32768; 32767] */
+            s.normalise = 32767.0f / normalise_factor;
+        }
+        else {
+            /* We normalise the same way as for the UHD output */
+            s.normalise = 1.0f / normalise_factor;
+        }
         s.sdr_device_config.sampleRate = s.outputRate;
         if (s.fftEngine != FFTEngine::FFTW) throw runtime_error("soapy fixed_point unsupported");
         auto soapydevice = make_shared<Output::Soapy>(s.sdr_device_config);
@@ -321,8 +480,14 @@ static shared_ptr<ModOutput> prepare_output(mod_settings_t& s)
 #endif
 #if defined(HAVE_LIMESDR)
     else if (s.useLimeOutput) {
-        /* We normalise the same way as for the UHD output */
-        s.normalise = 1.0f / normalise_factor;
+        if (s.sdr_device_config.compactQueue) {
+            /* We normalise to the sc16 range [-32768; 32767] */
+            s.normalise = 32767.0f / normalise_factor;
+        }
+        else {
+            /* We normalise the same way as for the UHD output */
+            s.normalise = 1.0f / normalise_factor;
+        }
         if (s.fftEngine != FFTEngine::FFTW) throw runtime_error("limesdr fixed_point unsupported");
         s.sdr_device_config.sampleRate = s.outputRate;
         auto limedevice = make_shared<Output::Lime>(s.sdr_device_config);
@@ -341,10 +506,32 @@ static shared_ptr<ModOutput> prepare_output(mod_settings_t& s)
         rcs.enrol((Output::SDR*)output.get());
     }
 #endif
+    else if (s.useSimulatedOutput) {
+        if (s.sdr_device_config.compactQueue) {
+            /* We normalise to the sc16 range [-32768; 32767] */
+            s.normalise = 32767.0f / normalise_factor;
+        }
+        else {
+            /* We normalise the same way as for the UHD output */
+            s.normalise = 1.0f / normalise_factor;
+        }
+        if (s.fftEngine != FFTEngine::FFTW) throw runtime_error("simulated fixed_point unsupported");
+        s.sdr_device_config.sampleRate = s.outputRate;
+        auto simdevice = make_shared<Output::Simulated>(
+                s.sdr_device_config, s.simulated_config);
+        output = make_shared<Output::SDR>(s.sdr_device_config, simdevice);
+        rcs.enrol((Output::SDR*)output.get());
+    }
 #if defined(HAVE_ZEROMQ)
     else if (s.useZeroMQOutput) {
-        /* We normalise the same way as for the UHD output */
-        s.normalise = 1.0f / normalise_factor;
+        if (s.zmqOutputFormat == "sc12") {
+            /* We normalise to the 12-bit range [-2048; 2047] */
+            s.normalise = 2047.0f / normalise_factor;
+        }
+        else {
+            /* We normalise the same way as for the UHD output */
+            s.normalise = 1.0f / normalise_factor;
+        }
         if (s.zmqOutputSocketType == "pub") {
             output = make_shared<OutputZeroMQ>(s.outputName, ZMQ_PUB);
         }
@@ -391,13 +578,21 @@ int launch_modulator(int argc, char* argv[])
             VERSION;
 #endif
 
+    if (mod_settings.build_file_index) {
+        EtiFileIndex index(mod_settings.inputName);
+        etiLog.level(info) << "Index of " << index.size() << " frames in " <<
+            EtiFileIndex::sidecar_filename(mod_settings.inputName);
+        return 0;
+    }
+
     if (not (mod_settings.useFileOutput or
              mod_settings.useUHDOutput or
              mod_settings.useZeroMQOutput or
              mod_settings.useSoapyOutput or
              mod_settings.useDexterOutput or
              mod_settings.useLimeOutput or
-             mod_settings.useBladeRFOutput)) {
+             mod_settings.useBladeRFOutput or
+             mod_settings.useSimulatedOutput)) {
         throw std::runtime_error("Configuration error: Output not specified");
     }
 
@@ -458,12 +653,28 @@ int launch_modulator(int argc, char* argv[])
     else if (mod_settings.useFileOutput and
             (mod_settings.fileOutputFormat == "s8" or
              mod_settings.fileOutputFormat == "u8" or
-             mod_settings.fileOutputFormat == "s16")) {
+             mod_settings.fileOutputFormat == "s16" or
+             mod_settings.fileOutputFormat == "sc12")) {
         output_format = mod_settings.fileOutputFormat;
     }
+    else if (mod_settings.useZeroMQOutput and
+            mod_settings.zmqOutputFormat == "sc12") {
+        output_format = mod_settings.zmqOutputFormat;
+    }
+    else if (mod_settings.useSoapyOutput and
+            mod_settings.sdr_device_config.sampleFormat == "sc12") {
+        output_format = mod_settings.sdr_device_config.sampleFormat;
+    }
     else if (mod_settings.useBladeRFOutput or mod_settings.useDexterOutput) {
         output_format = "s16";
     }
+    else if (mod_settings.sdr_device_config.compactQueue and
+            (mod_settings.useUHDOutput or
+             mod_settings.useSoapyOutput or
+             mod_settings.useLimeOutput or
+             mod_settings.useSimulatedOutput)) {
+        output_format = "s16";
+    }
 
     auto output = prepare_output(mod_settings);
 
@@ -483,21 +694,49 @@ int launch_modulator(int argc, char* argv[])
 
     if (mod_settings.inputTransport == "edi") {
         ediInput = make_shared<EdiInput>(mod_settings.tist_offset_s, mod_settings.edi_max_delay_ms);
+        ediInput->ediTransport.setReceiveBufferSize(mod_settings.edi_rcvbuf_size);
+        if (mod_settings.edi_adaptive_delay) {
+            ediInput->setAdaptiveDelay(mod_settings.edi_min_delay_ms,
+                    mod_settings.edi_max_delay_ms, mod_settings.edi_target_loss);
+        }
 
         ediInput->ediTransport.Open(mod_settings.inputName);
+        for (const auto& uri : mod_settings.edi_redundant_sources) {
+            ediInput->ediTransport.Open(uri);
+        }
+        if (not mod_settings.edi_redundant_sources.empty()) {
+            ediInput->decoder.setRedundantSources(true);
+        }
         if (not ediInput->ediTransport.isEnabled()) {
             throw runtime_error("inputTransport is edi, but ediTransport is not enabled");
         }
+
+        ediInput->start();
     }
     else if (mod_settings.inputTransport == "file") {
         auto inputFileReader = make_shared<InputFileReader>();
 
         // Opening ETI input file
-        if (inputFileReader->Open(mod_settings.inputName, mod_settings.loop) == -1) {
+        if (inputFileReader->Open(mod_settings.inputName, mod_settings.loop,
+                    mod_settings.preload) == -1) {
             throw std::runtime_error("Unable to open input");
         }
 
+        if (not mod_settings.start_position.empty()) {
+            if (not inputFileReader->IsSeekable()) {
+                throw std::runtime_error("Cannot start input " + mod_settings.inputName +
+                        " at " + mod_settings.start_position + ", it is not a regular file");
+            }
+
+            inputFileReader->LoadIndex();
+            const uint64_t frame_number = inputFileReader->FindFrame(mod_settings.start_position);
+            if (inputFileReader->Seek(frame_number) == -1) {
+                throw std::runtime_error("Unable to seek in input");
+            }
+        }
+
         inputReader = inputFileReader;
+        m.inputFileReader = inputFileReader;
     }
     else if (mod_settings.inputTransport == "tcp") {
         auto inputTcpReader = make_shared<InputTcpReader>();
@@ -552,7 +791,8 @@ int launch_modulator(int argc, char* argv[])
                 etiLog.level(warn) << "Restart modulator.";
                 run_again = false;
                 if (auto in = dynamic_pointer_cast<InputFileReader>(inputReader)) {
-                    if (in->Open(mod_settings.inputName, mod_settings.loop) == -1) {
+                    if (in->Open(mod_settings.inputName, mod_settings.loop,
+                                mod_settings.preload) == -1) {
                         etiLog.level(error) << "Unable to open input file!";
                         ret = 1;
                     }
@@ -574,6 +814,10 @@ int launch_modulator(int argc, char* argv[])
                 /* We can keep the input in this case */
                 run_again = true;
                 break;
+            case run_modulator_state_t::seek:
+                /* The input is already at the new frame */
+                run_again = true;
+                break;
             case run_modulator_state_t::normal_end:
             default:
                 etiLog.level(info) << "modulator stopped.";
@@ -602,16 +846,42 @@ static run_modulator_state_t run_modulator(const mod_settings_t& mod_settings, M
             data.setLength(6144);
         }
 
+        // The frames of a file input are given to the EtiReader without copy
+        auto inputFileReader = m.inputFileReader;
+
         while (running) {
             unsigned fct = 0;
             unsigned fp = 0;
 
+            if (inputFileReader) {
+                std::optional<uint64_t> seek;
+                {
+                    std::lock_guard<std::mutex> lock(m.seek_mutex);
+                    seek.swap(m.pending_seek);
+                }
+
+                if (seek) {
+                    // Restart the flowgraph, as the frames are not continuous
+                    if (inputFileReader->Seek(*seek) == -1) {
+                        etiLog.level(error) << "Input seek error.";
+                        ret = run_modulator_state_t::failure;
+                    }
+                    else {
+                        ret = run_modulator_state_t::seek;
+                    }
+                    break;
+                }
+            }
+
             /* Load ETI data from the source */
             if (m.inputReader) {
-                int framesize = m.inputReader->GetNextFrame(data.getData());
+                const uint8_t *frame = nullptr;
+                int framesize = inputFileReader ?
+                    inputFileReader->GetNextFrameView(frame) :
+                    m.inputReader->GetNextFrame(data.getData());
 
                 if (framesize == 0) {
-                    if (dynamic_pointer_cast<InputFileReader>(m.inputReader)) {
+                    if (inputFileReader) {
                         etiLog.level(info) << "End of file reached.";
                         running = 0;
                         ret = run_modulator_state_t::normal_end;
@@ -633,8 +903,10 @@ static run_modulator_state_t run_modulator(const mod_settings_t& mod_settings, M
                     break;
                 }
 
-                const int eti_bytes_read = m.etiReader->loadEtiData(data);
-                if ((size_t)eti_bytes_read != data.getLength()) {
+                const int eti_bytes_read = frame ?
+                    m.etiReader->loadEtiFrame(frame, framesize) :
+                    m.etiReader->loadEtiData(data);
+                if (eti_bytes_read != (frame ? framesize : (int)data.getLength())) {
                     etiLog.level(error) << "ETI frame incompletely read";
                     throw std::runtime_error("ETI read error");
                 }
@@ -648,10 +920,14 @@ static run_modulator_state_t run_modulator(const mod_settings_t& mod_settings, M
             else if (m.ediInput) {
                 while (running and not m.ediInput->ediReader.isFrameReady()) {
                     try {
-                        bool packet_received = m.ediInput->ediTransport.rxPacket();
-                        if (packet_received) {
-                            last_frame_received = chrono::steady_clock::now();
-                        }
+                        m.ediInput->loadNextFrame();
+                        last_frame_received = chrono::steady_clock::now();
+                    }
+                    catch (const ThreadsafeQueueWakeup&) {
+                        // No frame received for a while
+                    }
+                    catch (const std::invalid_argument& e) {
+                        etiLog.level(warn) << "EDI input: dropping frame: " << e.what();
                     }
                     catch (const std::runtime_error& e) {
                         etiLog.level(warn) << "EDI input: " << e.what();
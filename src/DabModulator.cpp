@@ -43,6 +43,7 @@
 #include "GuardIntervalInserter.h"
 #include "Log.h"
 #include "MemlessPoly.h"
+#include "MemoryPoly.h"
 #include "NullSymbol.h"
 #include "OfdmGenerator.h"
 #include "PhaseReference.h"
@@ -189,6 +190,21 @@ int DabModulator::process(Buffer* dataOut)
             etiLog.level(error) << "Could not initialise TII: " << e.what();
         }
 
+        // When the output rate is an integer multiple of 2048000, a larger
+        // IFFT directly generates the symbols at the output rate and the
+        // resampler is not needed. The FIR filter taps are designed for
+        // 2048000 sps, and therefore require the resampler.
+        size_t oversampling = 1;
+        if (m_settings.ofdmOversampling and
+                m_settings.fftEngine == FFTEngine::FFTW and
+                m_settings.filterTapsFilename.empty() and
+                m_settings.outputRate > 2048000 and
+                m_settings.outputRate % 2048000 == 0) {
+            oversampling = m_settings.outputRate / 2048000;
+            etiLog.level(info) << "OFDM symbols generated with " <<
+                oversampling << "x oversampling, resampler disabled";
+        }
+
         shared_ptr<ModPlugin> cifOfdm;
 
         switch (m_settings.fftEngine) {
@@ -197,7 +213,7 @@ int DabModulator::process(Buffer* dataOut)
                     auto ofdm = make_shared<OfdmGeneratorCF32>(
                             (1 + m_nbSymbols),
                             m_nbCarriers,
-                            m_spacing,
+                            m_spacing * oversampling,
                             m_settings.enableCfr,
                             m_settings.cfrClip,
                             m_settings.cfrErrorClip);
@@ -227,25 +243,31 @@ int DabModulator::process(Buffer* dataOut)
 
         if (not fixedPoint) {
             cifGain = make_shared<GainControl>(
-                    m_spacing,
+                    m_spacing * oversampling,
                     m_settings.gainMode,
                     m_settings.digitalgain,
                     m_settings.normalise,
-                    m_settings.gainmodeVariance);
+                    m_settings.gainmodeVariance,
+                    m_settings.gainNumThreads);
 
             rcs.enrol(cifGain.get());
         }
 
         auto cifGuard = make_shared<GuardIntervalInserter>(
-                m_nbSymbols, m_spacing, m_nullSize, m_symSize,
-                m_settings.ofdmWindowOverlap, m_settings.fftEngine);
+                m_nbSymbols,
+                m_spacing * oversampling,
+                m_nullSize * oversampling,
+                m_symSize * oversampling,
+                m_settings.ofdmWindowOverlap, m_settings.fftEngine,
+                oversampling);
         rcs.enrol(cifGuard.get());
 
         shared_ptr<FIRFilter> cifFilter;
         if (not m_settings.filterTapsFilename.empty()) {
             if (fixedPoint) throw std::runtime_error("fixed point doesn't support fir filter");
 
-            cifFilter = make_shared<FIRFilter>(m_settings.filterTapsFilename);
+            cifFilter = make_shared<FIRFilter>(m_settings.filterTapsFilename,
+                                               m_settings.filterNumThreads);
             rcs.enrol(cifFilter.get());
         }
 
@@ -254,18 +276,40 @@ int DabModulator::process(Buffer* dataOut)
             if (fixedPoint) throw std::runtime_error("fixed point doesn't support predistortion");
 
             cifPoly = make_shared<MemlessPoly>(m_settings.polyCoefFilename,
-                                               m_settings.polyNumThreads);
+                                               m_settings.polyNumThreads,
+                                               m_settings.polyPinThreads);
             rcs.enrol(cifPoly.get());
         }
 
-        shared_ptr<Resampler> cifRes;
-        if (m_settings.outputRate != 2048000) {
+        shared_ptr<MemoryPoly> cifMemoryPoly;
+        if (not m_settings.memoryPolyCoefFilename.empty()) {
+            if (fixedPoint) throw std::runtime_error("fixed point doesn't support predistortion");
+
+            cifMemoryPoly = make_shared<MemoryPoly>(m_settings.memoryPolyCoefFilename,
+                                                    m_settings.memoryPolyNumThreads,
+                                                    m_settings.memoryPolyPinThreads);
+            rcs.enrol(cifMemoryPoly.get());
+        }
+
+        shared_ptr<ModCodec> cifRes;
+        if (m_settings.outputRate != 2048000 * oversampling) {
             if (fixedPoint) throw std::runtime_error("fixed point doesn't support resampler");
 
-            cifRes = make_shared<Resampler>(
-                    2048000,
-                    m_settings.outputRate,
-                    m_spacing);
+            switch (m_settings.resampler) {
+                case ResamplerType::FFT:
+                    cifRes = make_shared<Resampler>(
+                            2048000,
+                            m_settings.outputRate,
+                            m_spacing);
+                    break;
+                case ResamplerType::POLYPHASE:
+                    cifRes = make_shared<PolyphaseResampler>(
+                            2048000,
+                            m_settings.outputRate,
+                            m_settings.resamplerTapsPerPhase,
+                            m_settings.resamplerStopband);
+                    break;
+            }
         }
 
         if (m_settings.fftEngine == FFTEngine::FFTW and not m_format.empty()) {
@@ -404,6 +448,7 @@ int DabModulator::process(Buffer* dataOut)
                 static_pointer_cast<ModPlugin>(cifFilter),
                 static_pointer_cast<ModPlugin>(cifRes),
                 static_pointer_cast<ModPlugin>(cifPoly),
+                static_pointer_cast<ModPlugin>(cifMemoryPoly),
                 static_pointer_cast<ModPlugin>(m_formatConverter),
                 // mandatory block
                 static_pointer_cast<ModPlugin>(m_output),
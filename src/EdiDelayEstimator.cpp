@@ -0,0 +1,166 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "EdiDelayEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Number of frames over which the delay variation is measured, about 50s
+static constexpr size_t WINDOW_SIZE = 2048;
+
+// Number of frames between two evaluations, about one second
+static constexpr size_t EVALUATION_INTERVAL = 42;
+
+// Number of evaluations in a row that have to ask for a smaller delay
+// before it gets reduced
+static constexpr size_t NUM_SMALLER_BEFORE_DECREASE = 10;
+
+// The DLFC counts frames modulo 5000. Restart the measurement after an
+// interruption of more than ten seconds.
+static constexpr uint16_t DLFC_MODULO = 5000;
+static constexpr uint16_t MAX_FRAMES_ELAPSED = 417;
+
+EdiDelayEstimator::EdiDelayEstimator(
+        double min_delay_ms, double max_delay_ms, double target_loss) :
+    m_min_delay_ms(min_delay_ms),
+    m_max_delay_ms(max_delay_ms),
+    m_target_loss(target_loss),
+    m_transit_ms(WINDOW_SIZE),
+    m_margin_ms(WINDOW_SIZE)
+{
+    m_scratch.reserve(WINDOW_SIZE);
+    m_stats.delay_ms = m_min_delay_ms;
+}
+
+bool EdiDelayEstimator::add_frame(chrono::system_clock::time_point rx_time, uint16_t dlfc,
+        const optional<chrono::system_clock::time_point>& tx_time)
+{
+    using namespace std::chrono;
+
+    const uint16_t frames_elapsed = (dlfc + DLFC_MODULO - m_last_dlfc) % DLFC_MODULO;
+    m_last_dlfc = dlfc;
+
+    if (m_nominal_time and frames_elapsed > 0 and frames_elapsed < MAX_FRAMES_ELAPSED) {
+        *m_nominal_time += frames_elapsed * milliseconds(24);
+    }
+    else {
+        // The transit delays are only comparable with the same reference
+        m_nominal_time = rx_time;
+        m_num_samples = 0;
+        m_num_margins = 0;
+    }
+
+    const auto transit = rx_time - *m_nominal_time;
+    m_transit_ms[m_num_samples % WINDOW_SIZE] =
+        duration_cast<microseconds>(transit).count() / 1000.0;
+    m_num_samples++;
+
+    if (tx_time) {
+        const auto margin = *tx_time - rx_time;
+        m_margin_ms[m_num_margins % WINDOW_SIZE] =
+            duration_cast<microseconds>(margin).count() / 1000.0;
+        m_num_margins++;
+    }
+
+    if (++m_frames_since_evaluation >= EVALUATION_INTERVAL) {
+        m_frames_since_evaluation = 0;
+        const size_t previous_delay_frames = get_delay_frames();
+        evaluate();
+        return get_delay_frames() != previous_delay_frames;
+    }
+    return false;
+}
+
+void EdiDelayEstimator::evaluate()
+{
+    const size_t n = std::min(m_num_samples, WINDOW_SIZE);
+    if (n < 2) {
+        return;
+    }
+
+    m_scratch.assign(m_transit_ms.begin(), m_transit_ms.begin() + n);
+    const double min_transit = *std::min_element(m_scratch.begin(), m_scratch.end());
+
+    auto quantile = [&](double q) -> double {
+        const size_t ix = std::min<size_t>(n - 1, std::max(std::ceil(q * n) - 1, 0.0));
+        std::nth_element(m_scratch.begin(), m_scratch.begin() + ix, m_scratch.end());
+        return m_scratch[ix] - min_transit;
+    };
+
+    stats_t stats;
+    stats.p50_ms = quantile(0.5);
+    stats.p90_ms = quantile(0.9);
+    stats.p99_ms = quantile(0.99);
+    stats.p999_ms = quantile(0.999);
+    const double required_ms = quantile(1.0 - m_target_loss) + frame_duration_ms;
+
+    // Frames delayed beyond their transmission time would be lost anyway,
+    // keep one frame of margin.
+    double cap_ms = m_max_delay_ms;
+    if (m_num_margins > 0) {
+        const size_t num_margins = std::min(m_num_margins, WINDOW_SIZE);
+        stats.tist_margin_ms = *std::min_element(
+                m_margin_ms.begin(), m_margin_ms.begin() + num_margins);
+        cap_ms = std::min(cap_ms, *stats.tist_margin_ms - frame_duration_ms);
+    }
+
+    const double delay_ms = std::max(m_min_delay_ms, std::min(required_ms, cap_ms));
+
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    const double current_ms = m_stats.delay_ms;
+
+    if (delay_ms >= current_ms or current_ms > cap_ms) {
+        stats.delay_ms = delay_ms;
+        m_num_smaller = 0;
+    }
+    else {
+        m_largest_smaller_ms = (m_num_smaller == 0) ?
+            delay_ms : std::max(m_largest_smaller_ms, delay_ms);
+
+        if (++m_num_smaller >= NUM_SMALLER_BEFORE_DECREASE) {
+            stats.delay_ms = m_largest_smaller_ms;
+            m_num_smaller = 0;
+        }
+        else {
+            stats.delay_ms = current_ms;
+        }
+    }
+
+    m_stats = stats;
+}
+
+size_t EdiDelayEstimator::get_delay_frames() const
+{
+    const double frames = std::ceil(get_stats().delay_ms / frame_duration_ms - 1e-6);
+    return std::max<size_t>(1, (size_t)frames);
+}
+
+EdiDelayEstimator::stats_t EdiDelayEstimator::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    return m_stats;
+}
@@ -0,0 +1,117 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/* Measures how the arrival times of the EDI frames vary, and derives the
+ * reception delay that keeps the fraction of frames arriving too late
+ * below a target.
+ *
+ * The sender emits one frame every 24ms, numbered by the DLFC. The arrival
+ * time of every frame, minus its nominal emission time, gives its transit
+ * delay up to a constant. Over a window of recent frames, the delay
+ * variation is the transit delay minus the smallest one in the window, and
+ * the required delay is its quantile at 1 - target_loss.
+ *
+ * The required delay sizes both the PFT reassembly window and the number
+ * of frames to buffer before modulating. It is kept within the configured
+ * bounds, and below the margin between the arrival of the frames and their
+ * transmission time given by the TIST, when they carry one.
+ *
+ * A new delay is decided about once per second. It goes up immediately,
+ * and only down after it was too large for some time, so that it does not
+ * follow every short burst.
+ */
+class EdiDelayEstimator
+{
+public:
+    static constexpr double frame_duration_ms = 24.0;
+
+    EdiDelayEstimator(double min_delay_ms, double max_delay_ms, double target_loss);
+
+    /* Add the arrival time of a frame. tx_time is the time at which the frame
+     * has to be transmitted, if the frame has a timestamp.
+     * Returns true if the delay in number of frames changed. */
+    bool add_frame(std::chrono::system_clock::time_point rx_time, uint16_t dlfc,
+            const std::optional<std::chrono::system_clock::time_point>& tx_time);
+
+    // Delay in number of frames, rounded up, and at least 1
+    size_t get_delay_frames(void) const;
+
+    struct stats_t {
+        // Reception delay in use, in milliseconds
+        double delay_ms = 0.0;
+
+        // Quantiles of the delay variation, in milliseconds
+        double p50_ms = 0.0;
+        double p90_ms = 0.0;
+        double p99_ms = 0.0;
+        double p999_ms = 0.0;
+
+        // Smallest margin between arrival and transmission time,
+        // if the frames carry a timestamp.
+        std::optional<double> tist_margin_ms;
+    };
+
+    stats_t get_stats(void) const;
+
+private:
+    void evaluate(void);
+
+    const double m_min_delay_ms;
+    const double m_max_delay_ms;
+    const double m_target_loss;
+
+    // Nominal emission time of the last frame, derived from its DLFC
+    std::optional<std::chrono::system_clock::time_point> m_nominal_time;
+    uint16_t m_last_dlfc = 0;
+
+    // Transit delays and TIST margins of the recent frames, in
+    // milliseconds, in circular buffers.
+    std::vector<double> m_transit_ms;
+    std::vector<double> m_margin_ms;
+    size_t m_num_samples = 0;
+    size_t m_num_margins = 0;
+    size_t m_frames_since_evaluation = 0;
+    std::vector<double> m_scratch;
+
+    // Number of evaluations in a row that asked for a smaller delay, and
+    // the largest delay they asked for.
+    size_t m_num_smaller = 0;
+    double m_largest_smaller_ms = 0.0;
+
+    mutable std::mutex m_stats_mutex;
+    stats_t m_stats;
+};
+
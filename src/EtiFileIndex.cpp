@@ -0,0 +1,265 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include "EtiFileIndex.h"
+#include "InputReader.h"
+#include "TimestampDecoder.h"
+#include "Eti.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <errno.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+static const char INDEX_MAGIC[8] = {'E', 'T', 'I', 'I', 'N', 'D', 'E', 'X'};
+static constexpr uint32_t INDEX_VERSION = 1;
+
+// Beginning of the sidecar file, followed by the entries
+struct index_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t file_size;
+    int64_t file_mtime;
+    uint64_t num_entries;
+};
+
+EtiFileIndex::EtiFileIndex(const std::string& filename) :
+    m_filename(filename)
+{
+    struct stat inputFileStat;
+    if (stat(m_filename.c_str(), &inputFileStat) != 0) {
+        throw runtime_error("Unable to stat ETI file " + m_filename + ": " +
+                strerror(errno));
+    }
+    m_file_size = inputFileStat.st_size;
+    m_file_mtime = inputFileStat.st_mtime;
+
+    if (load()) {
+        etiLog.level(info) << "Loaded index of " << m_entries.size() <<
+            " frames from " << sidecar_filename(m_filename);
+    }
+    else {
+        build();
+        save();
+    }
+
+    for (size_t frame = 0; frame < m_entries.size(); frame++) {
+        const auto& entry = m_entries[frame];
+        if (entry.seconds != 0) {
+            m_times.push_back({entry.seconds + entry.tist_ms / 1000.0, frame});
+        }
+    }
+
+    // Keeps the frames with the same time in file order
+    stable_sort(m_times.begin(), m_times.end(),
+            [](const time_entry_t& a, const time_entry_t& b) {
+                return a.time < b.time;
+            });
+}
+
+bool EtiFileIndex::load()
+{
+    FILE* fd = fopen(sidecar_filename(m_filename).c_str(), "r");
+    if (fd == nullptr) {
+        return false;
+    }
+
+    index_header_t header;
+    bool valid = fread(&header, sizeof(header), 1, fd) == 1 and
+        memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 and
+        header.version == INDEX_VERSION and
+        header.entry_size == sizeof(entry_t) and
+        header.file_size == m_file_size and
+        header.file_mtime == m_file_mtime and
+        header.num_entries <= m_file_size;
+
+    if (valid) {
+        m_entries.resize(header.num_entries);
+        valid = fread(m_entries.data(), sizeof(entry_t), m_entries.size(), fd) ==
+            m_entries.size();
+    }
+    fclose(fd);
+
+    if (not valid) {
+        etiLog.level(info) << "Index " << sidecar_filename(m_filename) <<
+            " does not match the ETI file";
+        m_entries.clear();
+    }
+    return valid;
+}
+
+void EtiFileIndex::build()
+{
+    using namespace std::chrono;
+
+    etiLog.level(info) << "Building the index of ETI file " << m_filename;
+    const auto start = steady_clock::now();
+
+    InputFileReader reader;
+    if (reader.Open(m_filename, false) != 0) {
+        throw runtime_error("Unable to open ETI file " + m_filename);
+    }
+    if (not reader.IsSeekable()) {
+        throw runtime_error("ETI input " + m_filename + " is not a regular file");
+    }
+
+    // Decode the timestamps the same way the EtiReader does
+    double no_offset = 0.0;
+    TimestampDecoder timestamp_decoder(no_offset);
+
+    while (true) {
+        entry_t entry = {};
+        entry.offset = reader.GetPosition();
+
+        const uint8_t *frame = nullptr;
+        const int frame_size = reader.GetNextFrameView(frame);
+        if (frame_size == 0) {
+            break;
+        }
+        else if (frame_size < 0) {
+            throw runtime_error("Unable to read frame " +
+                    to_string(m_entries.size()) + " of ETI file " + m_filename);
+        }
+
+        if (frame_size >= 8) {
+            eti_FC fc;
+            memcpy(&fc, frame + 4, sizeof(fc));
+            entry.fct = fc.FCT;
+            entry.fp = fc.FP & 0x3;
+
+            // The EOH follows the STC, the TIST follows the EOF
+            const size_t eoh_pos = 8 + 4 * fc.NST;
+            const size_t tist_pos = 8 + 4 * fc.getFrameLength() + 4;
+            if (eoh_pos + sizeof(eti_EOH) <= (size_t)frame_size and
+                    tist_pos + sizeof(eti_TIST) <= (size_t)frame_size) {
+                eti_EOH eoh;
+                memcpy(&eoh, frame + eoh_pos, sizeof(eoh));
+                eti_TIST tist;
+                memcpy(&tist, frame + tist_pos, sizeof(tist));
+
+                uint32_t pps = ntohl(tist.TIST) & 0xFFFFFF;
+                if (pps == 0xFFFFFF) {
+                    pps = 0;
+                }
+
+                timestamp_decoder.updateTimestampEti(entry.fp, eoh.MNSC, pps, entry.fct);
+                const auto ts = timestamp_decoder.getTimestamp();
+                if (ts.timestamp_valid) {
+                    entry.seconds = ts.timestamp_sec;
+                    entry.tist_ms = ts.timestamp_pps / 16384;
+                }
+            }
+        }
+
+        m_entries.push_back(entry);
+    }
+
+    etiLog.level(info) << "Indexed " << m_entries.size() << " frames in " <<
+        duration_cast<milliseconds>(steady_clock::now() - start).count() << " ms";
+}
+
+void EtiFileIndex::save() const
+{
+    const string filename = sidecar_filename(m_filename);
+    const string tmp_filename = filename + ".tmp";
+
+    index_header_t header;
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.entry_size = sizeof(entry_t);
+    header.file_size = m_file_size;
+    header.file_mtime = m_file_mtime;
+    header.num_entries = m_entries.size();
+
+    // Write to a temporary file first, so that an interrupted write never
+    // leaves an index that looks valid
+    bool success = false;
+    FILE* fd = fopen(tmp_filename.c_str(), "w");
+    if (fd) {
+        success = fwrite(&header, sizeof(header), 1, fd) == 1 and
+            fwrite(m_entries.data(), sizeof(entry_t), m_entries.size(), fd) ==
+            m_entries.size();
+        success = (fclose(fd) == 0) and success;
+        success = success and rename(tmp_filename.c_str(), filename.c_str()) == 0;
+    }
+
+    if (not success) {
+        etiLog.level(warn) << "Unable to save the ETI file index " << filename <<
+            ": " << strerror(errno);
+        remove(tmp_filename.c_str());
+    }
+}
+
+size_t EtiFileIndex::find_time(double unix_time) const
+{
+    const auto it = lower_bound(m_times.begin(), m_times.end(), unix_time,
+            [](const time_entry_t& entry, double t) {
+                return entry.time < t;
+            });
+    return it == m_times.end() ? m_entries.size() : it->frame;
+}
+
+double EtiFileIndex::parse_time(const std::string& time)
+{
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char *end = strptime(time.c_str(), "%Y-%m-%dT%H:%M:%S", &tm);
+    if (end != nullptr) {
+        if (*end == 'Z') {
+            end++;
+        }
+        if (*end == '\0') {
+            return timegm(&tm);
+        }
+    }
+
+    size_t idx = 0;
+    double unix_time = 0;
+    try {
+        unix_time = stod(time, &idx);
+    }
+    catch (const logic_error&) {
+        idx = 0;
+    }
+
+    if (idx == 0 or idx != time.size() or unix_time < 0) {
+        throw invalid_argument("Invalid time '" + time +
+                "', expected a UNIX timestamp or YYYY-MM-DDTHH:MM:SSZ");
+    }
+    return unix_time;
+}
+
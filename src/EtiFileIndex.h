@@ -0,0 +1,101 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Index of the frames of an ETI file, which gives the position in the file
+ * of every frame, together with its FCT and its timestamp as decoded from
+ * the MNSC and the TIST.
+ *
+ * Building the index requires reading the whole file. It is therefore
+ * saved into a sidecar file next to the ETI file, with the suffix .idx,
+ * and reused as long as the size and modification time of the ETI file
+ * do not change.
+ */
+class EtiFileIndex
+{
+    public:
+        struct entry_t {
+            // Position of the frame in the file, including its size field
+            uint64_t offset;
+
+            // Timestamp of the frame, in UNIX seconds, without the TIST
+            // offset of the modulator. 0 if the timestamp is not valid.
+            uint32_t seconds;
+
+            // Milliseconds of the TIST
+            uint16_t tist_ms;
+
+            uint8_t fct;
+            uint8_t fp;
+        };
+
+        /* Load the index of the ETI file from its sidecar file, or build it
+         * if it is missing or outdated, and try to save it. Throws a
+         * std::runtime_error if the ETI file cannot be read. */
+        EtiFileIndex(const std::string& filename);
+
+        size_t size() const { return m_entries.size(); }
+        const entry_t& operator[](size_t frame) const { return m_entries[frame]; }
+
+        /* Return the number of the frame with the earliest timestamp not
+         * earlier than unix_time, or size() if there is none. Frames
+         * without a valid timestamp are skipped. */
+        size_t find_time(double unix_time) const;
+
+        /* Parse a time given as UNIX timestamp, or as YYYY-MM-DDTHH:MM:SSZ
+         * in UTC. Throws std::invalid_argument if it is invalid. */
+        static double parse_time(const std::string& time);
+
+        static std::string sidecar_filename(const std::string& filename) {
+            return filename + ".idx";
+        }
+
+    private:
+        bool load();
+        void build();
+        void save() const;
+
+        std::string m_filename;
+        uint64_t m_file_size = 0;
+        int64_t m_file_mtime = 0;
+
+        std::vector<entry_t> m_entries;
+
+        // The frames with a valid timestamp, sorted by time
+        struct time_entry_t {
+            double time;
+            size_t frame;
+        };
+        std::vector<time_entry_t> m_times;
+};
+
@@ -29,6 +29,8 @@
 #include "PcDebug.h"
 #include "TimestampDecoder.h"
 #include "edi/common.hpp"
+#include "Utils.h"
+#include "crc.h"
 
 #include <stdexcept>
 #include <memory>
@@ -36,6 +38,7 @@
 #include <string.h>
 #include <arpa/inet.h>
 #include <regex>
+#include <cmath>
 
 using namespace std;
 
@@ -92,16 +95,40 @@ const std::vector<std::shared_ptr<SubchannelSource> > EtiReader::getSubchannels(
 
 int EtiReader::loadEtiData(const Buffer& dataIn)
 {
-    PDEBUG("EtiReader::loadEtiData(dataIn: %p)\n", &dataIn);
+    return loadEtiData(reinterpret_cast<const uint8_t*>(dataIn.getData()),
+            dataIn.getLength());
+}
+
+int EtiReader::loadEtiFrame(const uint8_t *frame, size_t len)
+{
+    const int bytes_read = loadEtiData(frame, len);
+
+    if (state == EtiReaderState::Pad) {
+        // The padding was removed from the frame
+        state = EtiReaderState::Sync;
+    }
+    else if (state != EtiReaderState::Sync) {
+        // Do not carry an incomplete frame over to the next one
+        state = EtiReaderState::Sync;
+        throw std::runtime_error("Incomplete ETI frame of " +
+                std::to_string(len) + " bytes");
+    }
+
+    return bytes_read;
+}
+
+int EtiReader::loadEtiData(const uint8_t *data, size_t len)
+{
+    PDEBUG("EtiReader::loadEtiData(data: %p, len: %zu)\n", data, len);
     PDEBUG(" state: %u\n", state);
-    const unsigned char* in = reinterpret_cast<const unsigned char*>(dataIn.getData());
-    size_t input_size = dataIn.getLength();
+    const unsigned char* in = data;
+    size_t input_size = len;
 
     while (input_size > 0) {
         switch (state) {
             case EtiReaderState::NbFrame:
                 if (input_size < 4) {
-                    return dataIn.getLength() - input_size;
+                    return len - input_size;
                 }
                 nb_frames = *(uint32_t*)in;
                 input_size -= 4;
@@ -111,7 +138,7 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
                 break;
             case EtiReaderState::FrameSize:
                 if (input_size < 2) {
-                    return dataIn.getLength() - input_size;
+                    return len - input_size;
                 }
                 framesize = *(uint16_t*)in;
                 input_size -= 2;
@@ -121,9 +148,11 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
                 break;
             case EtiReaderState::Sync:
                 if (input_size < 4) {
-                    return dataIn.getLength() - input_size;
+                    return len - input_size;
                 }
                 framesize = 6144;
+                header_crc = 0xffff;
+                mst_crc = 0xffff;
                 memcpy(&eti_sync, in, 4);
                 input_size -= 4;
                 framesize -= 4;
@@ -134,9 +163,10 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
                 break;
             case EtiReaderState::Fc:
                 if (input_size < 4) {
-                    return dataIn.getLength() - input_size;
+                    return len - input_size;
                 }
                 memcpy(&eti_fc, in, 4);
+                header_crc = crc16(header_crc, in, 4);
                 eti_fc_valid = true;
                 input_size -= 4;
                 framesize -= 4;
@@ -159,7 +189,7 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
                 break;
             case EtiReaderState::Nst:
                 if (input_size < 4 * (size_t)eti_fc.NST) {
-                    return dataIn.getLength() - input_size;
+                    return len - input_size;
                 }
                 if ((eti_stc.size() != eti_fc.NST) ||
                         (memcmp(&eti_stc[0], in, 4 * eti_fc.NST))) {
@@ -182,6 +212,7 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
                         PDEBUG(" Stc%i.stl: %u\n", i, eti_stc[i].getSTL());
                     }
                 }
+                header_crc = crc16(header_crc, in, 4 * eti_fc.NST);
                 input_size -= 4 * eti_fc.NST;
                 framesize -= 4 * eti_fc.NST;
                 in += 4 * eti_fc.NST;
@@ -189,34 +220,41 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
                 break;
             case EtiReaderState::Eoh:
                 if (input_size < 4) {
-                    return dataIn.getLength() - input_size;
+                    return len - input_size;
                 }
                 memcpy(&eti_eoh, in, 4);
+                // The header CRC covers FC, STC and MNSC
+                header_crc = crc16(header_crc, in, 2) ^ 0xffff;
                 input_size -= 4;
                 framesize -= 4;
                 in += 4;
                 state = EtiReaderState::Fic;
                 PDEBUG("Eoh.mnsc: 0x%.4x\n", eti_eoh.MNSC);
                 PDEBUG("Eoh.crc: 0x%.4x\n", eti_eoh.CRC);
+                if (header_crc != ntohs(eti_eoh.CRC)) {
+                    etiLog.level(warn) << "ETI header CRC error";
+                }
                 break;
             case EtiReaderState::Fic:
                 if (eti_fc.MID == 3) {
                     if (input_size < 128) {
-                        return dataIn.getLength() - input_size;
+                        return len - input_size;
                     }
                     PDEBUG("Writing 128 bytes of FIC channel data\n");
                     Buffer fic(128, in);
                     myFicSource->loadFicData(fic);
+                    mst_crc = crc16(mst_crc, in, 128);
                     input_size -= 128;
                     framesize -= 128;
                     in += 128;
                 } else {
                     if (input_size < 96) {
-                        return dataIn.getLength() - input_size;
+                        return len - input_size;
                     }
                     PDEBUG("Writing 96 bytes of FIC channel data\n");
                     Buffer fic(96, in);
                     myFicSource->loadFicData(fic);
+                    mst_crc = crc16(mst_crc, in, 96);
                     input_size -= 96;
                     framesize -= 96;
                     in += 96;
@@ -224,11 +262,21 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
                 state = EtiReaderState::Subch;
                 break;
             case EtiReaderState::Subch:
+                {
+                    size_t mst_size = 0;
+                    for (const auto& source : mySources) {
+                        mst_size += source->framesize();
+                    }
+                    if (input_size < mst_size) {
+                        return len - input_size;
+                    }
+                }
                 for (size_t i = 0; i < eti_stc.size(); ++i) {
                     unsigned size = mySources[i]->framesize();
                     PDEBUG("Writting %i bytes of subchannel data\n", size);
                     Buffer subch(size, in);
                     mySources[i]->loadSubchannelData(std::move(subch));
+                    mst_crc = crc16(mst_crc, in, size);
                     input_size -= size;
                     framesize -= size;
                     in += size;
@@ -237,7 +285,7 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
                 break;
             case EtiReaderState::Eof:
                 if (input_size < 4) {
-                    return dataIn.getLength() - input_size;
+                    return len - input_size;
                 }
                 memcpy(&eti_eof, in, 4);
                 input_size -= 4;
@@ -246,10 +294,14 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
                 state = EtiReaderState::Tist;
                 PDEBUG("Eof.crc: %#.4x\n", eti_eof.CRC);
                 PDEBUG("Eof.rfu: %#.4x\n", eti_eof.RFU);
+                // The EOF CRC covers the MST, i.e. the FIC and the subchannels
+                if ((mst_crc ^ 0xffff) != ntohs(eti_eof.CRC)) {
+                    etiLog.level(warn) << "ETI MST CRC error";
+                }
                 break;
             case EtiReaderState::Tist:
                 if (input_size < 4) {
-                    return dataIn.getLength() - input_size;
+                    return len - input_size;
                 }
                 memcpy(&eti_tist, in, 4);
                 input_size -= 4;
@@ -280,7 +332,7 @@ int EtiReader::loadEtiData(const Buffer& dataIn)
 
     myFicSource->loadTimestamp(myTimestampDecoder.getTimestamp());
 
-    return dataIn.getLength() - input_size;
+    return len - input_size;
 }
 
 uint32_t EtiReader::getPPSOffset()
@@ -296,8 +348,7 @@ uint32_t EtiReader::getPPSOffset()
 }
 
 EdiReader::EdiReader(double& tist_offset_s) :
-    m_timestamp_decoder(tist_offset_s),
-    m_fic_decoder(/*verbose*/ false)
+    m_timestamp_decoder(tist_offset_s)
 {
     rcs.enrol(&m_timestamp_decoder);
 }
@@ -357,16 +408,93 @@ bool EdiReader::isFrameReady()
 void EdiReader::clearFrame()
 {
     m_frameReady = false;
-    m_proto_valid = false;
     m_fc_valid = false;
-    m_fic.clear();
 }
 
-void EdiReader::update_protocol(
+void EdiReader::loadFrame(EdiFrame& frame)
+{
+    m_frameReady = false;
+    m_fc_valid = false;
+
+    for (size_t i = 0; i < frame.num_subchannels; i++) {
+        auto& stc = frame.subchannels[i];
+        if (m_sources.count(stc.stream_index) == 0) {
+            m_sources[stc.stream_index] = make_shared<SubchannelSource>(stc.sad, stc.stl(), stc.tpl);
+        }
+
+        auto& source = m_sources[stc.stream_index];
+
+        if (source->framesize() != stc.mst.getLength()) {
+            throw std::invalid_argument(
+                    "EDI: MST data length inconsistent with FIC");
+        }
+        source->swapSubchannelData(stc.mst);
+
+        if (m_sources.size() > 64) {
+            throw std::invalid_argument("Too many subchannels");
+        }
+    }
+
+    m_fc = frame.fc;
+
+    if (not myFicSource) {
+        myFicSource = make_shared<FicSource>(m_fc.ficf, m_fc.mid);
+    }
+
+    myFicSource->loadFicData(frame.fic);
+
+    // Accept zero subchannels, because of an edge-case that can happen
+    // during reconfiguration. See ETS 300 799 Clause 5.3.3
+
+    if (frame.utco == 0 and frame.seconds == 0) {
+        // We don't support relative-only timestamps
+        m_fc.tsta = 0xFFFFFF; // disable TSTA
+    }
+
+    /* According to Annex F
+     *  EDI = UTC + UTCO
+     * We need UTC = EDI - UTCO
+     *
+     * The seconds value is given in number of seconds since
+     * 1.1.2000
+     */
+    const std::time_t posix_timestamp_1_jan_2000 = 946684800;
+    auto utc_ts = posix_timestamp_1_jan_2000 + frame.seconds - frame.utco;
+
+    m_timestamp_decoder.updateTimestampEdi(utc_ts, m_fc.tsta, m_fc.fct(), m_fc.fp);
+
+    myFicSource->loadTimestamp(m_timestamp_decoder.getTimestamp());
+
+    m_fc_valid = true;
+    m_frameReady = true;
+}
+
+void EdiFrame::clear()
+{
+    fc = {};
+    fic.setLength(0);
+    err = 0;
+    utco = 0;
+    seconds = 0;
+    mnsc = 0xffff;
+    rfu = 0xffff;
+    num_subchannels = 0;
+}
+
+EdiFrameCollector::EdiFrameCollector(const frame_callback_t& callback) :
+    m_callback(callback),
+    m_fic_decoder(/*verbose*/ false)
+{ }
+
+void EdiFrameCollector::update_protocol(
         const std::string& proto,
         uint16_t major,
         uint16_t minor)
 {
+    // A new frame begins
+    m_frame.clear();
+    m_fc_valid = false;
+
     m_proto_valid = (proto == "DETI" and major == 0 and minor == 0);
 
     if (not m_proto_valid) {
@@ -374,50 +502,53 @@ void EdiReader::update_protocol(
     }
 }
 
-void EdiReader::update_err(uint8_t err)
+void EdiFrameCollector::update_err(uint8_t err)
 {
     if (not m_proto_valid) {
         throw std::logic_error("Cannot update ERR before protocol");
     }
-    m_err = err;
+    m_frame.err = err;
 }
 
-void EdiReader::update_fc_data(const EdiDecoder::eti_fc_data& fc_data)
+void EdiFrameCollector::update_fc_data(const EdiDecoder::eti_fc_data& fc_data)
 {
     if (not m_proto_valid) {
         throw std::logic_error("Cannot update FC before protocol");
     }
 
     m_fc_valid = false;
-    m_fc = fc_data;
+    m_frame.fc = fc_data;
 
-    if (not m_fc.ficf) {
+    if (not m_frame.fc.ficf) {
         throw std::invalid_argument("FIC must be present");
     }
 
-    if (m_fc.mid > 4) {
+    if (m_frame.fc.mid > 4) {
         throw std::invalid_argument("Invalid MID");
     }
 
-    if (m_fc.fp > 7) {
+    if (m_frame.fc.fp > 7) {
         throw std::invalid_argument("Invalid FP");
     }
 
     m_fc_valid = true;
 }
 
-void EdiReader::update_fic(std::vector<uint8_t>&& fic)
+void EdiFrameCollector::update_fic(const EdiDecoder::byte_view& fic)
 {
     if (not m_proto_valid) {
         throw std::logic_error("Cannot update FIC before protocol");
     }
 
-    m_fic_decoder.Process(fic.data(), fic.size());
+    {
+        std::lock_guard<std::mutex> lock(m_fic_decoder_mutex);
+        m_fic_decoder.Process(fic.data(), fic.size());
+    }
 
-    m_fic = std::move(fic);
+    m_frame.fic.setData(fic.data(), fic.size());
 }
 
-void EdiReader::update_edi_time(
+void EdiFrameCollector::update_edi_time(
         uint32_t utco,
         uint32_t seconds)
 {
@@ -425,55 +556,50 @@ void EdiReader::update_edi_time(
         throw std::logic_error("Cannot update time before protocol");
     }
 
-    m_utco = utco;
-    m_seconds = seconds;
-
     // TODO check validity
-    m_time_valid = true;
+    m_frame.utco = utco;
+    m_frame.seconds = seconds;
 }
 
-void EdiReader::update_mnsc(uint16_t mnsc)
+void EdiFrameCollector::update_mnsc(uint16_t mnsc)
 {
     if (not m_proto_valid) {
         throw std::logic_error("Cannot update MNSC before protocol");
     }
 
-    m_mnsc = mnsc;
+    m_frame.mnsc = mnsc;
 }
 
-void EdiReader::update_rfu(uint16_t rfu)
+void EdiFrameCollector::update_rfu(uint16_t rfu)
 {
     if (not m_proto_valid) {
         throw std::logic_error("Cannot update RFU before protocol");
     }
 
-    m_rfu = rfu;
+    m_frame.rfu = rfu;
 }
 
-void EdiReader::add_subchannel(EdiDecoder::eti_stc_data&& stc)
+void EdiFrameCollector::add_subchannel(const EdiDecoder::eti_stc_data& stc)
 {
     if (not m_proto_valid) {
         throw std::logic_error("Cannot add subchannel before protocol");
     }
 
-    if (m_sources.count(stc.stream_index) == 0) {
-        m_sources[stc.stream_index] = make_shared<SubchannelSource>(stc.sad, stc.stl(), stc.tpl);
-    }
-
-    auto& source = m_sources[stc.stream_index];
-
-    if (source->framesize() != stc.mst.size()) {
-        throw std::invalid_argument(
-                "EDI: MST data length inconsistent with FIC");
+    if (m_frame.num_subchannels == m_frame.subchannels.size()) {
+        m_frame.subchannels.emplace_back();
     }
-    source->loadSubchannelData(std::move(stc.mst));
 
-    if (m_sources.size() > 64) {
-        throw std::invalid_argument("Too many subchannels");
-    }
+    // This is the only copy of the subchannel data, the buffer is
+    // then handed over to the SubchannelSource.
+    auto& subch = m_frame.subchannels[m_frame.num_subchannels++];
+    subch.stream_index = stc.stream_index;
+    subch.scid = stc.scid;
+    subch.sad = stc.sad;
+    subch.tpl = stc.tpl;
+    subch.mst.setData(stc.mst.data(), stc.mst.size());
 }
 
-void EdiReader::assemble(EdiDecoder::ReceivedTagPacket&& tagpacket)
+void EdiFrameCollector::assemble(EdiDecoder::ReceivedTagPacket&& tagpacket)
 {
     if (not m_proto_valid) {
         throw std::logic_error("Cannot assemble EDI data before protocol");
@@ -483,58 +609,81 @@ void EdiReader::assemble(EdiDecoder::ReceivedTagPacket&& tagpacket)
         throw std::logic_error("Cannot assemble EDI data without FC");
     }
 
-    if (m_fic.empty()) {
+    if (m_frame.fic.getLength() == 0) {
         throw std::logic_error("Cannot assemble EDI data without FIC");
     }
 
     // ETS 300 799 Clause 5.3.2, but we don't support not having
     // a FIC
-    if (    (m_fc.mid == 3 and m_fic.size() != 32 * 4) or
-            (m_fc.mid != 3 and m_fic.size() != 24 * 4) ) {
+    if (    (m_frame.fc.mid == 3 and m_frame.fic.getLength() != 32 * 4) or
+            (m_frame.fc.mid != 3 and m_frame.fic.getLength() != 24 * 4) ) {
         stringstream ss;
-        ss << "Invalid FIC length " << m_fic.size() <<
-            " for MID " << m_fc.mid;
+        ss << "Invalid FIC length " << m_frame.fic.getLength() <<
+            " for MID " << m_frame.fc.mid;
         throw std::invalid_argument(ss.str());
     }
 
-    if (not myFicSource) {
-        myFicSource = make_shared<FicSource>(m_fc.ficf, m_fc.mid);
+    if (tagpacket.rx_timestamp) {
+        update_rx_jitter(*tagpacket.rx_timestamp, m_frame.fc.dlfc);
+        m_frame.rx_time = *tagpacket.rx_timestamp;
+    }
+    else {
+        m_frame.rx_time = std::chrono::system_clock::now();
     }
 
-    myFicSource->loadFicData(m_fic);
-
-    // Accept zero subchannels, because of an edge-case that can happen
-    // during reconfiguration. See ETS 300 799 Clause 5.3.3
+    m_proto_valid = false;
+    m_fc_valid = false;
+    m_callback(m_frame);
+    m_frame.clear();
+}
 
-    if (m_utco == 0 and m_seconds == 0) {
-        // We don't support relative-only timestamps
-        m_fc.tsta = 0xFFFFFF; // disable TSTA
-    }
+void EdiFrameCollector::update_rx_jitter(
+        std::chrono::system_clock::time_point rx_timestamp, uint16_t dlfc)
+{
+    using namespace std::chrono;
 
-    /* According to Annex F
-     *  EDI = UTC + UTCO
-     * We need UTC = EDI - UTCO
-     *
-     * The seconds value is given in number of seconds since
-     * 1.1.2000
-     */
-    const std::time_t posix_timestamp_1_jan_2000 = 946684800;
-    auto utc_ts = posix_timestamp_1_jan_2000 + m_seconds - m_utco;
+    // The DLFC counts frames modulo 5000. Restart the estimation after
+    // an interruption of more than ten seconds.
+    const uint16_t frames_elapsed = (dlfc + 5000 - m_last_dlfc) % 5000;
 
-    m_timestamp_decoder.updateTimestampEdi(utc_ts, m_fc.tsta, m_fc.fct(), m_fc.fp);
+    if (m_last_rx_timestamp and frames_elapsed > 0 and frames_elapsed < 417) {
+        // RFC 3550 Section 6.4.1 with the sender clock given by
+        // the DLFC, in units of 24ms.
+        const auto arrival_diff = rx_timestamp - *m_last_rx_timestamp;
+        const auto d = arrival_diff - frames_elapsed * milliseconds(24);
+        const double d_us = std::abs(duration_cast<nanoseconds>(d).count() / 1000.0);
 
-    myFicSource->loadTimestamp(m_timestamp_decoder.getTimestamp());
+        const double jitter_us = m_rx_jitter_us.load();
+        m_rx_jitter_us.store(jitter_us + (d_us - jitter_us) / 16.0);
+    }
 
-    m_frameReady = true;
+    m_last_rx_timestamp = rx_timestamp;
+    m_last_dlfc = dlfc;
 }
 
+// Number of recent AF packets or Pseq for which the first arrival is kept
+static constexpr size_t EDI_FIRST_ARRIVALS_SIZE = 256;
+
+// With several TCP sources, inactivity after which a source gets checked
+// for a half-closed connection, and delay between reconnection attempts
+// after an error.
+static constexpr auto EDI_TCP_IDLE_CHECK = chrono::seconds(5);
+static constexpr auto EDI_TCP_RETRY_DELAY = chrono::seconds(1);
+
 EdiTransport::EdiTransport(EdiDecoder::ETIDecoder& decoder) :
     m_enabled(false),
-    m_port(0),
-    m_bindto("0.0.0.0"),
-    m_mcastaddr("0.0.0.0"),
-    m_decoder(decoder) { }
-
+    m_decoder(decoder),
+    m_first_arrivals(EDI_FIRST_ARRIVALS_SIZE) { }
+
+EdiTransport::tcp_source_t::tcp_source_t(
+        const std::string& uri, const std::string& hostname, int port) :
+    hostname(hostname),
+    port(port),
+    framer("EDI TCP input " + uri, StreamFramer::edi_framing),
+    last_data(chrono::steady_clock::now())
+{
+    client.connect(hostname, port);
+}
 
 void EdiTransport::Open(const std::string& uri)
 {
@@ -551,29 +700,37 @@ void EdiTransport::Open(const std::string& uri)
             throw std::invalid_argument("EDI UDP input port must be provided");
         }
 
-        m_port = std::stoi(uri.substr(found_port+1));
+        const int port = std::stoi(uri.substr(found_port+1));
+        std::string bindto = "0.0.0.0";
+        std::string mcastaddr = "0.0.0.0";
         std::string host_full = uri.substr(6, found_port-6);// skip udp://
         size_t found_mcast = host_full.find_first_of("@"); //have multicast address:
         if (found_mcast != string::npos) {
             if (found_mcast > 0) {
-                m_bindto = host_full.substr(0, found_mcast);
+                bindto = host_full.substr(0, found_mcast);
             }
-            m_mcastaddr = host_full.substr(found_mcast+1);
+            mcastaddr = host_full.substr(found_mcast+1);
         }
         else if (found_port != 6) {
-            m_bindto = host_full;
+            bindto = host_full;
         }
 
-        etiLog.level(info) << "EDI UDP input: host:" << m_bindto <<
-            ", source:" << m_mcastaddr << ", port:" << m_port;
+        etiLog.level(info) << "EDI UDP input: host:" << bindto <<
+            ", source:" << mcastaddr << ", port:" << port;
 
-        m_udp_rx.add_receive_port(m_port, m_bindto, m_mcastaddr);
+        const int rcvbuf_size = m_udp_rx.add_receive_port(
+                port, bindto, mcastaddr, m_rcvbuf_size);
+        if (rcvbuf_size < m_rcvbuf_size) {
+            etiLog.level(warn) << "EDI UDP input: receive buffer limited to " <<
+                rcvbuf_size << " bytes instead of " << m_rcvbuf_size <<
+                ", increase net.core.rmem_max";
+        }
         m_proto = Proto::UDP;
         m_enabled = true;
     }
     else if (proto == "tcp://") {
-        if (m_proto != Proto::Unspecified) {
-            throw std::invalid_argument("Cannot call Open several times with TCP");
+        if (m_proto == Proto::UDP) {
+            throw std::invalid_argument("Cannot specify both TCP and UDP urls");
         }
 
         size_t found_port = uri.find_first_of(":", 6);
@@ -581,19 +738,98 @@ void EdiTransport::Open(const std::string& uri)
             throw std::invalid_argument("EDI TCP input port must be provided");
         }
 
-        m_port = std::stoi(uri.substr(found_port+1));
+        const int port = std::stoi(uri.substr(found_port+1));
         const std::string hostname = uri.substr(6, found_port-6);
 
-        etiLog.level(info) << "EDI TCP connect to " << hostname << ":" << m_port;
+        etiLog.level(info) << "EDI TCP connect to " << hostname << ":" << port;
 
-        m_tcp_uri = uri;
-        m_tcpclient.connect(hostname, m_port);
+        if (m_tcp_uri.empty()) {
+            m_tcp_uri = uri;
+        }
+        m_tcp_sources.push_back(make_unique<tcp_source_t>(uri, hostname, port));
         m_proto = Proto::TCP;
         m_enabled = true;
     }
     else {
         throw std::invalid_argument("ETI protocol '" + proto + "' unknown");
     }
+
+    m_source_states.emplace_back();
+
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    source_stats_t stats;
+    stats.uri = uri;
+    m_source_stats.push_back(stats);
+}
+
+void EdiTransport::account_packet(size_t source_index, const uint8_t *data, size_t len,
+        std::chrono::system_clock::time_point rx_time)
+{
+    // Identify the AF packet or the Pseq the packet belongs to, from the
+    // AF SEQ or the PFT Pseq field.
+    uint16_t seq = 0;
+    bool seq_found = false;
+    if (len >= 8 and data[0] == 'A' and data[1] == 'F') {
+        seq = ((uint16_t)data[6] << 8) | data[7];
+        seq_found = true;
+    }
+    else if (len >= 4 and data[0] == 'P' and data[1] == 'F') {
+        seq = ((uint16_t)data[2] << 8) | data[3];
+        seq_found = true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    auto& stats = m_source_stats.at(source_index);
+    stats.num_packets++;
+
+    auto& state = m_source_states.at(source_index);
+    if (not seq_found or (state.seq_valid and state.last_seq == seq)) {
+        // Further fragments of the same Pseq
+        return;
+    }
+
+    // SEQ and Pseq wrap at 0xFFFF, unsigned integer overflow is intentional
+    if (state.seq_valid) {
+        const uint16_t seq_diff = seq - state.last_seq;
+        if (seq_diff > 1 and seq_diff < 0x8000) {
+            stats.num_missed += seq_diff - 1;
+        }
+    }
+    state.seq_valid = true;
+    state.last_seq = seq;
+
+    double lag_us = 0.0;
+    auto& first = m_first_arrivals[seq % m_first_arrivals.size()];
+    if (first.valid and first.seq == seq) {
+        using namespace std::chrono;
+        lag_us = std::max<double>(0.0,
+                duration_cast<nanoseconds>(rx_time - first.time).count() / 1000.0);
+    }
+    else {
+        first.valid = true;
+        first.seq = seq;
+        first.time = rx_time;
+        stats.num_first++;
+    }
+
+    stats.lag_us += (lag_us - stats.lag_us) / 16.0;
+}
+
+void EdiTransport::push_to_decoder(size_t source_index, int received_on_port,
+        const uint8_t *data, size_t len,
+        const std::optional<std::chrono::system_clock::time_point>& rx_timestamp)
+{
+    account_packet(source_index, data, len,
+            rx_timestamp ? *rx_timestamp : chrono::system_clock::now());
+
+    // m_packet keeps its buffer, this does not allocate
+    m_packet.buf.assign(data, data + len);
+    m_packet.received_on_port = received_on_port;
+    m_packet.rx_timestamp = rx_timestamp;
+
+    const auto t0 = chrono::steady_clock::now();
+    m_decoder.push_packet(m_packet);
+    m_decode_time += chrono::steady_clock::now() - t0;
 }
 
 bool EdiTransport::rxPacket()
@@ -606,17 +842,25 @@ bool EdiTransport::rxPacket()
             }
         case Proto::UDP:
             {
-                Socket::InetAddress received_from;
                 try {
-                    auto received_packets = m_udp_rx.receive(100);
-                    for (auto rp : received_packets) {
-                        received_from = rp.received_from;
-
-                        EdiDecoder::Packet p;
-                        p.buf = std::move(rp.packetdata);
-                        p.received_on_port = rp.port_received_on;
-                        m_decoder.push_packet(p);
-                    }
+                    m_udp_rx.receive_batch(100,
+                            [&](const Socket::UDPPacket& packet, int port, size_t socket_index) {
+                                // A malformed packet must not drop the rest
+                                // of the batch
+                                try {
+                                    push_to_decoder(socket_index, port,
+                                            packet.buffer.data(), packet.buffer.size(),
+                                            packet.rx_timestamp);
+                                }
+                                catch (const invalid_argument& e) {
+                                    etiLog.level(warn) << "Invalid EDI packet on port " <<
+                                        port << ": " << e.what();
+                                }
+                                catch (const runtime_error& e) {
+                                    etiLog.level(warn) << "Error decoding EDI packet on port " <<
+                                        port << ": " << e.what();
+                                }
+                            });
                     return true;
                 }
                 catch (const Socket::UDPReceiver::Timeout&) {
@@ -625,16 +869,6 @@ bool EdiTransport::rxPacket()
                 catch (const Socket::UDPReceiver::Interrupted&) {
                     return false;
                 }
-                catch (const invalid_argument& e) {
-                    try {
-                        fprintf(stderr, "Invalid argument receiving EDI from %s: %s\n",
-                                received_from.to_string().c_str(), e.what());
-                    }
-                    catch (const invalid_argument& ee) {
-                        fprintf(stderr, "Invalid argument receiving EDI %s\n", e.what());
-                        fprintf(stderr, "Invalid argument converting source address %s\n", ee.what());
-                    }
-                }
                 catch (const runtime_error& e) {
                     fprintf(stderr, "Runtime error UDP Receive: %s\n", e.what());
                 }
@@ -642,37 +876,327 @@ bool EdiTransport::rxPacket()
                 return false;
             }
         case Proto::TCP:
-            {
-                // The buffer size must be smaller than the size of two AF Packets, because otherwise
-                // the EDI decoder decodes two in a row and discards the first. This leads to ETI FCT
-                // discontinuity.
-                m_tcpbuffer.resize(512);
-                const int timeout_ms = 1000;
-
-                ssize_t ret = m_tcpclient.recv(m_tcpbuffer.data(), m_tcpbuffer.size(), 0, timeout_ms);
-                if (ret <= 0) {
-                    return false;
+            return rxPacketTCP();
+    }
+    throw logic_error("Incomplete rxPacket implementation!");
+}
+
+bool EdiTransport::rxPacketTCP()
+{
+    const int timeout_ms = 1000;
+
+    // Returns false if a packet from the source could not be decoded, in
+    // which case the rest of its buffered data is dropped.
+    auto push_framed_packets = [&](size_t source_index) {
+        auto& src = *m_tcp_sources[source_index];
+        const uint8_t *data = nullptr;
+        size_t len = 0;
+        while (src.framer.next_packet(data, len)) {
+            try {
+                push_to_decoder(source_index, source_index, data, len, nullopt);
+            }
+            catch (const logic_error& e) {
+                etiLog.level(warn) << "EDI TCP source " << src.hostname << ":" <<
+                    src.port << ": invalid packet: " << e.what();
+                src.framer.reset();
+                return false;
+            }
+            catch (const runtime_error& e) {
+                etiLog.level(warn) << "EDI TCP source " << src.hostname << ":" <<
+                    src.port << ": decoding error: " << e.what();
+                src.framer.reset();
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (m_tcp_sources.size() == 1) {
+        auto& src = *m_tcp_sources[0];
+        const ssize_t ret = src.framer.fill(src.client, timeout_ms);
+        if (ret == 0) {
+            // Timeout or reconnection, a partial packet cannot be completed
+            src.framer.reset();
+            return false;
+        }
+        else if (ret < 0) {
+            return false;
+        }
+
+        push_framed_packets(0);
+        return true;
+    }
+
+    // With several sources, wait on all of them at once, so that a source
+    // that stalls does not delay the others.
+    m_tcp_pollfds.resize(m_tcp_sources.size());
+    for (size_t i = 0; i < m_tcp_sources.size(); i++) {
+        const auto& src = *m_tcp_sources[i];
+        // poll() ignores negative file descriptors
+        m_tcp_pollfds[i].fd = src.failed ? -1 : src.client.get_sockfd();
+        m_tcp_pollfds[i].events = POLLIN;
+        m_tcp_pollfds[i].revents = 0;
+    }
+
+    const int retval = poll(m_tcp_pollfds.data(), m_tcp_pollfds.size(), timeout_ms);
+    if (retval == -1 and errno == EINTR) {
+        return false;
+    }
+    else if (retval == -1) {
+        std::string errstr(strerror(errno));
+        throw std::runtime_error("EDI TCP receive with poll() error: " + errstr);
+    }
+
+    const auto now = chrono::steady_clock::now();
+    bool received = false;
+
+    for (size_t i = 0; i < m_tcp_sources.size(); i++) {
+        auto& src = *m_tcp_sources[i];
+
+        if (src.failed) {
+            if (now - src.failed_since > EDI_TCP_RETRY_DELAY) {
+                try {
+                    src.client.connect(src.hostname, src.port);
+                    src.framer.reset();
+                    src.failed = false;
+                    src.last_data = now;
                 }
-                else if (ret > (ssize_t)m_tcpbuffer.size()) {
-                    throw logic_error("EDI TCP: invalid recv() return value");
+                catch (const runtime_error&) {
+                    src.failed_since = now;
                 }
-                else {
-                    m_tcpbuffer.resize(ret);
-                    m_decoder.push_bytes(m_tcpbuffer);
-                    return true;
+            }
+            continue;
+        }
+
+        // An error on one source must not stop the reception from the
+        // others.
+        try {
+            if (m_tcp_pollfds[i].revents != 0) {
+                const ssize_t ret = src.framer.fill(src.client, 0);
+                if (ret > 0) {
+                    src.last_data = now;
+                    received = true;
+                    if (not push_framed_packets(i)) {
+                        src.failed = true;
+                        src.failed_since = now;
+                    }
+                }
+                else if (ret == 0) {
+                    // The socket was readable but gave no data: the
+                    // connection was closed and the client reconnected.
+                    // Wait for the retry delay instead of polling the new
+                    // connection right away.
+                    etiLog.level(warn) << "EDI TCP source " << src.hostname <<
+                        ":" << src.port << ": connection closed";
+                    src.framer.reset();
+                    src.failed = true;
+                    src.failed_since = now;
+                }
+            }
+            else if (now - src.last_data > EDI_TCP_IDLE_CHECK) {
+                // Let the client detect a half-closed connection and
+                // reconnect.
+                if (src.framer.fill(src.client, 0) == 0) {
+                    src.framer.reset();
                 }
+                src.last_data = now;
             }
+        }
+        catch (const runtime_error& e) {
+            etiLog.level(warn) << "EDI TCP source " << src.hostname << ":" <<
+                src.port << ": " << e.what();
+            src.framer.reset();
+            src.failed = true;
+            src.failed_since = now;
+        }
     }
-    throw logic_error("Incomplete rxPacket implementation!");
+
+    return received;
+}
+
+std::chrono::steady_clock::duration EdiTransport::takeDecodeTime()
+{
+    auto t = m_decode_time;
+    m_decode_time = std::chrono::steady_clock::duration::zero();
+    return t;
 }
 
+std::vector<EdiTransport::source_stats_t> EdiTransport::getSourceStats() const
+{
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    return m_source_stats;
+}
+
+// Maximum number of decoded frames waiting for the modulator
+static constexpr size_t EDI_MAX_QUEUED_FRAMES = 100;
+
+// Maximum number of frames kept for reuse
+static constexpr size_t EDI_MAX_SPARE_FRAMES = 8;
+
+// Default maximum delay of the PFT reassembly, in AF packets
+static constexpr size_t EDI_DEFAULT_MAX_DELAY = 10;
+
 EdiInput::EdiInput(double& tist_offset_s, float edi_max_delay_ms) :
     ediReader(tist_offset_s),
-    decoder(ediReader),
-    ediTransport(decoder)
+    collector([this](EdiFrame& frame) {
+            measure_delay(frame);
+
+            // Leave a spare frame to the collector, so that the next
+            // frame can be assembled without allocating buffers.
+            EdiFrame complete_frame;
+            m_spare_frames.try_pop(complete_frame);
+            std::swap(complete_frame, frame);
+
+            auto r = m_frames.push_overflow(std::move(complete_frame), EDI_MAX_QUEUED_FRAMES);
+            if (r.overflowed) {
+                etiLog.level(warn) << "EDI input: modulator too slow, dropping frame";
+            }
+            m_num_frames_decoded++;
+        }),
+    decoder(collector),
+    ediTransport(decoder),
+    m_tist_offset_s(tist_offset_s)
 {
+    // setMaxDelay wants number of AF packets, which correspond to 24ms ETI frames
+    size_t max_delay = EDI_DEFAULT_MAX_DELAY;
     if (edi_max_delay_ms > 0.0f) {
-        // setMaxDelay wants number of AF packets, which correspond to 24ms ETI frames
-        decoder.setMaxDelay(lroundf(edi_max_delay_ms / 24.0f));
+        max_delay = lroundf(edi_max_delay_ms / 24.0f);
+        decoder.setMaxDelay(max_delay);
+    }
+
+    // With a fixed delay, the estimator only measures the delay variation
+    const double delay_ms = max_delay * EdiDelayEstimator::frame_duration_ms;
+    m_delay_estimator = make_unique<EdiDelayEstimator>(delay_ms, delay_ms, 0.001);
+}
+
+void EdiInput::setAdaptiveDelay(float min_delay_ms, float max_delay_ms, double target_loss)
+{
+    if (m_running.load()) {
+        throw logic_error("EDI adaptive delay must be set before start");
+    }
+
+    m_delay_estimator = make_unique<EdiDelayEstimator>(min_delay_ms, max_delay_ms, target_loss);
+    m_adaptive_delay = true;
+
+    const size_t delay_frames = m_delay_estimator->get_delay_frames();
+    decoder.setMaxDelay(delay_frames);
+    m_prebuffer_frames.store(delay_frames);
+
+    etiLog.level(info) << "EDI input: adaptive delay between " << min_delay_ms <<
+        " and " << max_delay_ms << " ms, target loss " << target_loss;
+}
+
+void EdiInput::measure_delay(const EdiFrame& frame)
+{
+    using namespace std::chrono;
+
+    // Transmission time of the frame, see EdiReader::loadFrame
+    optional<system_clock::time_point> tx_time;
+    if (frame.fc.atstf and frame.fc.tsta != 0xFFFFFF and
+            not (frame.utco == 0 and frame.seconds == 0)) {
+        const std::time_t posix_timestamp_1_jan_2000 = 946684800;
+        const double tx_secs = (posix_timestamp_1_jan_2000 + frame.seconds - frame.utco) +
+            frame.fc.tsta / 16384000.0 + m_tist_offset_s;
+        tx_time = system_clock::time_point(
+                duration_cast<system_clock::duration>(duration<double>(tx_secs)));
+    }
+
+    if (m_delay_estimator->add_frame(frame.rx_time, frame.fc.dlfc, tx_time) and
+            m_adaptive_delay) {
+        m_pending_max_delay = m_delay_estimator->get_delay_frames();
+    }
+}
+
+EdiInput::~EdiInput()
+{
+    m_running.store(false);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void EdiInput::start()
+{
+    if (m_running.exchange(true)) {
+        throw logic_error("EDI input thread already running");
+    }
+    m_thread = std::thread(&EdiInput::process, this);
+}
+
+void EdiInput::loadNextFrame()
+{
+    if (m_failed.load()) {
+        throw runtime_error(m_error);
+    }
+
+    // When starting, and after an interruption, wait until enough frames
+    // are buffered to absorb the arrival jitter.
+    EdiFrame frame;
+    try {
+        m_frames.wait_and_pop(frame, m_prebuffering ? m_prebuffer_frames.load() : 1);
+    }
+    catch (const ThreadsafeQueueWakeup&) {
+        // The wakeup can also come while frames are still queued, only
+        // an input that ran dry has to fill the buffer again.
+        if (m_frames.empty()) {
+            m_prebuffering = true;
+        }
+        throw;
+    }
+    m_prebuffering = false;
+    ediReader.loadFrame(frame);
+    m_spare_frames.push(std::move(frame), EDI_MAX_SPARE_FRAMES);
+}
+
+void EdiInput::process()
+{
+    set_thread_name("edi_input");
+    set_realtime_prio(1);
+
+    // The decode time of the packets which did not yet complete a frame
+    auto pending_decode_time = std::chrono::steady_clock::duration::zero();
+
+    try {
+        while (m_running.load()) {
+            const size_t num_frames_before = m_num_frames_decoded.load();
+            const bool packet_received = ediTransport.rxPacket();
+            pending_decode_time += ediTransport.takeDecodeTime();
+
+            if (m_pending_max_delay) {
+                const auto stats = m_delay_estimator->get_stats();
+                etiLog.level(info) << "EDI input: delay " << stats.delay_ms <<
+                    " ms, delay variation p50 " << stats.p50_ms << " ms, p99 " <<
+                    stats.p99_ms << " ms";
+                decoder.setMaxDelay(*m_pending_max_delay);
+                m_prebuffer_frames.store(*m_pending_max_delay);
+                m_pending_max_delay.reset();
+            }
+
+            const size_t num_new_frames = m_num_frames_decoded.load() - num_frames_before;
+            if (num_new_frames > 0) {
+                using namespace std::chrono;
+                const double decode_time_us =
+                    duration_cast<microseconds>(pending_decode_time).count() /
+                    (double)num_new_frames;
+                pending_decode_time = steady_clock::duration::zero();
+
+                // Exponential moving average, over about 40 frames
+                const double previous = m_decode_time_us.load();
+                m_decode_time_us.store(previous == 0.0 ?
+                        decode_time_us :
+                        0.975 * previous + 0.025 * decode_time_us);
+            }
+
+            if (not packet_received) {
+                // Nothing was received before the timeout, let the
+                // modulator check if it has to stop
+                m_frames.trigger_wakeup();
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        m_error = e.what();
+        m_failed.store(true);
+        m_frames.trigger_wakeup();
     }
 }
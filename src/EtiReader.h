@@ -31,19 +31,30 @@
 #endif
 
 
+#include "EdiDelayEstimator.h"
 #include "Eti.h"
 #include "Log.h"
 #include "FicSource.h"
 #include "FigParser.h"
 #include "Socket.h"
+#include "StreamFramer.h"
 #include "SubchannelSource.h"
 #include "TimestampDecoder.h"
+#include "ThreadsafeQueue.h"
 #include "lib/edi/ETIDecoder.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
 #include <memory>
 #include <stdint.h>
 #include <sys/types.h>
+#include <poll.h>
 
 /* The modulator uses this interface to get the necessary multiplex data,
  * either from an ETI or an EDI source.
@@ -107,6 +118,13 @@ public:
      * read from the buffer.
      */
     int loadEtiData(const Buffer& dataIn);
+    int loadEtiData(const uint8_t *data, size_t len);
+
+    /* Read one complete ETI frame without copying it, of which the
+     * padding may have been removed. Returns the number of bytes read,
+     * throws if the frame is incomplete.
+     */
+    int loadEtiFrame(const uint8_t *frame, size_t len);
 
     virtual const std::vector<std::shared_ptr<SubchannelSource> > getSubchannels() const override;
 
@@ -125,15 +143,52 @@ private:
     eti_TIST eti_tist;
     TimestampDecoder myTimestampDecoder;
 
+    // CRCs of the frame being read, checked against EOH and EOF
+    uint16_t header_crc = 0xffff;
+    uint16_t mst_crc = 0xffff;
+
     bool eti_fc_valid;
 
     std::vector<std::shared_ptr<SubchannelSource> > mySources;
 };
 
-/* The EdiReader extracts the necessary data using the EDI input library in
- * lib/edi
+/* One ETI frame, as assembled from the EDI data by the EdiFrameCollector.
+ * The frames are recycled, and keep their buffers from one use to the next.
  */
-class EdiReader : public EtiSource, public EdiDecoder::ETIDataCollector
+struct EdiFrame {
+    struct subchannel_t {
+        uint8_t stream_index = 0;
+        uint8_t scid = 0;
+        uint16_t sad = 0;
+        uint8_t tpl = 0;
+        Buffer mst;
+
+        // Return the length of the MST in multiples of 64 bits
+        uint16_t stl(void) const { return mst.getLength() / 8; }
+    };
+
+    EdiDecoder::eti_fc_data fc = {};
+    Buffer fic;
+    uint8_t err = 0;
+    uint32_t utco = 0;
+    uint32_t seconds = 0;
+    uint16_t mnsc = 0xffff;
+    uint16_t rfu = 0xffff;
+
+    // Time at which the packet that completed the frame was received
+    std::chrono::system_clock::time_point rx_time;
+
+    // Only the first num_subchannels entries are part of the frame
+    std::vector<subchannel_t> subchannels;
+    size_t num_subchannels = 0;
+
+    // Reset the frame, without releasing the buffers
+    void clear(void);
+};
+
+/* The EdiReader gives the data of the EdiFrames to the modulator.
+ */
+class EdiReader : public EtiSource
 {
 public:
     EdiReader(double& tist_offset_s);
@@ -144,9 +199,39 @@ public:
     virtual frame_timestamp getTimestamp() override;
     virtual const std::vector<std::shared_ptr<SubchannelSource> > getSubchannels() const override;
 
+    /* Make the frame available to the modulator. The subchannel buffers
+     * get exchanged with those of the SubchannelSources. Throws an
+     * invalid_argument if the subchannels are not consistent with
+     * the previous frames. */
+    void loadFrame(EdiFrame& frame);
+
     virtual bool isFrameReady(void);
     virtual void clearFrame(void);
 
+private:
+    bool m_frameReady = false;
+
+    bool m_fc_valid = false;
+    EdiDecoder::eti_fc_data m_fc;
+
+    std::map<uint8_t, std::shared_ptr<SubchannelSource> > m_sources;
+
+    TimestampDecoder m_timestamp_decoder;
+};
+
+/* The EdiFrameCollector receives the data from the EDI input library in
+ * lib/edi, and assembles it into EdiFrames. It also decodes the FIC to
+ * get the ensemble information.
+ */
+class EdiFrameCollector : public EdiDecoder::ETIDataCollector
+{
+public:
+    // Gets called for every complete frame. The callback may swap
+    // the frame with another one, whose buffers will then be reused.
+    using frame_callback_t = std::function<void(EdiFrame&)>;
+
+    EdiFrameCollector(const frame_callback_t& callback);
+
     // Tell the ETIWriter what EDI protocol we receive in *ptr.
     // This is not part of the ETI data, but is used as check
     virtual void update_protocol(
@@ -157,7 +242,7 @@ public:
     // Update the data for the frame characterisation
     virtual void update_fc_data(const EdiDecoder::eti_fc_data& fc_data) override;
 
-    virtual void update_fic(std::vector<uint8_t>&& fic) override;
+    virtual void update_fic(const EdiDecoder::byte_view& fic) override;
 
     virtual void update_err(uint8_t err) override;
 
@@ -171,85 +256,234 @@ public:
 
     virtual void update_rfu(uint16_t rfu) override;
 
-    virtual void add_subchannel(EdiDecoder::eti_stc_data&& stc) override;
+    virtual void add_subchannel(const EdiDecoder::eti_stc_data& stc) override;
 
     // Gets called by the EDI library to tell us that all data for a frame was given to us
     virtual void assemble(EdiDecoder::ReceivedTagPacket&& tagpacket) override;
 
     std::optional<FIC_ENSEMBLE> getEnsembleInfo() const {
+        std::lock_guard<std::mutex> lock(m_fic_decoder_mutex);
         return m_fic_decoder.observer.ensemble;
     }
 
     std::map<int /*SId*/, LISTED_SERVICE> getServiceInfo() const {
+        std::lock_guard<std::mutex> lock(m_fic_decoder_mutex);
         return m_fic_decoder.observer.services;
     }
 
-private:
-    bool m_proto_valid = false;
-    bool m_frameReady = false;
-
-    uint8_t m_err;
-
-    bool m_fc_valid = false;
-    EdiDecoder::eti_fc_data m_fc;
-
-    std::vector<uint8_t> m_fic;
+    // Interarrival jitter of the frames, in microseconds, estimated from
+    // the kernel receive timestamps of the UDP packets.
+    double getRxJitter_us() const { return m_rx_jitter_us.load(); }
 
-    bool m_time_valid = false;
-    uint32_t m_utco;
-    uint32_t m_seconds;
+private:
+    void update_rx_jitter(std::chrono::system_clock::time_point rx_timestamp, uint16_t dlfc);
 
-    uint16_t m_mnsc = 0xffff;
+    frame_callback_t m_callback;
 
-    // 16 bits: RFU field in EOH
-    uint16_t m_rfu = 0xffff;
+    std::optional<std::chrono::system_clock::time_point> m_last_rx_timestamp;
+    uint16_t m_last_dlfc = 0;
+    std::atomic<double> m_rx_jitter_us = ATOMIC_VAR_INIT(0.0);
 
-    std::map<uint8_t, std::shared_ptr<SubchannelSource> > m_sources;
+    bool m_proto_valid = false;
+    bool m_fc_valid = false;
+    EdiFrame m_frame;
 
-    TimestampDecoder m_timestamp_decoder;
+    // The FIC decoder runs in the input thread, and is read
+    // by the remote control.
+    mutable std::mutex m_fic_decoder_mutex;
     FICDecoder m_fic_decoder;
 };
 
 /* The EDI input does not use the inputs defined in InputReader.h, as they were
  * designed for ETI.
  */
+/* EdiTransport receives the EDI packets and gives them to the decoder.
+ *
+ * Several sources can be opened, either all UDP or all TCP, to receive
+ * the same EDI stream over redundant paths. The packets of all sources
+ * go to the same decoder, which keeps the first copy of every AF packet
+ * or PFT fragment and drops the later ones. A frame is therefore
+ * assembled from whichever source delivers first, and the failure of one
+ * path does not interrupt the output.
+ */
 class EdiTransport {
     public:
         EdiTransport(EdiDecoder::ETIDecoder& decoder);
 
-        /* Can be called once when using TCP, or several times when using UDP */
+        /* Add a source. Can be called several times, with either UDP or
+         * TCP URIs. */
         void Open(const std::string& uri);
 
         bool isEnabled(void) const { return m_enabled; }
         std::string getTcpUri(void) const { return m_tcp_uri; }
 
+        /* Set the size of the kernel receive buffer of the UDP sockets
+         * opened afterwards, in bytes. 0 keeps the system default. */
+        void setReceiveBufferSize(int size) { m_rcvbuf_size = size; }
+
         /* Receive a packet and give it to the decoder. Returns
-         * true if a packet was received, false in case of socket
-         * read was interrupted by a signal.
+         * true if a packet was received, false in case of timeout,
+         * receive error or if the socket read was interrupted by a signal.
+         * Packets that cannot be decoded are logged and dropped.
          */
         bool rxPacket(void);
 
+        /* Return the time spent in the decoder since the previous
+         * call. */
+        std::chrono::steady_clock::duration takeDecodeTime(void);
+
+        struct source_stats_t {
+            std::string uri;
+
+            // Number of packets received
+            size_t num_packets = 0;
+
+            // Number of AF packets or PFT Pseq missing from the sequence
+            // received from this source
+            size_t num_missed = 0;
+
+            // Number of AF packets or PFT Pseq this source delivered before
+            // all other sources
+            size_t num_first = 0;
+
+            // Average delay with which this source delivers an AF packet or
+            // PFT Pseq, compared to the first source that delivered it
+            double lag_us = 0.0;
+        };
+
+        // Statistics of every source, in the order they were opened
+        std::vector<source_stats_t> getSourceStats(void) const;
+
     private:
+        void account_packet(size_t source_index, const uint8_t *data, size_t len,
+                std::chrono::system_clock::time_point rx_time);
+        void push_to_decoder(size_t source_index, int received_on_port,
+                const uint8_t *data, size_t len,
+                const std::optional<std::chrono::system_clock::time_point>& rx_timestamp);
+        bool rxPacketTCP(void);
+
         std::string m_tcp_uri;
         bool m_enabled;
-        int m_port;
-        std::string m_bindto;
-        std::string m_mcastaddr;
+        int m_rcvbuf_size = 0;
 
         enum class Proto { Unspecified, UDP, TCP };
         Proto m_proto = Proto::Unspecified;
         Socket::UDPReceiver m_udp_rx;
-        std::vector<uint8_t> m_tcpbuffer;
-        Socket::TCPClient m_tcpclient;
+        EdiDecoder::Packet m_packet;
         EdiDecoder::ETIDecoder& m_decoder;
+        std::chrono::steady_clock::duration m_decode_time = std::chrono::steady_clock::duration::zero();
+
+        struct tcp_source_t {
+            tcp_source_t(const std::string& uri, const std::string& hostname, int port);
+
+            std::string hostname;
+            int port;
+            Socket::TCPClient client;
+            StreamFramer framer;
+            std::chrono::steady_clock::time_point last_data;
+
+            // Set after a receive error, until the reconnection succeeds
+            bool failed = false;
+            std::chrono::steady_clock::time_point failed_since;
+        };
+        std::vector<std::unique_ptr<tcp_source_t> > m_tcp_sources;
+        std::vector<struct pollfd> m_tcp_pollfds;
+
+        // Indexed like the sources, the UDP sockets and the TCP sources are
+        // both in the order they were opened.
+        struct source_state_t {
+            bool seq_valid = false;
+            uint16_t last_seq = 0;
+        };
+        std::vector<source_state_t> m_source_states;
+
+        // Time of first arrival of the recent AF packets or Pseq, indexed
+        // by the lower bits of the SEQ or Pseq, to measure the lag of the
+        // other sources.
+        struct first_arrival_t {
+            bool valid = false;
+            uint16_t seq = 0;
+            std::chrono::system_clock::time_point time;
+        };
+        std::vector<first_arrival_t> m_first_arrivals;
+
+        mutable std::mutex m_stats_mutex;
+        std::vector<source_stats_t> m_source_stats;
 };
 
-// EdiInput wraps an EdiReader, an EdiDecoder::ETIDecoder and an EdiTransport
+/* EdiInput wraps an EdiReader, an EdiFrameCollector, an EdiDecoder::ETIDecoder
+ * and an EdiTransport.
+ *
+ * The reception, the PFT reassembly and the decoding of the EDI packets run
+ * in a separate thread, so that they do not compete with the modulation. The
+ * complete frames are handed over to the modulator through a queue.
+ */
 class EdiInput {
     public:
         EdiInput(double& tist_offset_s, float edi_max_delay_ms);
+        EdiInput(const EdiInput& other) = delete;
+        EdiInput& operator=(const EdiInput& other) = delete;
+        ~EdiInput();
+
         EdiReader ediReader;
+        EdiFrameCollector collector;
         EdiDecoder::ETIDecoder decoder;
         EdiTransport ediTransport;
-};
 
+        /* Start the input thread, after ediTransport has been opened. */
+        void start(void);
+
+        /* Wait for the next frame and load it into the ediReader.
+         * Throws a ThreadsafeQueueWakeup if no packet arrived for a while,
+         * so that the caller can check if it has to stop, and a
+         * runtime_error if the input thread failed. */
+        void loadNextFrame(void);
+
+        // Number of frames waiting for the modulator
+        size_t getQueueDepth(void) const { return m_frames.size(); }
+
+        // Average time needed to decode one frame, in microseconds
+        double getDecodeTime_us(void) const { return m_decode_time_us.load(); }
+
+        /* Let the PFT reassembly window and the number of frames buffered
+         * before modulating follow the measured arrival jitter, within
+         * the given bounds, instead of using a fixed delay. target_loss is
+         * the fraction of frames that may arrive too late. Call before
+         * start(). */
+        void setAdaptiveDelay(float min_delay_ms, float max_delay_ms, double target_loss);
+
+        // Reception delay in use, and the measured delay variation
+        EdiDelayEstimator::stats_t getDelayStats(void) const { return m_delay_estimator->get_stats(); }
+
+    private:
+        void process(void);
+        void measure_delay(const EdiFrame& frame);
+
+        double& m_tist_offset_s;
+
+        bool m_adaptive_delay = false;
+        std::unique_ptr<EdiDelayEstimator> m_delay_estimator;
+
+        // Set by the input thread when the estimator decided a new delay,
+        // the decoder takes it once the packet is processed.
+        std::optional<size_t> m_pending_max_delay;
+
+        // Number of frames to wait for before the modulator starts, and
+        // after an interruption of the input.
+        std::atomic<size_t> m_prebuffer_frames = ATOMIC_VAR_INIT(1);
+        bool m_prebuffering = true;
+
+        ThreadsafeQueue<EdiFrame> m_frames;
+
+        // Frames given back by the modulator, to be filled again
+        ThreadsafeQueue<EdiFrame> m_spare_frames;
+
+        // Number of frames pushed into the queue
+        std::atomic<size_t> m_num_frames_decoded = ATOMIC_VAR_INIT(0);
+        std::atomic<double> m_decode_time_us = ATOMIC_VAR_INIT(0.0);
+
+        std::atomic<bool> m_running = ATOMIC_VAR_INIT(false);
+        std::atomic<bool> m_failed = ATOMIC_VAR_INIT(false);
+        std::string m_error;
+        std::thread m_thread;
+};
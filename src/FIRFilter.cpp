@@ -10,7 +10,8 @@
    This block implements a FIR filter. The real filter taps are given
    as floats, and the block can take advantage of SSE.
    For better performance, filtering is done in another thread, leading
-   to a pipeline delay of two calls to FIRFilter::process
+   to a pipeline delay of two calls to FIRFilter::process. Each frame
+   is furthermore split into chunks that are filtered by a WorkerPool.
  */
 /*
    This file is part of ODR-DabMod.
@@ -71,9 +72,10 @@ static const std::array<float, 45> default_filter_taps({
         -0.00110450468492});
 
 
-FIRFilter::FIRFilter(std::string& taps_file) :
+FIRFilter::FIRFilter(std::string& taps_file, unsigned int num_threads) :
     PipelinedModCodec(),
     RemoteControllable("firfilter"),
+    m_workers("FIRFilter", num_threads),
     m_taps_file(taps_file)
 {
     PDEBUG("FIRFilter::FIRFilter(%s) @ %p\n",
@@ -82,6 +84,15 @@ FIRFilter::FIRFilter(std::string& taps_file) :
     RC_ADD_PARAMETER(ntaps, "(Read-only) number of filter taps.");
     RC_ADD_PARAMETER(tapsfile, "Filename containing filter taps. When written to, the new file gets automatically loaded.");
 
+    if (num_threads == 0) {
+        etiLog.level(info) << "FIRFilter will use " <<
+            m_workers.num_threads() << " threads (auto detected)";
+    }
+    else {
+        etiLog.level(info) << "FIRFilter will use " <<
+            m_workers.num_threads() << " threads (set in config file)";
+    }
+
     load_filter_taps(m_taps_file);
 
     start_pipeline_thread();
@@ -133,99 +144,111 @@ void FIRFilter::load_filter_taps(const std::string &tapsFile)
         }
     }
 
-    {
-        std::lock_guard<std::mutex> lock(m_taps_mutex);
-
-        m_taps = filter_taps;
-    }
+    m_taps.store(std::move(filter_taps));
 }
 
 
-int FIRFilter::internal_process(Buffer* const dataIn, Buffer* dataOut)
+/* Filter the output range [start, stop) of the frame, where the indices
+ * count floats, not complex samples. start must be a multiple of 4.
+ *
+ * Every output sample depends on the ntaps following complex input samples.
+ * As the whole frame is in memory, a chunk only reads 2*(ntaps-1) floats
+ * beyond its end, and no input needs to be copied. Chunk boundaries do not
+ * change the order of the additions, the output is therefore identical
+ * to the one computed in a single pass.
+ */
+static void filter_chunk(
+        const float *taps, size_t ntaps,
+        const float *in, size_t sizeIn,
+        size_t start, size_t stop, float *out)
 {
-        size_t i;
+    // The unrolled or vectorised loop runs up to this index, identical
+    // for all chunks.
+    const size_t main_stop = (sizeIn > 2*ntaps) ?
+        ((sizeIn - 2*ntaps + 3) / 4) * 4 : 0;
 
-#if __SSE__
-        // The SSE accelerated version cannot work on the complex values,
-        // it is necessary to do the convolution on the real and imaginary
-        // parts separately. Thankfully, the taps are real, simplifying the
-        // procedure.
+    size_t i = start;
 
-        const float* in = reinterpret_cast<const float*>(dataIn->getData());
-        float* out      = reinterpret_cast<float*>(dataOut->getData());
-        size_t sizeIn   = dataIn->getLength() / sizeof(float);
+#if __SSE__
+    // The SSE accelerated version cannot work on the complex values,
+    // it is necessary to do the convolution on the real and imaginary
+    // parts separately. Thankfully, the taps are real, simplifying the
+    // procedure.
 
-        if ((uintptr_t)(&out[0]) % 16 != 0) {
-            throw std::runtime_error("FIRFilterWorker: out not aligned");
-        }
+    if ((uintptr_t)(&out[start]) % 16 != 0) {
+        throw std::runtime_error("FIRFilterWorker: out not aligned");
+    }
 
-        __m128 SSEout;
-        __m128 SSEtaps;
-        __m128 SSEin;
-        {
-            std::lock_guard<std::mutex> lock(m_taps_mutex);
+    __m128 SSEout;
+    __m128 SSEtaps;
+    __m128 SSEin;
 
-            for (i = 0; i < sizeIn - 2*m_taps.size(); i += 4) {
-                SSEout = _mm_setr_ps(0,0,0,0);
+    for (; i < stop and i < main_stop; i += 4) {
+        SSEout = _mm_setr_ps(0,0,0,0);
 
-                for (size_t j = 0; j < m_taps.size(); j++) {
-                    if ((uintptr_t)(&in[i+2*j]) % 16 == 0) {
-                        SSEin = _mm_load_ps(&in[i+2*j]); //faster when aligned
-                    }
-                    else {
-                        SSEin = _mm_loadu_ps(&in[i+2*j]);
-                    }
+        for (size_t j = 0; j < ntaps; j++) {
+            if ((uintptr_t)(&in[i+2*j]) % 16 == 0) {
+                SSEin = _mm_load_ps(&in[i+2*j]); //faster when aligned
+            }
+            else {
+                SSEin = _mm_loadu_ps(&in[i+2*j]);
+            }
 
-                    SSEtaps = _mm_load1_ps(&m_taps[j]);
+            SSEtaps = _mm_load1_ps(&taps[j]);
 
-                    SSEout = _mm_add_ps(SSEout, _mm_mul_ps(SSEin, SSEtaps));
-                }
-                _mm_store_ps(&out[i], SSEout);
-            }
+            SSEout = _mm_add_ps(SSEout, _mm_mul_ps(SSEin, SSEtaps));
+        }
+        _mm_store_ps(&out[i], SSEout);
+    }
+#else
+    // No SSE ? Loop unrolling should make this faster. As for the SSE,
+    // the real and imaginary parts are calculated separately.
+    // Convolve by aligning both frame and taps at zero.
+    for (; i < stop and i < main_stop; i += 4) {
+        out[i]    = 0.0;
+        out[i+1]  = 0.0;
+        out[i+2]  = 0.0;
+        out[i+3]  = 0.0;
+
+        for (size_t j = 0; j < ntaps; j++) {
+            out[i]   += in[i   + 2*j] * taps[j];
+            out[i+1] += in[i+1 + 2*j] * taps[j];
+            out[i+2] += in[i+2 + 2*j] * taps[j];
+            out[i+3] += in[i+3 + 2*j] * taps[j];
+        }
+    }
+#endif
 
-            for (; i < sizeIn; i++) {
-                out[i] = 0.0;
-                for (int j = 0; i+2*j < sizeIn; j++) {
-                    out[i] += in[i+2*j] * m_taps[j];
-                }
-            }
+    // At the end of the frame, we cut the convolution off.
+    // The beginning of the next frame starts with a NULL symbol
+    // anyway.
+    for (; i < stop; i++) {
+        out[i] = 0.0;
+        for (size_t j = 0; i+2*j < sizeIn; j++) {
+            out[i] += in[i+2*j] * taps[j];
         }
+    }
+}
 
-#else
-        // No SSE ? Loop unrolling should make this faster. As for the SSE,
-        // the real and imaginary parts are calculated separately.
-        const float* in = reinterpret_cast<const float*>(dataIn->getData());
-        float* out      = reinterpret_cast<float*>(dataOut->getData());
-        size_t sizeIn   = dataIn->getLength() / sizeof(float);
+int FIRFilter::internal_process(Buffer* const dataIn, Buffer* dataOut)
+{
+    const float* in = reinterpret_cast<const float*>(dataIn->getData());
+    float* out      = reinterpret_cast<float*>(dataOut->getData());
+    size_t sizeIn   = dataIn->getLength() / sizeof(float);
 
-        {
-            std::lock_guard<std::mutex> lock(m_taps_mutex);
-            // Convolve by aligning both frame and taps at zero.
-            for (i = 0; i < sizeIn - 2*m_taps.size(); i += 4) {
-                out[i]    = 0.0;
-                out[i+1]  = 0.0;
-                out[i+2]  = 0.0;
-                out[i+3]  = 0.0;
-
-                for (size_t j = 0; j < m_taps.size(); j++) {
-                    out[i]   += in[i   + 2*j] * m_taps[j];
-                    out[i+1] += in[i+1 + 2*j] * m_taps[j];
-                    out[i+2] += in[i+2 + 2*j] * m_taps[j];
-                    out[i+3] += in[i+3 + 2*j] * m_taps[j];
-                }
-            }
+    {
+        const auto taps_snapshot = m_taps.load();
 
-            // At the end of the frame, we cut the convolution off.
-            // The beginning of the next frame starts with a NULL symbol
-            // anyway.
-            for (; i < sizeIn; i++) {
-                out[i] = 0.0;
-                for (int j = 0; i+2*j < sizeIn; j++) {
-                    out[i] += in[i+2*j] * m_taps[j];
-                }
-            }
-        }
-#endif
+        const float *taps = taps_snapshot->data();
+        const size_t ntaps = taps_snapshot->size();
+
+        // Chunks start on a multiple of four floats to keep the output
+        // aligned for SSE.
+        m_workers.run(sizeIn, chunk_size,
+                [&](size_t start, size_t stop) {
+                    filter_chunk(taps, ntaps, in, sizeIn, start, stop, out);
+                });
+    }
 
         // The following implementations are for debugging only.
 #if 0
@@ -234,20 +257,20 @@ int FIRFilter::internal_process(Buffer* const dataIn, Buffer* dataOut)
         float* out      = reinterpret_cast<float*>(dataOut->getData());
         size_t sizeIn   = dataIn->getLength() / sizeof(float);
 
-        std::lock_guard<std::mutex> lock(m_taps_mutex);
+        const auto taps = m_taps.load();
 
-        for (i = 0; i < sizeIn - 2*m_taps.size(); i += 1) {
+        for (i = 0; i < sizeIn - 2*taps->size(); i += 1) {
             out[i]  = 0.0;
 
-            for (size_t j = 0; j < m_taps.size(); j++) {
-                out[i]  += in[i+2*j] * m_taps[j];
+            for (size_t j = 0; j < taps->size(); j++) {
+                out[i]  += in[i+2*j] * (*taps)[j];
             }
         }
 
         for (; i < sizeIn; i++) {
             out[i] = 0.0;
             for (int j = 0; i+2*j < sizeIn; j++) {
-                out[i] += in[i+2*j] * m_taps[j];
+                out[i] += in[i+2*j] * (*taps)[j];
             }
         }
 
@@ -258,26 +281,26 @@ int FIRFilter::internal_process(Buffer* const dataIn, Buffer* dataOut)
         complexf* out      = reinterpret_cast<complexf*>(dataOut->getData());
         size_t sizeIn      = dataIn->getLength() / sizeof(complexf);
 
-        std::lock_guard<std::mutex> lock(m_taps_mutex);
+        const auto taps = m_taps.load();
 
-        for (i = 0; i < sizeIn - m_taps.size(); i += 4) {
+        for (i = 0; i < sizeIn - taps->size(); i += 4) {
             out[i]   = 0.0;
             out[i+1] = 0.0;
             out[i+2] = 0.0;
             out[i+3] = 0.0;
 
-            for (size_t j = 0; j < m_taps.size(); j++) {
-                out[i]   += in[i+j  ] * m_taps[j];
-                out[i+1] += in[i+1+j] * m_taps[j];
-                out[i+2] += in[i+2+j] * m_taps[j];
-                out[i+3] += in[i+3+j] * m_taps[j];
+            for (size_t j = 0; j < taps->size(); j++) {
+                out[i]   += in[i+j  ] * (*taps)[j];
+                out[i+1] += in[i+1+j] * (*taps)[j];
+                out[i+2] += in[i+2+j] * (*taps)[j];
+                out[i+3] += in[i+3+j] * (*taps)[j];
             }
         }
 
         for (; i < sizeIn; i++) {
             out[i] = 0.0;
             for (int j = 0; j+i < sizeIn; j++) {
-                out[i] += in[i+j] * m_taps[j];
+                out[i] += in[i+j] * (*taps)[j];
             }
         }
 
@@ -287,20 +310,20 @@ int FIRFilter::internal_process(Buffer* const dataIn, Buffer* dataOut)
         complexf* out      = reinterpret_cast<complexf*>(dataOut->getData());
         size_t sizeIn      = dataIn->getLength() / sizeof(complexf);
 
-        std::lock_guard<std::mutex> lock(m_taps_mutex);
+        const auto taps = m_taps.load();
 
-        for (i = 0; i < sizeIn - m_taps.size(); i += 1) {
+        for (i = 0; i < sizeIn - taps->size(); i += 1) {
             out[i]   = 0.0;
 
-            for (size_t j = 0; j < m_taps.size(); j++) {
-                out[i]  += in[i+j  ] * m_taps[j];
+            for (size_t j = 0; j < taps->size(); j++) {
+                out[i]  += in[i+j  ] * (*taps)[j];
             }
         }
 
         for (; i < sizeIn; i++) {
             out[i] = 0.0;
             for (int j = 0; j+i < sizeIn; j++) {
-                out[i] += in[i+j] * m_taps[j];
+                out[i] += in[i+j] * (*taps)[j];
             }
         }
 #endif
@@ -334,7 +357,7 @@ const string FIRFilter::get_parameter(const string& parameter) const
 {
     stringstream ss;
     if (parameter == "ntaps") {
-        ss << m_taps.size();
+        ss << m_taps.load()->size();
     }
     else if (parameter == "tapsfile") {
         ss << m_taps_file;
@@ -350,7 +373,7 @@ const string FIRFilter::get_parameter(const string& parameter) const
 const json::map_t FIRFilter::get_all_values() const
 {
     json::map_t map;
-    map["ntaps"].v = m_taps.size();
+    map["ntaps"].v = m_taps.load()->size();
     map["tapsfile"].v = m_taps_file;
     return map;
 }
@@ -33,6 +33,8 @@
 
 #include "RemoteControl.h"
 #include "ModPlugin.h"
+#include "WorkerPool.h"
+#include "Rcu.h"
 
 #include <sys/types.h>
 #include <vector>
@@ -44,7 +46,7 @@
 class FIRFilter : public PipelinedModCodec, public RemoteControllable
 {
 public:
-    FIRFilter(std::string& taps_file);
+    FIRFilter(std::string& taps_file, unsigned int num_threads);
     FIRFilter(const FIRFilter& other) = delete;
     FIRFilter& operator=(const FIRFilter& other) = delete;
     virtual ~FIRFilter();
@@ -60,9 +62,13 @@ protected:
     virtual int internal_process(Buffer* const dataIn, Buffer* dataOut) override;
     void load_filter_taps(const std::string &tapsFile);
 
+    // Number of floats filtered at once by one thread, must be a multiple
+    // of four
+    static constexpr size_t chunk_size = 8192;
+    WorkerPool m_workers;
+
     std::string& m_taps_file;
 
-    mutable std::mutex m_taps_mutex;
-    std::vector<float> m_taps;
+    Rcu<std::vector<float>> m_taps;
 };
 
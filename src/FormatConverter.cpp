@@ -37,12 +37,469 @@
 #if defined(__ARM_NEON)
 #include <arm_neon.h>
 #endif
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define FORMATCONVERTER_AVX2_KERNELS 1
+#endif
+
+/* All conversion functions convert len values, and return the number
+ * of values that had to be clipped. */
+
+static size_t fix_wide_to_s16(const int32_t *in, int16_t *out, size_t len)
+{
+    constexpr int shift = 6;
+    size_t num_clipped_samples = 0;
+
+#if defined(__ARM_NEON)
+    if (len % 4 != 0) {
+        throw std::logic_error("Unexpected length not multiple of 4");
+    }
+
+    for (size_t i = 0; i < len; i += 4) {
+        int32x4_t input_vec = vld1q_s32(&in[i]);
+        // Apply shift right, saturate on conversion to int16_t
+        int16x4_t output_vec = vqshrn_n_s32(input_vec, shift);
+        vst1_s16(&out[i], output_vec);
+    }
+#else
+    for (size_t i = 0; i < len; i++) {
+        const int32_t val = in[i] >> shift;
+        if (val < INT16_MIN) {
+            out[i] = INT16_MIN;
+            num_clipped_samples++;
+        }
+        else if (val > INT16_MAX) {
+            out[i] = INT16_MAX;
+            num_clipped_samples++;
+        }
+        else {
+            out[i] = val;
+        }
+    }
+#endif
+    return num_clipped_samples;
+}
+
+static size_t float_to_s16(const float *in, int16_t *out, size_t len)
+{
+    size_t num_clipped_samples = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] < INT16_MIN) {
+            out[i] = INT16_MIN;
+            num_clipped_samples++;
+        }
+        else if (in[i] > INT16_MAX) {
+            out[i] = INT16_MAX;
+            num_clipped_samples++;
+        }
+        else {
+            out[i] = in[i];
+        }
+    }
+    return num_clipped_samples;
+}
+
+static size_t float_to_u8(const float *in, uint8_t *out, size_t len)
+{
+    size_t num_clipped_samples = 0;
+    for (size_t i = 0; i < len; i++) {
+        const auto samp = in[i] + 128.0f;
+        if (samp < 0) {
+            out[i] = 0;
+            num_clipped_samples++;
+        }
+        else if (samp > UINT8_MAX) {
+            out[i] = UINT8_MAX;
+            num_clipped_samples++;
+        }
+        else {
+            out[i] = samp;
+        }
+    }
+    return num_clipped_samples;
+}
+
+static size_t float_to_s8(const float *in, int8_t *out, size_t len)
+{
+    size_t num_clipped_samples = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] < INT8_MIN) {
+            out[i] = INT8_MIN;
+            num_clipped_samples++;
+        }
+        else if (in[i] > INT8_MAX) {
+            out[i] = INT8_MAX;
+            num_clipped_samples++;
+        }
+        else {
+            out[i] = in[i];
+        }
+    }
+    return num_clipped_samples;
+}
+
+static inline int16_t float_to_int12(float x, size_t& num_clipped_samples)
+{
+    if (x < -2048) {
+        num_clipped_samples++;
+        return -2048;
+    }
+    else if (x > 2047) {
+        num_clipped_samples++;
+        return 2047;
+    }
+    return x;
+}
+
+/* Pack I and Q into three bytes per complex sample, in the same layout as
+ * the SoapySDR CS12 format: the 12 bits of I, followed by the 12 bits of Q,
+ * little endian. len is the number of values, i.e. twice the number of
+ * complex samples. */
+static size_t float_to_sc12(const float *in, uint8_t *out, size_t len)
+{
+    size_t num_clipped_samples = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        const int16_t re = float_to_int12(in[i], num_clipped_samples);
+        const int16_t im = float_to_int12(in[i+1], num_clipped_samples);
+
+        uint8_t *o = out + 3 * (i / 2);
+        o[0] = re & 0xFF;
+        o[1] = ((re >> 8) & 0x0F) | ((im & 0x0F) << 4);
+        o[2] = (im >> 4) & 0xFF;
+    }
+    return num_clipped_samples;
+}
+
+/* The SIMD kernels clamp the floats to the output range before converting
+ * them with truncation, which gives the same result as the scalar
+ * versions. The clipped values are counted from the comparison masks.
+ * The remaining values at the end are converted by the scalar versions.
+ *
+ * The saturating packs of AVX2 work within each 128-bit lane, and
+ * need a permutation to restore the order of the values.
+ */
+
+#if defined(__SSE2__)
+/* Without popcnt, count the clipped values in each lane: the comparison
+ * masks are -1 where true. */
+static inline __m128i count_clipped_sse2(__m128i count, __m128 x, __m128 lo, __m128 hi)
+{
+    const __m128 clipped = _mm_or_ps(_mm_cmplt_ps(x, lo), _mm_cmpgt_ps(x, hi));
+    return _mm_sub_epi32(count, _mm_castps_si128(clipped));
+}
+
+static inline size_t sum_counts_sse2(__m128i count)
+{
+    alignas(16) uint32_t c[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(c), count);
+    return (size_t)c[0] + c[1] + c[2] + c[3];
+}
+
+static inline __m128i clamp_convert_sse2(__m128 x, __m128 lo, __m128 hi)
+{
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(x, lo), hi));
+}
+
+static size_t fix_wide_to_s16_sse2(const int32_t *in, int16_t *out, size_t len)
+{
+    constexpr int shift = 6;
+    const __m128i lo = _mm_set1_epi32(INT16_MIN);
+    const __m128i hi = _mm_set1_epi32(INT16_MAX);
+    __m128i count = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        const __m128i a = _mm_srai_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), shift);
+        const __m128i b = _mm_srai_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4)), shift);
+
+        count = _mm_sub_epi32(count,
+                _mm_or_si128(_mm_cmplt_epi32(a, lo), _mm_cmpgt_epi32(a, hi)));
+        count = _mm_sub_epi32(count,
+                _mm_or_si128(_mm_cmplt_epi32(b, lo), _mm_cmpgt_epi32(b, hi)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+    }
+
+    return sum_counts_sse2(count) + fix_wide_to_s16(in + i, out + i, len - i);
+}
+
+static size_t float_to_s16_sse2(const float *in, int16_t *out, size_t len)
+{
+    const __m128 lo = _mm_set1_ps(INT16_MIN);
+    const __m128 hi = _mm_set1_ps(INT16_MAX);
+    __m128i count = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        const __m128 a = _mm_loadu_ps(in + i);
+        const __m128 b = _mm_loadu_ps(in + i + 4);
+
+        count = count_clipped_sse2(count, a, lo, hi);
+        count = count_clipped_sse2(count, b, lo, hi);
+
+        const __m128i s16 = _mm_packs_epi32(
+                clamp_convert_sse2(a, lo, hi), clamp_convert_sse2(b, lo, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), s16);
+    }
+
+    return sum_counts_sse2(count) + float_to_s16(in + i, out + i, len - i);
+}
+
+static size_t float_to_u8_sse2(const float *in, uint8_t *out, size_t len)
+{
+    const __m128 offset = _mm_set1_ps(128.0f);
+    const __m128 lo = _mm_set1_ps(0);
+    const __m128 hi = _mm_set1_ps(UINT8_MAX);
+    __m128i count = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v[4];
+        for (size_t j = 0; j < 4; j++) {
+            const __m128 x = _mm_add_ps(_mm_loadu_ps(in + i + 4*j), offset);
+            count = count_clipped_sse2(count, x, lo, hi);
+            v[j] = clamp_convert_sse2(x, lo, hi);
+        }
+
+        const __m128i u8 = _mm_packus_epi16(
+                _mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), u8);
+    }
+
+    return sum_counts_sse2(count) + float_to_u8(in + i, out + i, len - i);
+}
+
+static size_t float_to_s8_sse2(const float *in, int8_t *out, size_t len)
+{
+    const __m128 lo = _mm_set1_ps(INT8_MIN);
+    const __m128 hi = _mm_set1_ps(INT8_MAX);
+    __m128i count = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v[4];
+        for (size_t j = 0; j < 4; j++) {
+            const __m128 x = _mm_loadu_ps(in + i + 4*j);
+            count = count_clipped_sse2(count, x, lo, hi);
+            v[j] = clamp_convert_sse2(x, lo, hi);
+        }
+
+        const __m128i s8 = _mm_packs_epi16(
+                _mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), s8);
+    }
+
+    return sum_counts_sse2(count) + float_to_s8(in + i, out + i, len - i);
+}
+#endif // defined(__SSE2__)
+
+#if defined(FORMATCONVERTER_AVX2_KERNELS)
+__attribute__((target("avx2,popcnt")))
+static inline size_t count_clipped_avx2(__m256 x, __m256 lo, __m256 hi)
+{
+    const __m256 clipped = _mm256_or_ps(
+            _mm256_cmp_ps(x, lo, _CMP_LT_OQ),
+            _mm256_cmp_ps(x, hi, _CMP_GT_OQ));
+    return _mm_popcnt_u32(_mm256_movemask_ps(clipped));
+}
+
+__attribute__((target("avx2,popcnt")))
+static inline __m256i clamp_convert_avx2(__m256 x, __m256 lo, __m256 hi)
+{
+    return _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(x, lo), hi));
+}
+
+// Restore the order of bytes packed from four vectors of 32-bit values
+__attribute__((target("avx2,popcnt")))
+static inline __m256i reorder_packed_bytes_avx2(__m256i packed)
+{
+    return _mm256_permutevar8x32_epi32(packed,
+            _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t fix_wide_to_s16_avx2(const int32_t *in, int16_t *out, size_t len)
+{
+    constexpr int shift = 6;
+    const __m256i lo = _mm256_set1_epi32(INT16_MIN);
+    const __m256i hi = _mm256_set1_epi32(INT16_MAX);
+    size_t num_clipped_samples = 0;
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        const __m256i a = _mm256_srai_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), shift);
+        const __m256i b = _mm256_srai_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 8)), shift);
+
+        const __m256i clipped_a = _mm256_or_si256(
+                _mm256_cmpgt_epi32(lo, a), _mm256_cmpgt_epi32(a, hi));
+        const __m256i clipped_b = _mm256_or_si256(
+                _mm256_cmpgt_epi32(lo, b), _mm256_cmpgt_epi32(b, hi));
+        num_clipped_samples +=
+            _mm_popcnt_u32(_mm256_movemask_ps(_mm256_castsi256_ps(clipped_a))) +
+            _mm_popcnt_u32(_mm256_movemask_ps(_mm256_castsi256_ps(clipped_b)));
+
+        const __m256i s16 = _mm256_permute4x64_epi64(
+                _mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), s16);
+    }
+
+    return num_clipped_samples + fix_wide_to_s16(in + i, out + i, len - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t float_to_s16_avx2(const float *in, int16_t *out, size_t len)
+{
+    const __m256 lo = _mm256_set1_ps(INT16_MIN);
+    const __m256 hi = _mm256_set1_ps(INT16_MAX);
+    size_t num_clipped_samples = 0;
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        const __m256 a = _mm256_loadu_ps(in + i);
+        const __m256 b = _mm256_loadu_ps(in + i + 8);
+
+        num_clipped_samples += count_clipped_avx2(a, lo, hi);
+        num_clipped_samples += count_clipped_avx2(b, lo, hi);
+
+        const __m256i s16 = _mm256_permute4x64_epi64(
+                _mm256_packs_epi32(
+                    clamp_convert_avx2(a, lo, hi),
+                    clamp_convert_avx2(b, lo, hi)),
+                _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), s16);
+    }
+
+    return num_clipped_samples + float_to_s16(in + i, out + i, len - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t float_to_u8_avx2(const float *in, uint8_t *out, size_t len)
+{
+    const __m256 offset = _mm256_set1_ps(128.0f);
+    const __m256 lo = _mm256_set1_ps(0);
+    const __m256 hi = _mm256_set1_ps(UINT8_MAX);
+    size_t num_clipped_samples = 0;
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v[4];
+        for (size_t j = 0; j < 4; j++) {
+            const __m256 x = _mm256_add_ps(_mm256_loadu_ps(in + i + 8*j), offset);
+            num_clipped_samples += count_clipped_avx2(x, lo, hi);
+            v[j] = clamp_convert_avx2(x, lo, hi);
+        }
+
+        const __m256i u8 = reorder_packed_bytes_avx2(_mm256_packus_epi16(
+                _mm256_packs_epi32(v[0], v[1]), _mm256_packs_epi32(v[2], v[3])));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), u8);
+    }
+
+    return num_clipped_samples + float_to_u8(in + i, out + i, len - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t float_to_s8_avx2(const float *in, int8_t *out, size_t len)
+{
+    const __m256 lo = _mm256_set1_ps(INT8_MIN);
+    const __m256 hi = _mm256_set1_ps(INT8_MAX);
+    size_t num_clipped_samples = 0;
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v[4];
+        for (size_t j = 0; j < 4; j++) {
+            const __m256 x = _mm256_loadu_ps(in + i + 8*j);
+            num_clipped_samples += count_clipped_avx2(x, lo, hi);
+            v[j] = clamp_convert_avx2(x, lo, hi);
+        }
+
+        const __m256i s8 = reorder_packed_bytes_avx2(_mm256_packs_epi16(
+                _mm256_packs_epi32(v[0], v[1]), _mm256_packs_epi32(v[2], v[3])));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), s8);
+    }
+
+    return num_clipped_samples + float_to_s8(in + i, out + i, len - i);
+}
+__attribute__((target("avx2,popcnt")))
+static size_t float_to_sc12_avx2(const float *in, uint8_t *out, size_t len)
+{
+    const __m256 lo = _mm256_set1_ps(-2048);
+    const __m256 hi = _mm256_set1_ps(2047);
+    const __m256i mask_re = _mm256_set1_epi32(0x00000FFF);
+    const __m256i mask_im = _mm256_set1_epi32(0x0FFF0000);
+    // Keep the three low bytes of every 32-bit value, in each lane
+    const __m256i compact = _mm256_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    // Bring the 12 bytes of each lane together
+    const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    size_t num_clipped_samples = 0;
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        const __m256 a = _mm256_loadu_ps(in + i);
+        const __m256 b = _mm256_loadu_ps(in + i + 8);
+
+        num_clipped_samples += count_clipped_avx2(a, lo, hi);
+        num_clipped_samples += count_clipped_avx2(b, lo, hi);
+
+        // One complex sample per 32-bit value, I in the low 16 bits
+        __m256i iq = _mm256_permute4x64_epi64(
+                _mm256_packs_epi32(
+                    clamp_convert_avx2(a, lo, hi),
+                    clamp_convert_avx2(b, lo, hi)),
+                _MM_SHUFFLE(3, 1, 2, 0));
+
+        iq = _mm256_or_si256(
+                _mm256_and_si256(iq, mask_re),
+                _mm256_srli_epi32(_mm256_and_si256(iq, mask_im), 4));
+
+        iq = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(iq, compact), join);
+
+        // 8 complex samples give 24 bytes
+        uint8_t *o = out + 3 * (i / 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(o),
+                _mm256_castsi256_si128(iq));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(o + 16),
+                _mm256_extracti128_si256(iq, 1));
+    }
+
+    return num_clipped_samples + float_to_sc12(in + i, out + 3 * (i / 2), len - i);
+}
+#endif // defined(FORMATCONVERTER_AVX2_KERNELS)
 
 FormatConverter::FormatConverter(bool input_is_complexfix_wide, const std::string& format_out) :
     ModCodec(),
     m_input_complexfix_wide(input_is_complexfix_wide),
     m_format_out(format_out)
-{ }
+{
+    m_fix_wide_to_s16 = fix_wide_to_s16;
+    m_float_to_s16 = float_to_s16;
+    m_float_to_u8 = float_to_u8;
+    m_float_to_s8 = float_to_s8;
+    m_float_to_sc12 = float_to_sc12;
+
+#if defined(__SSE2__) and not defined(__ARM_NEON)
+    m_fix_wide_to_s16 = fix_wide_to_s16_sse2;
+    m_float_to_s16 = float_to_s16_sse2;
+    m_float_to_u8 = float_to_u8_sse2;
+    m_float_to_s8 = float_to_s8_sse2;
+#endif
+
+#if defined(FORMATCONVERTER_AVX2_KERNELS)
+    if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("popcnt")) {
+        m_fix_wide_to_s16 = fix_wide_to_s16_avx2;
+        m_float_to_s16 = float_to_s16_avx2;
+        m_float_to_u8 = float_to_u8_avx2;
+        m_float_to_s8 = float_to_s8_avx2;
+        m_float_to_sc12 = float_to_sc12_avx2;
+    }
+#endif
+}
 
 FormatConverter::~FormatConverter()
 {
@@ -73,36 +530,7 @@ int FormatConverter::process(Buffer* const dataIn, Buffer* dataOut)
             dataOut->setLength(sizeIn * sizeof(int16_t));
             const int32_t *in = reinterpret_cast<int32_t*>(dataIn->getData());
             int16_t* out = reinterpret_cast<int16_t*>(dataOut->getData());
-
-            constexpr int shift = 6;
-
-#if defined(__ARM_NEON)
-            if (sizeIn % 4 != 0) {
-                throw std::logic_error("Unexpected length not multiple of 4");
-            }
-
-            for (size_t i = 0; i < sizeIn; i += 4) {
-                int32x4_t input_vec = vld1q_s32(&in[i]);
-                // Apply shift right, saturate on conversion to int16_t
-                int16x4_t output_vec = vqshrn_n_s32(input_vec, shift);
-                vst1_s16(&out[i], output_vec);
-            }
-#else
-            for (size_t i = 0; i < sizeIn; i++) {
-                const int32_t val = in[i] >> shift;
-                if (val < INT16_MIN) {
-                    out[i] = INT16_MIN;
-                    num_clipped_samples++;
-                }
-                else if (val > INT16_MAX) {
-                    out[i] = INT16_MAX;
-                    num_clipped_samples++;
-                }
-                else {
-                    out[i] = val;
-                }
-            }
-#endif
+            num_clipped_samples = m_fix_wide_to_s16(in, out, sizeIn);
         }
         else {
             throw std::runtime_error("FormatConverter: Invalid fix format " + m_format_out);
@@ -115,58 +543,25 @@ int FormatConverter::process(Buffer* const dataIn, Buffer* dataOut)
         if (m_format_out == "s16") {
             dataOut->setLength(sizeIn * sizeof(int16_t));
             int16_t* out = reinterpret_cast<int16_t*>(dataOut->getData());
-
-            for (size_t i = 0; i < sizeIn; i++) {
-                if (in[i] < INT16_MIN) {
-                    out[i] = INT16_MIN;
-                    num_clipped_samples++;
-                }
-                else if (in[i] > INT16_MAX) {
-                    out[i] = INT16_MAX;
-                    num_clipped_samples++;
-                }
-                else {
-                    out[i] = in[i];
-                }
-            }
+            num_clipped_samples = m_float_to_s16(in, out, sizeIn);
         }
         else if (m_format_out == "u8") {
             dataOut->setLength(sizeIn * sizeof(int8_t));
             uint8_t* out = reinterpret_cast<uint8_t*>(dataOut->getData());
-
-            for (size_t i = 0; i < sizeIn; i++) {
-                const auto samp = in[i] + 128.0f;
-                if (samp < 0) {
-                    out[i] = 0;
-                    num_clipped_samples++;
-                }
-                else if (samp > UINT8_MAX) {
-                    out[i] = UINT8_MAX;
-                    num_clipped_samples++;
-                }
-                else {
-                    out[i] = samp;
-                }
-
-            }
+            num_clipped_samples = m_float_to_u8(in, out, sizeIn);
         }
         else if (m_format_out == "s8") {
             dataOut->setLength(sizeIn * sizeof(int8_t));
             int8_t* out = reinterpret_cast<int8_t*>(dataOut->getData());
-
-            for (size_t i = 0; i < sizeIn; i++) {
-                if (in[i] < INT8_MIN) {
-                    out[i] = INT8_MIN;
-                    num_clipped_samples++;
-                }
-                else if (in[i] > INT8_MAX) {
-                    out[i] = INT8_MAX;
-                    num_clipped_samples++;
-                }
-                else {
-                    out[i] = in[i];
-                }
+            num_clipped_samples = m_float_to_s8(in, out, sizeIn);
+        }
+        else if (m_format_out == "sc12") {
+            if (sizeIn % 2 != 0) {
+                throw std::runtime_error("FormatConverter: sc12 needs complex input");
             }
+            dataOut->setLength(sizeIn / 2 * 3);
+            uint8_t* out = reinterpret_cast<uint8_t*>(dataOut->getData());
+            num_clipped_samples = m_float_to_sc12(in, out, sizeIn);
         }
         else {
             throw std::runtime_error("FormatConverter: Invalid format " + m_format_out);
@@ -188,6 +583,25 @@ size_t FormatConverter::get_num_clipped_samples() const
 }
 
 
+void FormatConverter::s16_to_float(const int16_t *in, float *out, size_t len, float scale)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 scale4 = _mm_set1_ps(scale);
+    for (; i + 8 <= len; i += 8) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Sign-extend to 32 bits by putting the values into the upper half
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), x), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(_mm_setzero_si128(), x), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale4));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale4));
+    }
+#endif
+    for (; i < len; i++) {
+        out[i] = in[i] * scale;
+    }
+}
+
 size_t FormatConverter::get_format_size(const std::string& format)
 {
     // Returns 2*sizeof(SAMPLE_TYPE) because we have I + Q
@@ -200,6 +614,10 @@ size_t FormatConverter::get_format_size(const std::string& format)
     else if (format == "s8") {
         return 2;
     }
+    else if (format == "sc12") {
+        // I and Q packed together into three bytes
+        return 3;
+    }
     else {
         throw std::runtime_error("FormatConverter: Invalid format " + format);
     }
@@ -34,6 +34,7 @@
 
 #include "ModPlugin.h"
 #include <atomic>
+#include <cstdint>
 #include <string>
 
 class FormatConverter : public ModCodec
@@ -41,7 +42,10 @@ class FormatConverter : public ModCodec
     public:
         static size_t get_format_size(const std::string& format);
 
-        // floating-point input allows output formats: s8, u8 and s16
+        // Convert len s16 values back to float, multiplied by scale
+        static void s16_to_float(const int16_t *in, float *out, size_t len, float scale);
+
+        // floating-point input allows output formats: s8, u8, s16 and sc12
         // complexfix_wide input allows output formats: s16
         // complexfix input is already in s16, and needs no converter
         FormatConverter(bool input_is_complexfix_wide, const std::string& format_out);
@@ -57,6 +61,14 @@ class FormatConverter : public ModCodec
         std::string m_format_out;
 
         std::atomic<size_t> m_num_clipped_samples = 0;
+
+        // Conversion functions, chosen according to the CPU features.
+        // They return the number of clipped values.
+        size_t (*m_fix_wide_to_s16)(const int32_t *in, int16_t *out, size_t len) = nullptr;
+        size_t (*m_float_to_s16)(const float *in, int16_t *out, size_t len) = nullptr;
+        size_t (*m_float_to_u8)(const float *in, uint8_t *out, size_t len) = nullptr;
+        size_t (*m_float_to_s8)(const float *in, int8_t *out, size_t len) = nullptr;
+        size_t (*m_float_to_sc12)(const float *in, uint8_t *out, size_t len) = nullptr;
 };
 
 
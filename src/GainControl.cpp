@@ -27,12 +27,19 @@
 
 #include "GainControl.h"
 #include "PcDebug.h"
+#include "Log.h"
 
 #include <cstdio>
+#include <cmath>
 #include <stdexcept>
 #include <algorithm>
 #include <string>
 
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define GAINCONTROL_AVX2_KERNELS 1
+#endif
+
 #ifdef __SSE__
 #  include <xmmintrin.h>
 union u128_union_t {
@@ -44,33 +51,38 @@ union u128_union_t {
 
 using namespace std;
 
-static float var_variance;
-
 GainControl::GainControl(size_t framesize,
                          GainMode& gainMode,
                          float& digGain,
                          float normalise,
-                         float& varVariance) :
+                         float& varVariance,
+                         unsigned num_threads) :
     PipelinedModCodec(),
     RemoteControllable("gain"),
-#ifdef __SSE__
-    m_frameSize(framesize * sizeof(complexf) / sizeof(__m128)),
-#else // !__SSE__
     m_frameSize(framesize),
-#endif
-    m_digGain(digGain),
     m_normalise(normalise),
+    m_workers("GainControl", num_threads),
+    m_settings(settings_t{gainMode, digGain, varVariance}),
+    m_digGain(digGain),
     m_var_variance_rc(varVariance),
-    m_gainmode(gainMode),
-    m_mutex()
+    m_gainmode(gainMode)
 {
-    PDEBUG("GainControl::GainControl(%zu, %zu) @ %p\n", framesize, (size_t)m_gainmode, this);
+    PDEBUG("GainControl::GainControl(%zu, %zu) @ %p\n", framesize, (size_t)gainMode, this);
 
     /* register the parameters that can be remote controlled */
     RC_ADD_PARAMETER(digital, "Digital Gain");
     RC_ADD_PARAMETER(mode, "Gainmode (fix|max|var)");
     RC_ADD_PARAMETER(var, "Variance setting for gainmode var (default: 4)");
 
+#if defined(GAINCONTROL_AVX2_KERNELS)
+    m_use_avx2 = __builtin_cpu_supports("avx2") and
+                 __builtin_cpu_supports("fma");
+#endif
+
+    etiLog.level(info) << "GainControl will use " <<
+        m_workers.num_threads() << " threads" <<
+        (m_use_avx2 ? " and AVX2" : "");
+
     start_pipeline_thread();
 }
 
@@ -87,108 +99,237 @@ int GainControl::internal_process(Buffer* const dataIn, Buffer* dataOut)
 
     dataOut->setLength(dataIn->getLength());
 
-#ifdef __SSE__
-    __m128 (*computeGain)(const __m128* in, size_t sizeIn);
-#else
-    float (*computeGain)(const complexf* in, size_t sizeIn);
-#endif
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
+    // Use the same settings for the whole frame
+    const auto settings = m_settings.load();
 
-        var_variance = m_var_variance_rc;
+    const GainMode gainmode = settings->gainmode;
+    const float var_variance = settings->var_variance;
+    const float constantGain = m_normalise * settings->digGain;
 
-        switch (m_gainmode) {
-            case GainMode::GAIN_FIX:
-                PDEBUG("Gain mode: fix\n");
-                computeGain = computeGainFix;
-                break;
-            case GainMode::GAIN_MAX:
-                PDEBUG("Gain mode: max\n");
-                computeGain = computeGainMax;
-                break;
-            case GainMode::GAIN_VAR:
-                PDEBUG("Gain mode: var\n");
-                computeGain = computeGainVar;
-                break;
-            default:
-                throw std::logic_error("Internal error: invalid gainmode");
-        }
+    const complexf* in = reinterpret_cast<const complexf*>(dataIn->getData());
+    complexf* out = reinterpret_cast<complexf*>(dataOut->getData());
+    const size_t sizeIn = dataIn->getLength() / sizeof(complexf);
+
+    if ((sizeIn % m_frameSize) != 0) {
+        PDEBUG("%zu != %zu\n", sizeIn, m_frameSize);
+        throw std::runtime_error("GainControl::process input size not valid!");
     }
 
-    const float constantGain = m_normalise * m_digGain;
+    const size_t num_symbols = sizeIn / m_frameSize;
+
+    // The symbols are independent of each other. Every symbol is scaled
+    // right after its statistics have been computed, while it is still
+    // in the cache.
+    m_workers.run(num_symbols, 1,
+            [&](size_t start, size_t stop) {
+                for (size_t sym = start; sym < stop; sym++) {
+                    // Do not apply gain computation to the NULL symbol, which either
+                    // is blank or contains TII. Apply the gain calculation from the next
+                    // symbol on the NULL symbol to get consistent TII power.
+                    const size_t stats_sym = (sym == 0 and num_symbols > 1) ? 1 : sym;
+
+                    process_symbol(gainmode, var_variance, constantGain,
+                            in + stats_sym * m_frameSize,
+                            in + sym * m_frameSize,
+                            out + sym * m_frameSize);
+                }
+            });
+
+    return dataOut->getLength();
+}
 
-#ifdef __SSE__
-    const __m128* in  = reinterpret_cast<const __m128*>(dataIn->getData());
-    __m128* out       = reinterpret_cast<__m128*>(dataOut->getData());
-    size_t  sizeIn    = dataIn->getLength() / sizeof(__m128);
-    size_t  sizeOut   = dataOut->getLength() / sizeof(__m128);
-    u128_union_t  gain128;
+#if defined(GAINCONTROL_AVX2_KERNELS)
+/* The AVX2 kernels work on interleaved real and imaginary parts. In a
+ * register, the even elements are real parts, the odd ones imaginary
+ * parts. len is the number of floats, twice the number of samples.
+ *
+ * They compute the same gains as the SSE versions, but the mean and
+ * variance are calculated with sums instead of running averages, which
+ * avoids one division per sample. The results can differ in the last
+ * bits of the gain.
+ */
+static const float gain_factor = 0x7fff;
 
+__attribute__((target("avx2,fma")))
+static float compute_gain_max_avx2(const float *in, size_t len)
+{
+    __m256 min = _mm256_set1_ps(__FLT_MAX__);
+    __m256 max = _mm256_set1_ps(__FLT_MIN__);
+
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        const __m256 x = _mm256_loadu_ps(in + i);
+        min = _mm256_min_ps(x, min);
+        max = _mm256_max_ps(x, max);
+    }
 
-    if ((sizeIn % m_frameSize) != 0) {
-        PDEBUG("%zu != %zu\n", sizeIn, m_frameSize);
-        throw std::runtime_error("GainControl::process input size not valid!");
+    float min_f[8];
+    float max_f[8];
+    _mm256_storeu_ps(min_f, min);
+    _mm256_storeu_ps(max_f, max);
+
+    float minimum = *std::min_element(min_f, min_f + 8);
+    float maximum = *std::max_element(max_f, max_f + 8);
+    for (; i < len; i++) {
+        minimum = std::min(minimum, in[i]);
+        maximum = std::max(maximum, in[i]);
     }
 
-    const auto constantGain4 = _mm_set1_ps(constantGain);
+    maximum = std::max(-minimum, maximum);
 
-    for (size_t i = 0; i < sizeIn; i += m_frameSize) {
-        // Do not apply gain computation to the NULL symbol, which either
-        // is blank or contains TII. Apply the gain calculation from the next
-        // symbol on the NULL symbol to get consistent TII power.
-        if (i > 0) {
-            gain128.m = computeGain(in, m_frameSize);
-        }
-        else {
-            gain128.m = computeGain(in + m_frameSize, m_frameSize);
-        }
-        gain128.m = _mm_mul_ps(gain128.m, constantGain4);
+    // Detect NULL
+    if ((int)maximum != 0) {
+        return gain_factor / maximum;
+    }
+    return 1.0f;
+}
 
-        PDEBUG("********** Gain: %10f **********\n", gain128.f[0]);
+__attribute__((target("avx2,fma")))
+static float compute_gain_var_avx2(const float *in, size_t len, float var_variance)
+{
+    const size_t num_samples = len / 2;
 
-        for (size_t sample = 0; sample < m_frameSize; ++sample) {
-            out[sample] = _mm_mul_ps(in[sample], gain128.m);
-        }
+    // Mean of real and imaginary parts
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t i = 0; i < len; i += 8) {
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(in + i));
+    }
 
-        in  += m_frameSize;
-        out += m_frameSize;
+    float sum_f[8];
+    _mm256_storeu_ps(sum_f, sum);
+    const float mean_re = (sum_f[0] + sum_f[2] + sum_f[4] + sum_f[6]) / num_samples;
+    const float mean_im = (sum_f[1] + sum_f[3] + sum_f[5] + sum_f[7]) / num_samples;
+
+    // Variance of real and imaginary parts
+    const __m256 mean = _mm256_setr_ps(
+            mean_re, mean_im, mean_re, mean_im,
+            mean_re, mean_im, mean_re, mean_im);
+    __m256 sum_sq = _mm256_setzero_ps();
+    for (size_t i = 0; i < len; i += 8) {
+        const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(in + i), mean);
+        sum_sq = _mm256_fmadd_ps(diff, diff, sum_sq);
     }
-#else // !__SSE__
-    const complexf* in = reinterpret_cast<const complexf*>(dataIn->getData());
-    complexf* out  = reinterpret_cast<complexf*>(dataOut->getData());
-    size_t sizeIn  = dataIn->getLength() / sizeof(complexf);
-    size_t sizeOut = dataOut->getLength() / sizeof(complexf);
-    float  gain;
 
-    if ((sizeIn % m_frameSize) != 0) {
-        PDEBUG("%zu != %zu\n", sizeIn, m_frameSize);
-        throw std::runtime_error(
-                "GainControl::process input size not valid!");
+    _mm256_storeu_ps(sum_f, sum_sq);
+    const float var_re = (sum_f[0] + sum_f[2] + sum_f[4] + sum_f[6]) / num_samples;
+    const float var_im = (sum_f[1] + sum_f[3] + sum_f[5] + sum_f[7]) / num_samples;
+
+    const float stddev_re = sqrtf(var_re) * var_variance;
+    const float stddev_im = sqrtf(var_im) * var_variance;
+
+    // Detect NULL
+    if ((int)stddev_re != 0) {
+        return gain_factor / std::max(stddev_re, stddev_im);
     }
+    return 1.0f;
+}
 
-    for (size_t i = 0; i < sizeIn; i += m_frameSize) {
-        // Do not apply gain computation to the NULL symbol, which either
-        // is blank or contains TII. Apply the gain calculation from the next
-        // symbol on the NULL symbol to get consistent TII power.
-        gain = constantGain * (i > 0 ?
-                computeGain(in, m_frameSize) :
-                computeGain(in + m_frameSize, m_frameSize));
+__attribute__((target("avx2,fma")))
+static void apply_gain_avx2(const float *in, float *out, size_t len, float gain)
+{
+    const __m256 gain8 = _mm256_set1_ps(gain);
 
-        PDEBUG("********** Gain: %10f **********\n", gain);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(in + i), gain8));
+    }
+    for (; i < len; i++) {
+        out[i] = in[i] * gain;
+    }
+}
+#endif // defined(GAINCONTROL_AVX2_KERNELS)
 
-        ////////////////////////////////////////////////////////////////////////
-        // Applying gain to output data
-        ////////////////////////////////////////////////////////////////////////
-        for (size_t sample = 0; sample < m_frameSize; ++sample) {
-            out[sample] = in[sample] * gain;
+void GainControl::process_symbol(GainMode gainmode, float var_variance,
+        float constantGain, const complexf *stats_in,
+        const complexf *in, complexf *out) const
+{
+#if defined(GAINCONTROL_AVX2_KERNELS)
+    // The variance kernel requires a multiple of four samples, which all
+    // DAB symbol sizes are.
+    if (m_use_avx2 and m_frameSize % 4 == 0) {
+        const float *stats_in_f = reinterpret_cast<const float*>(stats_in);
+        const size_t len = 2 * m_frameSize;
+
+        float gain = 1.0f;
+        switch (gainmode) {
+            case GainMode::GAIN_FIX:
+                gain = 512.0f;
+                break;
+            case GainMode::GAIN_MAX:
+                gain = compute_gain_max_avx2(stats_in_f, len);
+                break;
+            case GainMode::GAIN_VAR:
+                gain = compute_gain_var_avx2(stats_in_f, len, var_variance);
+                break;
         }
 
-        in  += m_frameSize;
-        out += m_frameSize;
+        PDEBUG("********** Gain: %10f **********\n", gain);
+
+        apply_gain_avx2(reinterpret_cast<const float*>(in),
+                reinterpret_cast<float*>(out), len, gain * constantGain);
+        return;
     }
-#endif // __SSE__
+#endif
+
+#ifdef __SSE__
+    const size_t frameSize = m_frameSize * sizeof(complexf) / sizeof(__m128);
+    const __m128* stats_in128 = reinterpret_cast<const __m128*>(stats_in);
+    const __m128* in128 = reinterpret_cast<const __m128*>(in);
+    __m128* out128 = reinterpret_cast<__m128*>(out);
+    u128_union_t gain128;
 
-    return sizeOut;
+    switch (gainmode) {
+        case GainMode::GAIN_FIX:
+            PDEBUG("Gain mode: fix\n");
+            gain128.m = computeGainFix(stats_in128, frameSize);
+            break;
+        case GainMode::GAIN_MAX:
+            PDEBUG("Gain mode: max\n");
+            gain128.m = computeGainMax(stats_in128, frameSize);
+            break;
+        case GainMode::GAIN_VAR:
+            PDEBUG("Gain mode: var\n");
+            gain128.m = computeGainVar(stats_in128, frameSize, var_variance);
+            break;
+        default:
+            throw std::logic_error("Internal error: invalid gainmode");
+    }
+    gain128.m = _mm_mul_ps(gain128.m, _mm_set1_ps(constantGain));
+
+    PDEBUG("********** Gain: %10f **********\n", gain128.f[0]);
+
+    for (size_t sample = 0; sample < frameSize; ++sample) {
+        out128[sample] = _mm_mul_ps(in128[sample], gain128.m);
+    }
+#else // !__SSE__
+    float gain;
+    switch (gainmode) {
+        case GainMode::GAIN_FIX:
+            PDEBUG("Gain mode: fix\n");
+            gain = computeGainFix(stats_in, m_frameSize);
+            break;
+        case GainMode::GAIN_MAX:
+            PDEBUG("Gain mode: max\n");
+            gain = computeGainMax(stats_in, m_frameSize);
+            break;
+        case GainMode::GAIN_VAR:
+            PDEBUG("Gain mode: var\n");
+            gain = computeGainVar(stats_in, m_frameSize, var_variance);
+            break;
+        default:
+            throw std::logic_error("Internal error: invalid gainmode");
+    }
+    gain *= constantGain;
+
+    PDEBUG("********** Gain: %10f **********\n", gain);
+
+    ////////////////////////////////////////////////////////////////////////
+    // Applying gain to output data
+    ////////////////////////////////////////////////////////////////////////
+    for (size_t sample = 0; sample < m_frameSize; ++sample) {
+        out[sample] = in[sample] * gain;
+    }
+#endif // __SSE__
 }
 
 
@@ -248,7 +389,8 @@ __m128 GainControl::computeGainMax(const __m128* in, size_t sizeIn)
     return gain128.m;
 }
 
-__m128 GainControl::computeGainVar(const __m128* in, size_t sizeIn)
+__m128 GainControl::computeGainVar(const __m128* in, size_t sizeIn,
+        float var_variance)
 {
     u128_union_t gain128;
     u128_union_t mean128;
@@ -397,7 +539,8 @@ float GainControl::computeGainMax(const complexf* in, size_t sizeIn)
     return gain;
 }
 
-float GainControl::computeGainVar(const complexf* in, size_t sizeIn)
+float GainControl::computeGainVar(const complexf* in, size_t sizeIn,
+        float var_variance)
 {
     complexf mean;
 
@@ -510,6 +653,7 @@ void GainControl::set_parameter(const string& parameter, const string& value)
     if (parameter == "digital") {
         float new_factor;
         ss >> new_factor;
+        m_settings.update([&](settings_t& s) { s.digGain = new_factor; });
         m_digGain = new_factor;
     }
     else if (parameter == "mode") {
@@ -532,18 +676,14 @@ void GainControl::set_parameter(const string& parameter, const string& value)
             throw ParameterError("Gainmode " + new_mode + " unknown");
         }
 
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_gainmode = m;
-        }
+        m_settings.update([&](settings_t& s) { s.gainmode = m; });
+        m_gainmode = m;
     }
     else if (parameter == "var") {
         float newvar = 0;
         ss >> newvar;
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_var_variance_rc = newvar;
-        }
+        m_settings.update([&](settings_t& s) { s.var_variance = newvar; });
+        m_var_variance_rc = newvar;
     }
     else {
         stringstream ss_err;
@@ -555,12 +695,14 @@ void GainControl::set_parameter(const string& parameter, const string& value)
 
 const string GainControl::get_parameter(const string& parameter) const
 {
+    const auto settings = m_settings.load();
+
     stringstream ss;
     if (parameter == "digital") {
-        ss << std::fixed << m_digGain;
+        ss << std::fixed << settings->digGain;
     }
     else if (parameter == "mode") {
-        switch (m_gainmode) {
+        switch (settings->gainmode) {
             case GainMode::GAIN_FIX:
                 ss << "fix";
                 break;
@@ -573,7 +715,7 @@ const string GainControl::get_parameter(const string& parameter) const
         }
     }
     else if (parameter == "var") {
-        ss << std::fixed << m_var_variance_rc;
+        ss << std::fixed << settings->var_variance;
     }
     else {
         ss << "Parameter '" << parameter <<
@@ -585,9 +727,11 @@ const string GainControl::get_parameter(const string& parameter) const
 
 const json::map_t GainControl::get_all_values() const
 {
+    const auto settings = m_settings.load();
+
     json::map_t map;
-    map["digital"].v = m_digGain;
-    switch (m_gainmode) {
+    map["digital"].v = settings->digGain;
+    switch (settings->gainmode) {
         case GainMode::GAIN_FIX:
             map["mode"].v = "fix";
             break;
@@ -598,6 +742,6 @@ const json::map_t GainControl::get_all_values() const
             map["mode"].v = "var";
             break;
     }
-    map["var"].v = m_var_variance_rc;
+    map["var"].v = settings->var_variance;
     return map;
 }
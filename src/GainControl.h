@@ -33,10 +33,11 @@
 
 #include "ModPlugin.h"
 #include "RemoteControl.h"
+#include "Rcu.h"
+#include "WorkerPool.h"
 
 #include <sys/types.h>
 #include <string>
-#include <mutex>
 
 #ifdef __SSE__
 #   include <xmmintrin.h>
@@ -51,7 +52,8 @@ class GainControl : public PipelinedModCodec, public RemoteControllable
                     GainMode& gainMode,
                     float& digGain,
                     float normalise,
-                    float& varVariance);
+                    float& varVariance,
+                    unsigned num_threads);
 
         virtual ~GainControl();
         GainControl(const GainControl&) = delete;
@@ -68,23 +70,43 @@ class GainControl : public PipelinedModCodec, public RemoteControllable
         virtual int internal_process(
                 Buffer* const dataIn, Buffer* dataOut) override;
 
+        // Compute the gain from the symbol at stats_in, and apply it to
+        // the symbol at in.
+        void process_symbol(GainMode gainmode, float var_variance,
+                float constantGain, const complexf *stats_in,
+                const complexf *in, complexf *out) const;
+
+        // Symbol size in complex samples
         size_t m_frameSize;
-        float& m_digGain;
         float m_normalise;
 
-        // The following variables are accessed from the RC thread
+        // The symbols of a frame get distributed over the workers
+        WorkerPool m_workers;
+        bool m_use_avx2 = false;
+
+        // The settings that can be changed through the RC. The references
+        // to the configuration are kept up to date.
+        struct settings_t {
+            GainMode gainmode;
+            float digGain;
+            float var_variance;
+        };
+        Rcu<settings_t> m_settings;
+
+        float& m_digGain;
         float& m_var_variance_rc;
         GainMode& m_gainmode;
-        mutable std::mutex m_mutex;
 
 #ifdef __SSE__
         __m128 static computeGainFix(const __m128* in, size_t sizeIn);
         __m128 static computeGainMax(const __m128* in, size_t sizeIn);
-        __m128 static computeGainVar(const __m128* in, size_t sizeIn);
+        __m128 static computeGainVar(const __m128* in, size_t sizeIn,
+                float var_variance);
 #else
         float static computeGainFix(const complexf* in, size_t sizeIn);
         float static computeGainMax(const complexf* in, size_t sizeIn);
-        float static computeGainVar(const complexf* in, size_t sizeIn);
+        float static computeGainVar(const complexf* in, size_t sizeIn,
+                float var_variance);
 #endif
 };
 
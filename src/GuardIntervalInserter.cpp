@@ -36,12 +36,14 @@ GuardIntervalInserter::Params::Params(
         size_t spacing,
         size_t nullSize,
         size_t symSize,
-        size_t& windowOverlap) :
+        size_t& windowOverlap,
+        size_t oversampling) :
     nbSymbols(nbSymbols),
     spacing(spacing),
     nullSize(nullSize),
     symSize(symSize),
-    windowOverlap(windowOverlap) {}
+    windowOverlap(windowOverlap),
+    oversampling(oversampling) {}
 
 GuardIntervalInserter::GuardIntervalInserter(
         size_t nbSymbols,
@@ -49,11 +51,12 @@ GuardIntervalInserter::GuardIntervalInserter(
         size_t nullSize,
         size_t symSize,
         size_t& windowOverlap,
-        FFTEngine fftEngine) :
+        FFTEngine fftEngine,
+        size_t oversampling) :
     ModCodec(),
     RemoteControllable("guardinterval"),
     m_fftEngine(fftEngine),
-    m_params(nbSymbols, spacing, nullSize, symSize, windowOverlap)
+    m_params(nbSymbols, spacing, nullSize, symSize, windowOverlap, oversampling)
 {
     if (nullSize == 0) {
         throw std::logic_error("NULL symbol must be present");
@@ -95,25 +98,30 @@ GuardIntervalInserter::GuardIntervalInserter(
 
 void GuardIntervalInserter::update_window(size_t new_window_overlap)
 {
-    std::lock_guard<std::mutex> lock(m_params.windowMutex);
+    Window w;
+    w.overlap = new_window_overlap * m_params.oversampling;
+    const size_t windowOverlap = w.overlap;
+
+    // The window only contains the rising window edge.
+    w.windowFloat.resize(2*windowOverlap);
+    w.windowFix.resize(2*windowOverlap);
+    w.windowFixWide.resize(2*windowOverlap);
+    for (size_t i = 0; i < 2*windowOverlap; i++) {
+        const float value = (float)(0.5 * (1.0 - cos(M_PI * i / (2*windowOverlap - 1))));
+
+        w.windowFloat[i] = value;
+        w.windowFix[i] = complexfix::value_type((double)value);
+        w.windowFixWide[i] = complexfix_wide::value_type((double)value);
+    }
 
+    m_window.store(std::move(w));
     m_params.windowOverlap = new_window_overlap;
-
-    // m_params.window only contains the rising window edge.
-    m_params.windowFloat.resize(2*m_params.windowOverlap);
-    m_params.windowFix.resize(2*m_params.windowOverlap);
-    m_params.windowFixWide.resize(2*m_params.windowOverlap);
-    for (size_t i = 0; i < 2*m_params.windowOverlap; i++) {
-        const float value = (float)(0.5 * (1.0 - cos(M_PI * i / (2*m_params.windowOverlap - 1))));
-
-        m_params.windowFloat[i] = value;
-        m_params.windowFix[i] = complexfix::value_type((double)value);
-        m_params.windowFixWide[i] = complexfix_wide::value_type((double)value);
-    }
 }
 
 template<typename T>
-int do_process(const GuardIntervalInserter::Params& p, Buffer* const dataIn, Buffer* dataOut)
+int do_process(const GuardIntervalInserter::Params& p,
+        const GuardIntervalInserter::Window& w,
+        Buffer* const dataIn, Buffer* dataOut)
 {
     PDEBUG("GuardIntervalInserter do_process(dataIn: %p, dataOut: %p)\n",
             dataIn, dataOut);
@@ -145,8 +153,9 @@ int do_process(const GuardIntervalInserter::Params& p, Buffer* const dataIn, Buf
     // TODO remember the end of the last TF so that we can do some
     //      windowing too.
 
-    std::lock_guard<std::mutex> lock(p.windowMutex);
-    if (p.windowOverlap) {
+    // Window overlap at the rate of the input symbols
+    const size_t windowOverlap = w.overlap;
+    if (windowOverlap) {
         {
             // Handle Null symbol separately because it is longer
             const size_t prefixlength = p.nullSize - p.spacing;
@@ -155,36 +164,36 @@ int do_process(const GuardIntervalInserter::Params& p, Buffer* const dataIn, Buf
             memcpy(out, &in[p.spacing - prefixlength],
                     prefixlength * sizeof(T));
 
-            memcpy(&out[prefixlength], in, (p.spacing - p.windowOverlap) * sizeof(T));
+            memcpy(&out[prefixlength], in, (p.spacing - windowOverlap) * sizeof(T));
 
             // The remaining part of the symbol must have half of the window applied,
             // sloping down from 1 to 0.5
-            for (size_t i = 0; i < p.windowOverlap; i++) {
-                const size_t out_ix = prefixlength + p.spacing - p.windowOverlap + i;
-                const size_t in_ix = p.spacing - p.windowOverlap + i;
+            for (size_t i = 0; i < windowOverlap; i++) {
+                const size_t out_ix = prefixlength + p.spacing - windowOverlap + i;
+                const size_t in_ix = p.spacing - windowOverlap + i;
                 if constexpr (std::is_same_v<complexf, T>) {
-                    out[out_ix] = in[in_ix] * p.windowFloat[2*p.windowOverlap - (i+1)];
+                    out[out_ix] = in[in_ix] * w.windowFloat[2*windowOverlap - (i+1)];
                 }
                 if constexpr (std::is_same_v<complexfix, T>) {
-                    out[out_ix] = in[in_ix] * p.windowFix[2*p.windowOverlap - (i+1)];
+                    out[out_ix] = in[in_ix] * w.windowFix[2*windowOverlap - (i+1)];
                 }
                 if constexpr (std::is_same_v<complexfix_wide, T>) {
-                    out[out_ix] = in[in_ix] * p.windowFixWide[2*p.windowOverlap - (i+1)];
+                    out[out_ix] = in[in_ix] * w.windowFixWide[2*windowOverlap - (i+1)];
                 }
             }
 
             // Suffix is taken from the beginning of the symbol, and sees the other
             // half of the window applied.
-            for (size_t i = 0; i < p.windowOverlap; i++) {
+            for (size_t i = 0; i < windowOverlap; i++) {
                 const size_t out_ix = prefixlength + p.spacing + i;
                 if constexpr (std::is_same_v<complexf, T>) {
-                    out[out_ix] = in[i] * p.windowFloat[p.windowOverlap - (i+1)];
+                    out[out_ix] = in[i] * w.windowFloat[windowOverlap - (i+1)];
                 }
                 if constexpr (std::is_same_v<complexfix, T>) {
-                    out[out_ix] = in[i] * p.windowFix[p.windowOverlap - (i+1)];
+                    out[out_ix] = in[i] * w.windowFix[windowOverlap - (i+1)];
                 }
                 if constexpr (std::is_same_v<complexfix_wide, T>) {
-                    out[out_ix] = in[i] * p.windowFixWide[p.windowOverlap - (i+1)];
+                    out[out_ix] = in[i] * w.windowFixWide[windowOverlap - (i+1)];
                 }
             }
 
@@ -198,22 +207,22 @@ int do_process(const GuardIntervalInserter::Params& p, Buffer* const dataIn, Buf
         for (size_t sym_ix = 0; sym_ix < p.nbSymbols; sym_ix++) {
             /* _ix variables are indices into in[], _ox variables are
              * indices for out[] */
-            const ssize_t start_rise_ox = -p.windowOverlap;
-            const size_t start_rise_ix = 2 * p.spacing - p.symSize - p.windowOverlap;
+            const ssize_t start_rise_ox = -windowOverlap;
+            const size_t start_rise_ix = 2 * p.spacing - p.symSize - windowOverlap;
             /*
                const size_t start_real_symbol_ox = 0;
                const size_t start_real_symbol_ix = 2 * p.spacing - p.symSize;
                */
-            const ssize_t end_rise_ox = p.windowOverlap;
-            const size_t end_rise_ix = 2 * p.spacing - p.symSize + p.windowOverlap;
+            const ssize_t end_rise_ox = windowOverlap;
+            const size_t end_rise_ix = 2 * p.spacing - p.symSize + windowOverlap;
             const ssize_t end_cyclic_prefix_ox = p.symSize - p.spacing;
             /* end_cyclic_prefix_ix = end of symbol
-               const size_t begin_fall_ox = p.symSize - p.windowOverlap;
-               const size_t begin_fall_ix = p.spacing - p.windowOverlap;
+               const size_t begin_fall_ox = p.symSize - windowOverlap;
+               const size_t begin_fall_ix = p.spacing - windowOverlap;
                const size_t end_real_symbol_ox = p.symSize;
                end_real_symbol_ix = end of symbol
-               const size_t end_fall_ox = p.symSize + p.windowOverlap;
-               const size_t end_fall_ix = p.spacing + p.windowOverlap;
+               const size_t end_fall_ox = p.symSize + windowOverlap;
+               const size_t end_fall_ix = p.spacing + windowOverlap;
                */
 
             ssize_t ox = start_rise_ox;
@@ -221,13 +230,13 @@ int do_process(const GuardIntervalInserter::Params& p, Buffer* const dataIn, Buf
 
             for (size_t i = 0; ix < end_rise_ix; i++) {
                 if constexpr (std::is_same_v<complexf, T>) {
-                    out[ox] += in[ix] * p.windowFloat.at(i);
+                    out[ox] += in[ix] * w.windowFloat.at(i);
                 }
                 if constexpr (std::is_same_v<complexfix, T>) {
-                    out[ox] += in[ix] * p.windowFix.at(i);
+                    out[ox] += in[ix] * w.windowFix.at(i);
                 }
                 if constexpr (std::is_same_v<complexfix_wide, T>) {
-                    out[ox] += in[ix] * p.windowFixWide.at(i);
+                    out[ox] += in[ix] * w.windowFixWide.at(i);
                 }
                 ix++;
                 ox++;
@@ -248,25 +257,25 @@ int do_process(const GuardIntervalInserter::Params& p, Buffer* const dataIn, Buf
                 ox += p.spacing;
             }
             else {
-                // Copy the middle part of the symbol, p.windowOverlap samples
+                // Copy the middle part of the symbol, windowOverlap samples
                 // short of the end.
                 memcpy( &out[ox],
                         &in[ix],
-                        (p.spacing - p.windowOverlap) * sizeof(T));
-                ox += p.spacing - p.windowOverlap;
-                ix += p.spacing - p.windowOverlap;
-                assert(ox == (ssize_t)(p.symSize - p.windowOverlap));
+                        (p.spacing - windowOverlap) * sizeof(T));
+                ox += p.spacing - windowOverlap;
+                ix += p.spacing - windowOverlap;
+                assert(ox == (ssize_t)(p.symSize - windowOverlap));
 
                 // Apply window from 1 to 0.5 for the end of the symbol
                 for (size_t i = 0; ox < (ssize_t)p.symSize; i++) {
                     if constexpr (std::is_same_v<complexf, T>) {
-                        out[ox] = in[ix] * p.windowFloat[2*p.windowOverlap - (i+1)];
+                        out[ox] = in[ix] * w.windowFloat[2*windowOverlap - (i+1)];
                     }
                     if constexpr (std::is_same_v<complexfix, T>) {
-                        out[ox] = in[ix] * p.windowFix[2*p.windowOverlap - (i+1)];
+                        out[ox] = in[ix] * w.windowFix[2*windowOverlap - (i+1)];
                     }
                     if constexpr (std::is_same_v<complexfix_wide, T>) {
-                        out[ox] = in[ix] * p.windowFixWide[2*p.windowOverlap - (i+1)];
+                        out[ox] = in[ix] * w.windowFixWide[2*windowOverlap - (i+1)];
                     }
                     ox++;
                     ix++;
@@ -275,21 +284,21 @@ int do_process(const GuardIntervalInserter::Params& p, Buffer* const dataIn, Buf
 
                 ix = 0;
                 // Cyclic suffix, with window from 0.5 to 0
-                for (size_t i = 0; ox < (ssize_t)(p.symSize + p.windowOverlap); i++) {
+                for (size_t i = 0; ox < (ssize_t)(p.symSize + windowOverlap); i++) {
                     if constexpr (std::is_same_v<complexf, T>) {
-                        out[ox] = in[ix] * p.windowFloat[p.windowOverlap - (i+1)];
+                        out[ox] = in[ix] * w.windowFloat[windowOverlap - (i+1)];
                     }
                     if constexpr (std::is_same_v<complexfix, T>) {
-                        out[ox] = in[ix] * p.windowFix[p.windowOverlap - (i+1)];
+                        out[ox] = in[ix] * w.windowFix[windowOverlap - (i+1)];
                     }
                     if constexpr (std::is_same_v<complexfix_wide, T>) {
-                        out[ox] = in[ix] * p.windowFixWide[p.windowOverlap - (i+1)];
+                        out[ox] = in[ix] * w.windowFixWide[windowOverlap - (i+1)];
                     }
                     ox++;
                     ix++;
                 }
 
-                assert(ix == p.windowOverlap);
+                assert(ix == windowOverlap);
             }
 
             out += p.symSize;
@@ -324,13 +333,15 @@ int do_process(const GuardIntervalInserter::Params& p, Buffer* const dataIn, Buf
 
 int GuardIntervalInserter::process(Buffer* const dataIn, Buffer* dataOut)
 {
+    const auto window = m_window.load();
+
     switch (m_fftEngine) {
         case FFTEngine::FFTW:
-            return do_process<complexf>(m_params, dataIn, dataOut);
+            return do_process<complexf>(m_params, *window, dataIn, dataOut);
         case FFTEngine::KISS:
-            return do_process<complexfix>(m_params, dataIn, dataOut);
+            return do_process<complexfix>(m_params, *window, dataIn, dataOut);
         case FFTEngine::DEXTER:
-            return do_process<complexfix_wide>(m_params, dataIn, dataOut);
+            return do_process<complexfix_wide>(m_params, *window, dataIn, dataOut);
     }
     throw std::logic_error("Unhandled fftEngine variant");
 }
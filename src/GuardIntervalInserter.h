@@ -33,6 +33,7 @@
 #include "ConfigParser.h"
 #include "ModPlugin.h"
 #include "RemoteControl.h"
+#include "Rcu.h"
 #include <vector>
 
 /* The GuardIntervalInserter prepends the cyclic prefix to all
@@ -41,6 +42,11 @@
  * If windowOverlap is non-zero, it will also add a cyclic suffix of
  * that length, enlarge the cyclic prefix too, and make symbols
  * overlap using a raised cosine window.
+ *
+ * When the OFDM symbols are generated with an oversampled IFFT, the
+ * spacing, nullSize and symSize must be given at the oversampled rate,
+ * whereas windowOverlap is always expressed in samples at 2048000 sps,
+ * and gets scaled internally.
  * */
 class GuardIntervalInserter : public ModCodec, public RemoteControllable
 {
@@ -51,7 +57,8 @@ class GuardIntervalInserter : public ModCodec, public RemoteControllable
                 size_t nullSize,
                 size_t symSize,
                 size_t& windowOverlap,
-                FFTEngine fftEngine);
+                FFTEngine fftEngine,
+                size_t oversampling = 1);
 
         virtual ~GuardIntervalInserter() {}
 
@@ -69,15 +76,22 @@ class GuardIntervalInserter : public ModCodec, public RemoteControllable
                 size_t spacing,
                 size_t nullSize,
                 size_t symSize,
-                size_t& windowOverlap);
+                size_t& windowOverlap,
+                size_t oversampling);
 
             size_t nbSymbols;
             size_t spacing;
             size_t nullSize;
             size_t symSize;
             size_t& windowOverlap;
+            size_t oversampling;
+        };
+
+        // Replaced as a whole when the window length changes
+        struct Window {
+            // Overlap at the rate of the input symbols
+            size_t overlap = 0;
 
-            mutable std::mutex windowMutex;
             std::vector<float> windowFloat;
             std::vector<complexfix::value_type> windowFix;
             std::vector<complexfix_wide::value_type> windowFixWide;
@@ -89,6 +103,7 @@ class GuardIntervalInserter : public ModCodec, public RemoteControllable
         FFTEngine m_fftEngine;
 
         Params m_params;
+        Rcu<Window> m_window;
 
 };
 
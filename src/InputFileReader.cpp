@@ -33,18 +33,59 @@
 #endif
 
 #include <string>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
 #include <cstdio>
 #include <cstring>
 #include <errno.h>
 #include <stdint.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <thread>
 #include "InputReader.h"
 #include "PcDebug.h"
+#include "Utils.h"
 
-int InputFileReader::Open(std::string filename, bool loop)
+// How far ahead of the current frame the kernel should read the file.
+// One second of raw ETI is 256kB.
+static constexpr size_t READAHEAD_LEN = 4 * 1024 * 1024;
+
+// Size of the read-ahead requests, a multiple of the page size
+static constexpr size_t READAHEAD_CHUNK = 1024 * 1024;
+
+// How long to wait for the end of a frame that is still being written
+// to the file, and how often to check the file size in the meantime.
+static constexpr int GROWTH_MAX_WAIT_MS = 100;
+static constexpr int GROWTH_POLL_MS = 5;
+
+InputFileReader::~InputFileReader()
+{
+    // The index cannot be built faster, this waits for it
+    if (index_thread_.joinable()) {
+        index_thread_.join();
+    }
+    Unmap();
+}
+
+int InputFileReader::Open(std::string filename, bool loop, bool preload)
 {
-    filename_ = filename;
     loop_ = loop;
+    preload_ = preload;
+
+    seekable_ = false;
+    Unmap();
+    read_pos_ = 0;
+    readahead_pos_ = 0;
+    frame_number_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(index_mutex_);
+        filename_ = filename;
+        index_.reset();
+        index_generation_++;
+    }
+
     FILE* fd = fopen(filename_.c_str(), "r");
     if (fd == nullptr) {
         etiLog.level(error) << "Unable to open input file!";
@@ -53,15 +94,189 @@ int InputFileReader::Open(std::string filename, bool loop)
     }
     inputfile_.reset(fd);
 
+    struct stat inputFileStat;
+    if (fstat(fileno(fd), &inputFileStat) == 0 and
+            S_ISREG(inputFileStat.st_mode) and inputFileStat.st_size > 0) {
+        if (Map() == 0) {
+            const int ret = IdentifyMappedType();
+            seekable_ = (ret == 0);
+            return ret;
+        }
+        etiLog.level(warn) << "Reading input file " << filename_ <<
+            " without mapping it into memory";
+    }
+    else if (preload_) {
+        etiLog.level(warn) << "Input " << filename_ <<
+            " is not a regular file, it cannot be preloaded";
+    }
+
     return IdentifyType();
 }
 
 int InputFileReader::Rewind()
 {
+    frame_number_ = 0;
+
+    if (map_) {
+        read_pos_ = first_frame_pos_;
+        readahead_pos_ = 0;
+
+        // Follow a change of the file size, at least at the loop boundary
+        struct stat inputFileStat;
+        if (fstat(fileno(inputfile_.get()), &inputFileStat) == 0 and
+                (size_t)inputFileStat.st_size != map_len_) {
+            if (Map() != 0) {
+                return -1;
+            }
+            ReadAhead(read_pos_);
+        }
+        return 0;
+    }
+
     rewind(inputfile_.get()); // Also clears the EOF flag
     return IdentifyType();
 }
 
+int InputFileReader::Map()
+{
+    struct stat inputFileStat;
+    if (fstat(fileno(inputfile_.get()), &inputFileStat) != 0) {
+        etiLog.level(error) << "Unable to stat input file " << filename_ <<
+            ": " << strerror(errno);
+        return -1;
+    }
+    const size_t len = inputFileStat.st_size;
+
+    int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+    if (preload_) {
+        // Read the whole file now, instead of when the frames get accessed
+        flags |= MAP_POPULATE;
+    }
+#endif
+
+    void *map = mmap(nullptr, len, PROT_READ, flags, fileno(inputfile_.get()), 0);
+    if (map == MAP_FAILED) {
+        etiLog.level(error) << "Unable to map input file " << filename_ <<
+            ": " << strerror(errno);
+        return -1;
+    }
+
+    // When the file has grown, replace the previous mapping
+    Unmap();
+    map_ = reinterpret_cast<const uint8_t*>(map);
+    map_len_ = len;
+    inputfilelength_ = len;
+
+    if (preload_) {
+        if (mlock(map, len) != 0) {
+            etiLog.level(warn) << "Unable to lock input file " << filename_ <<
+                " in memory: " << strerror(errno) <<
+                ". Check the limit of locked memory (ulimit -l).";
+        }
+    }
+    else {
+        madvise(map, len, MADV_SEQUENTIAL);
+        readahead_pos_ -= readahead_pos_ % READAHEAD_CHUNK;
+    }
+
+    return 0;
+}
+
+void InputFileReader::Unmap()
+{
+    if (map_) {
+        munmap(const_cast<uint8_t*>(map_), map_len_);
+        map_ = nullptr;
+        map_len_ = 0;
+    }
+}
+
+bool InputFileReader::MapGrownFile(size_t len, int max_wait_ms)
+{
+    for (int waited_ms = 0; ; waited_ms += GROWTH_POLL_MS) {
+        struct stat inputFileStat;
+        if (fstat(fileno(inputfile_.get()), &inputFileStat) != 0) {
+            return false;
+        }
+
+        if ((size_t)inputFileStat.st_size >= len and
+                (size_t)inputFileStat.st_size > map_len_) {
+            return Map() == 0;
+        }
+
+        if (waited_ms >= max_wait_ms) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(GROWTH_POLL_MS));
+    }
+}
+
+void InputFileReader::ReadAhead(size_t pos)
+{
+    if (preload_) {
+        return;
+    }
+
+    const size_t end = std::min(pos + READAHEAD_LEN, map_len_);
+    while (readahead_pos_ < end) {
+        const size_t len = std::min(READAHEAD_CHUNK, map_len_ - readahead_pos_);
+        madvise(const_cast<uint8_t*>(map_) + readahead_pos_, len, MADV_WILLNEED);
+        readahead_pos_ += len;
+    }
+}
+
+int InputFileReader::IdentifyMappedType()
+{
+    auto is_sync = [this](size_t pos) {
+        uint32_t sync;
+        if (pos + sizeof(sync) > map_len_) {
+            return false;
+        }
+        memcpy(&sync, map_ + pos, sizeof(sync));
+        return (sync == 0x49c5f8ff) || (sync == 0xb63a07ff);
+    };
+
+    if (is_sync(0)) {
+        streamtype_ = EtiStreamType::Raw;
+        first_frame_pos_ = 0;
+        nbframes_ = map_len_ / 6144;
+    }
+    else if (is_sync(2)) {
+        streamtype_ = EtiStreamType::Streamed;
+        first_frame_pos_ = 0;
+        uint16_t frameSize;
+        memcpy(&frameSize, map_, sizeof(frameSize));
+        nbframes_ = map_len_ / (frameSize + 2);
+    }
+    else if (is_sync(6)) {
+        streamtype_ = EtiStreamType::Framed;
+        first_frame_pos_ = 4; // Skip nbFrames
+        nbframes_ = ~0;
+    }
+    else {
+        // Search for the sync marker byte by byte
+        streamtype_ = EtiStreamType::None;
+        for (size_t pos = 7; pos < 6144 + 7; ++pos) {
+            if (is_sync(pos)) {
+                streamtype_ = EtiStreamType::Raw;
+                first_frame_pos_ = pos;
+                nbframes_ = (map_len_ - pos) / 6144;
+                break;
+            }
+        }
+
+        if (streamtype_ == EtiStreamType::None) {
+            etiLog.level(error) << "Bad input file format!";
+            return -1;
+        }
+    }
+
+    read_pos_ = first_frame_pos_;
+    ReadAhead(read_pos_);
+    return 0;
+}
+
 int InputFileReader::IdentifyType()
 {
     EtiStreamType streamType = EtiStreamType::None;
@@ -207,6 +422,9 @@ std::string InputFileReader::GetPrintableInfo() const
             break;
     }
     info += ", length: " + std::to_string(inputfilelength_);
+    if (map_) {
+        info += preload_ ? ", preloaded" : ", memory-mapped";
+    }
     if (~nbframes_ != 0) {
         info += ", nb frames: " + std::to_string(nbframes_);
     }
@@ -217,6 +435,91 @@ std::string InputFileReader::GetPrintableInfo() const
 }
 
 int InputFileReader::GetNextFrame(void* buffer)
+{
+    if (map_ == nullptr) {
+        return ReadNextFrame(buffer);
+    }
+
+    const uint8_t *frame = nullptr;
+    const int frameSize = GetNextMappedFrame(frame);
+    if (frameSize <= 0) {
+        return frameSize;
+    }
+
+    memcpy(buffer, frame, frameSize);
+    memset(&((uint8_t*)buffer)[frameSize], 0x55, 6144 - frameSize);
+
+    return 6144;
+}
+
+int InputFileReader::GetNextFrameView(const uint8_t*& frame)
+{
+    if (map_) {
+        return GetNextMappedFrame(frame);
+    }
+
+    frame_buffer_.resize(6144);
+    frame = frame_buffer_.data();
+    return ReadNextFrame(frame_buffer_.data());
+}
+
+int InputFileReader::GetNextMappedFrame(const uint8_t*& frame)
+{
+    const size_t header_len =
+        (streamtype_ == EtiStreamType::Raw) ? 0 : sizeof(uint16_t);
+
+    size_t remaining = map_len_ - read_pos_;
+    if (remaining == 0 or remaining < header_len) {
+        if (MapGrownFile(map_len_ + 1, 0)) {
+            // The file is still being written
+        }
+        else if (loop_) {
+            if (Rewind() != 0) {
+                return -1;
+            }
+        }
+        else {
+            return 0;
+        }
+        remaining = map_len_ - read_pos_;
+    }
+
+    size_t frameSize = 6144;
+    if (header_len > 0) {
+        uint16_t size;
+        memcpy(&size, map_ + read_pos_, sizeof(size));
+        frameSize = size;
+    }
+
+    if (frameSize > 6144) { // there might be a better limit
+        etiLog.level(error) << "Wrong frame size " << frameSize << " in ETI file!";
+        return -1;
+    }
+
+    if (header_len + frameSize > remaining) {
+        // The writer of a growing file might not have finished the frame,
+        // give it some time before failing.
+        if (MapGrownFile(read_pos_ + header_len + frameSize, GROWTH_MAX_WAIT_MS)) {
+            remaining = map_len_ - read_pos_;
+        }
+    }
+
+    if (header_len + frameSize > remaining) {
+        // Input files must not contain incomplete frames
+        etiLog.level(error) <<
+                "Unable to read a complete frame of " << frameSize << " data bytes from input file!";
+        return -1;
+    }
+
+    frame = map_ + read_pos_ + header_len;
+    read_pos_ += header_len + frameSize;
+    ReadAhead(read_pos_);
+    frame_number_++;
+
+    return frameSize;
+}
+
+int InputFileReader::ReadNextFrame(void* buffer)
 {
     uint16_t frameSize;
 
@@ -283,6 +586,131 @@ int InputFileReader::GetNextFrame(void* buffer)
     }
 
     memset(&((uint8_t*)buffer)[frameSize], 0x55, 6144 - frameSize);
+    frame_number_++;
 
     return 6144;
 }
+
+std::shared_ptr<const EtiFileIndex> InputFileReader::GetIndex()
+{
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    return index_;
+}
+
+void InputFileReader::LoadIndex()
+{
+    if (not IsSeekable()) {
+        throw std::runtime_error("Input " + filename_ + " is not seekable");
+    }
+
+    auto index = std::make_shared<EtiFileIndex>(filename_);
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    index_ = index;
+}
+
+uint64_t InputFileReader::FindFrame(const std::string& target)
+{
+    std::shared_ptr<const EtiFileIndex> index;
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(index_mutex_);
+        index = index_;
+        filename = filename_;
+
+        if (not IsSeekable()) {
+            throw std::invalid_argument("Input " + filename + " is not seekable");
+        }
+
+        if (not index) {
+            if (not index_building_) {
+                if (index_thread_.joinable()) {
+                    index_thread_.join();
+                }
+
+                index_building_ = true;
+                const uint64_t generation = index_generation_;
+                index_thread_ = std::thread([this, filename, generation]() {
+                    set_thread_name("etiindex");
+                    std::shared_ptr<const EtiFileIndex> new_index;
+                    try {
+                        new_index = std::make_shared<EtiFileIndex>(filename);
+                    }
+                    catch (const std::runtime_error& e) {
+                        etiLog.level(error) << e.what();
+                    }
+
+                    std::lock_guard<std::mutex> lock(index_mutex_);
+                    if (generation == index_generation_) {
+                        index_ = new_index;
+                    }
+                    index_building_ = false;
+                });
+            }
+
+            throw std::invalid_argument("The index of " + filename +
+                    " is being built, try again later, or create it "
+                    "beforehand with odr-dabmod -I");
+        }
+    }
+
+    if (not target.empty() and target[0] == '@') {
+        const double unix_time = EtiFileIndex::parse_time(target.substr(1));
+        const size_t frame_number = index->find_time(unix_time);
+        if (frame_number == index->size()) {
+            throw std::invalid_argument("No frame at or after " + target.substr(1) +
+                    " in " + filename);
+        }
+        return frame_number;
+    }
+
+    size_t idx = 0;
+    uint64_t frame_number = 0;
+    try {
+        frame_number = std::stoull(target, &idx);
+    }
+    catch (const std::logic_error&) {
+        idx = 0;
+    }
+
+    if (idx == 0 or idx != target.size()) {
+        throw std::invalid_argument("Invalid frame '" + target +
+                "', expected a frame number or @ followed by a time");
+    }
+    else if (frame_number >= index->size()) {
+        throw std::invalid_argument("Frame " + target + " is beyond the end of " +
+                filename + ", which has " + std::to_string(index->size()) + " frames");
+    }
+    return frame_number;
+}
+
+int InputFileReader::Seek(uint64_t frame_number)
+{
+    if (not IsSeekable()) {
+        return -1;
+    }
+
+    const auto index = GetIndex();
+    if (not index) {
+        etiLog.level(error) << "Cannot seek in " << filename_ <<
+            ", its index is not loaded";
+        return -1;
+    }
+
+    if (frame_number >= index->size() or (*index)[frame_number].offset >= map_len_) {
+        etiLog.level(error) << "Cannot seek to frame " << frame_number <<
+            " of " << filename_;
+        return -1;
+    }
+
+    const auto& entry = (*index)[frame_number];
+    etiLog.level(info) << "Seeking to frame " << frame_number << ", FCT " <<
+        (unsigned)entry.fct << ", timestamp " << entry.seconds << "." <<
+        std::setfill('0') << std::setw(3) << entry.tist_ms;
+
+    read_pos_ = entry.offset;
+    readahead_pos_ = read_pos_ - read_pos_ % READAHEAD_CHUNK;
+    ReadAhead(read_pos_);
+    frame_number_ = frame_number;
+
+    return 0;
+}
@@ -32,14 +32,18 @@
 #endif
 
 #include <cstdio>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <unistd.h>
 #include "Log.h"
 #include "Socket.h"
+#include "StreamFramer.h"
+#include "EtiFileIndex.h"
 #define INVALID_SOCKET   -1
 
 class InputReader
@@ -60,15 +64,53 @@ class InputFileReader : public InputReader
         InputFileReader() = default;
         InputFileReader(const InputFileReader& other) = delete;
         InputFileReader& operator=(const InputFileReader& other) = delete;
+        ~InputFileReader();
 
         // open file and determine stream type
         // When loop=1, GetNextFrame will never return 0
-        int Open(std::string filename, bool loop);
+        // When preload=1, a regular file is read into memory entirely
+        // when opening it, and kept there.
+        int Open(std::string filename, bool loop, bool preload = false);
 
         // Print information about the file opened
         virtual std::string GetPrintableInfo() const override;
         virtual int GetNextFrame(void* buffer) override;
 
+        // Set frame to point to the next frame, without copying it. The
+        // frame stays valid until the next call. Padding might be missing
+        // at the end of the frame, depending on the file format.
+        // returns the size of the frame, 0 on eof, -1 on error
+        int GetNextFrameView(const uint8_t*& frame);
+
+        // Only files that are mapped into memory support the functions
+        // below. Can be called from any thread.
+        bool IsSeekable() const { return seekable_.load(); }
+
+        // Number of the next frame, counted from the start of the file
+        uint64_t GetFrameNumber() const { return frame_number_.load(); }
+
+        // Position in the file of the next frame, including its size field.
+        // Must be called from the thread that reads the frames.
+        uint64_t GetPosition() const { return read_pos_; }
+
+        /* Load the index of the file, or build it if there is no valid
+         * sidecar file. This reads the whole file, and can take a while.
+         * Throws std::runtime_error on failure. */
+        void LoadIndex();
+
+        /* Return the number of the frame given by target, which is either
+         * a frame number, or a time prefixed by @ (see
+         * EtiFileIndex::parse_time). Can be called from any thread, and
+         * never waits for the index: if it is not loaded yet, it gets
+         * loaded or built in a separate thread, and this call fails.
+         * Throws std::invalid_argument if the frame cannot be found. */
+        uint64_t FindFrame(const std::string& target);
+
+        /* Continue reading at the given frame. Must be called from the
+         * thread that reads the frames.
+         * returns 0 on success, -1 on failure */
+        int Seek(uint64_t frame_number);
+
     private:
         int IdentifyType();
 
@@ -76,7 +118,33 @@ class InputFileReader : public InputReader
         // returns 0 on success, -1 on failure
         int Rewind();
 
+        // Read the next frame from a file that is not mapped into memory
+        int ReadNextFrame(void* buffer);
+
+        /* Regular files are mapped into memory, the frames are then found
+         * by pointer arithmetic. Pipes and fifos are read with fread.
+         *
+         * A file that grows while it is played gets mapped again when the
+         * end of the mapping is reached. A file must however never be
+         * truncated or rewritten in place while it is mapped: accessing
+         * the pages beyond its new end raises SIGBUS. */
+        int Map();
+        void Unmap();
+
+        /* Map the file again once it is at least len bytes long, and
+         * larger than the current mapping. Waits at most max_wait_ms.
+         * Returns true if the mapping was extended. */
+        bool MapGrownFile(size_t len, int max_wait_ms);
+        int IdentifyMappedType();
+        int GetNextMappedFrame(const uint8_t*& frame);
+
+        // Hint the kernel to read the part of the file that follows pos
+        void ReadAhead(size_t pos);
+
+        std::shared_ptr<const EtiFileIndex> GetIndex();
+
         bool loop_; // if shall we loop the file over and over
+        bool preload_ = false;
         std::string filename_;
 
         /* Known types of input streams. Description taken from the CRC
@@ -123,6 +191,34 @@ class InputFileReader : public InputReader
         size_t inputfilelength_ = 0;
         uint64_t nbframes_ = 0; // 64-bit because 32-bit overflow is
         // after 2**32 * 24ms ~= 3.3 years
+
+        // The file mapping, nullptr if the file is read with fread
+        const uint8_t* map_ = nullptr;
+        size_t map_len_ = 0;
+
+        size_t first_frame_pos_ = 0; // offset of the first frame in the mapping
+        size_t read_pos_ = 0; // offset of the next frame in the mapping
+        size_t readahead_pos_ = 0; // end of the part already hinted to the kernel
+
+        // Holds the frame returned by GetNextFrameView when not mapped
+        std::vector<uint8_t> frame_buffer_;
+
+        std::atomic<uint64_t> frame_number_ = ATOMIC_VAR_INIT(0);
+
+        // Set when the file is opened, as the mapping can be replaced
+        // while the remote control checks it
+        std::atomic<bool> seekable_ = ATOMIC_VAR_INIT(false);
+
+        // Loaded on the first seek, by index_thread_. index_mutex_ also
+        // protects filename_, which the remote control reads.
+        std::mutex index_mutex_;
+        std::shared_ptr<const EtiFileIndex> index_;
+        std::thread index_thread_;
+        bool index_building_ = false;
+
+        // Incremented by Open, so that the index of a file opened earlier
+        // does not get used
+        uint64_t index_generation_ = 0;
 };
 
 class InputTcpReader : public InputReader
@@ -140,6 +236,7 @@ class InputTcpReader : public InputReader
 
     private:
         Socket::TCPClient m_tcpclient;
+        StreamFramer m_framer = StreamFramer("ETI TCP input", StreamFramer::eti_framing);
         std::string m_uri;
 };
 
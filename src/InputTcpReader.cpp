@@ -34,6 +34,7 @@
 #include "Utils.h"
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
 
 void InputTcpReader::Open(const std::string& endpoint)
 {
@@ -68,22 +69,27 @@ void InputTcpReader::Open(const std::string& endpoint)
 
 int InputTcpReader::GetNextFrame(void* buffer)
 {
-    uint8_t* buf = (uint8_t*)buffer;
-
-    const size_t framesize = 6144;
     const int timeout_ms = 8000;
 
-    ssize_t ret = m_tcpclient.recv(buf, framesize, MSG_WAITALL, timeout_ms);
-
-    if (ret == 0) {
-        etiLog.level(debug) << "TCP input auto reconnect";
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-    }
-    else if (ret == -2) {
-        etiLog.level(debug) << "TCP input timeout";
+    const uint8_t *frame = nullptr;
+    size_t framesize = 0;
+    while (not m_framer.next_packet(frame, framesize)) {
+        const ssize_t ret = m_framer.fill(m_tcpclient, timeout_ms);
+
+        if (ret == 0) {
+            // Timeout or reconnection, a partial frame cannot be completed
+            m_framer.reset();
+            etiLog.level(debug) << "TCP input auto reconnect";
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            return 0;
+        }
+        else if (ret < 0) {
+            return ret;
+        }
     }
 
-    return ret;
+    memcpy(buffer, frame, framesize);
+    return framesize;
 }
 
 std::string InputTcpReader::GetPrintableInfo() const
@@ -9,9 +9,11 @@
     http://opendigitalradio.org
 
    This block implements both a memoryless polynom for digital predistortion,
-   and a lookup table predistorter.
+   and two lookup table predistorters: a coarse one with 32 entries, and
+   one with up to 4096 entries that interpolates between them.
    For better performance, multiplying is done in another thread, leading
-   to a pipeline delay of two calls to MemlessPoly::process
+   to a pipeline delay of two calls to MemlessPoly::process, and every
+   frame is shared out in chunks to a WorkerPool.
  */
 /*
    This file is part of ODR-DabMod.
@@ -40,25 +42,30 @@
 #include <cstring>
 #include <stdexcept>
 #include <string>
-#include <future>
 #include <array>
 #include <iostream>
 #include <fstream>
 #include <memory>
 #include <complex>
 
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define MEMLESSPOLY_AVX2_KERNELS 1
+#endif
+
 using namespace std;
 
 // Number of AM/AM coefs, identical to number of AM/PM coefs
 #define NUM_COEFS 5
 
-MemlessPoly::MemlessPoly(std::string& coefs_file, unsigned int num_threads) :
+MemlessPoly::MemlessPoly(std::string& coefs_file, unsigned int num_threads, bool pin_threads) :
     PipelinedModCodec(),
     RemoteControllable("memlesspoly"),
-    m_coefs_am(),
-    m_coefs_pm(),
-    m_coefs_file(coefs_file),
-    m_coefs_mutex()
+    // poly.num_threads counts the threads in addition to the one calling
+    // process(), which also takes part.
+    m_workers("MemlessPoly", num_threads == 0 ? 0 : num_threads + 1, pin_threads),
+    m_dpd_settings(),
+    m_coefs_file(coefs_file)
 {
     PDEBUG("MemlessPoly::MemlessPoly(%s) @ %p\n",
             coefs_file.c_str(), this);
@@ -68,32 +75,15 @@ MemlessPoly::MemlessPoly(std::string& coefs_file, unsigned int num_threads) :
     RC_ADD_PARAMETER(coeffile, "Filename containing coefficients. "
             "When set, the file gets loaded.");
 
+    select_kernels();
+
     if (num_threads == 0) {
-        const unsigned int hw_concurrency = std::thread::hardware_concurrency();
         etiLog.level(info) << "Digital Predistorter will use " <<
-            hw_concurrency << " threads (auto detected)";
-
-        for (size_t i = 0; i < hw_concurrency; i++) {
-            m_workers.emplace_back();
-        }
-
-        for (auto& worker : m_workers) {
-            worker.thread = std::thread(
-                    &MemlessPoly::worker_thread, &worker);
-        }
+            m_workers.num_threads() << " threads (auto detected)";
     }
     else {
         etiLog.level(info) << "Digital Predistorter will use " <<
-            num_threads << " threads (set in config file)";
-
-        for (size_t i = 0; i < num_threads; i++) {
-            m_workers.emplace_back();
-        }
-
-        for (auto& worker : m_workers) {
-            worker.thread = std::thread(
-                    &MemlessPoly::worker_thread, &worker);
-        }
+            m_workers.num_threads() << " threads (set in config file)";
     }
 
     ifstream coefs_fstream(m_coefs_file);
@@ -109,33 +99,44 @@ MemlessPoly::~MemlessPoly()
 
 constexpr uint8_t file_format_odd_poly = 1;
 constexpr uint8_t file_format_lut = 2;
+constexpr uint8_t file_format_interp_lut = 3;
 
 std::string MemlessPoly::serialise_coefficients() const
 {
     stringstream ss;
 
-    std::lock_guard<std::mutex> lock(m_coefs_mutex);
+    const auto dpd = m_dpd_settings.load();
 
-    if (m_dpd_settings_valid) {
-        switch (m_dpd_type) {
+    if (dpd->valid) {
+        switch (dpd->type) {
             case dpd_type_t::odd_only_poly:
                 ss << (int)file_format_odd_poly << endl;
-                ss << m_coefs_am.size() << endl;
-                for (const auto& coef : m_coefs_am) {
+                ss << dpd->coefs_am.size() << endl;
+                for (const auto& coef : dpd->coefs_am) {
                     ss << coef << endl;
                 }
-                for (const auto& coef : m_coefs_pm) {
+                for (const auto& coef : dpd->coefs_pm) {
                     ss << coef << endl;
                 }
                 break;
             case dpd_type_t::lookup_table:
                 ss << (int)file_format_lut << endl;
-                ss << m_lut.size() << endl;
-                ss << m_lut_scalefactor << endl;
-                for (const auto& l : m_lut) {
+                ss << dpd->lut.size() << endl;
+                ss << dpd->lut_scalefactor << endl;
+                for (const auto& l : dpd->lut) {
                     ss << l << endl;
                 }
                 break;
+            case dpd_type_t::interpolated_lookup_table:
+                ss << (int)file_format_interp_lut << endl;
+                // The duplicated last entry is not part of the file
+                ss << dpd->interp_lut.size() - 1 << endl;
+                ss << dpd->lut_scalefactor << endl;
+                for (size_t n = 0; n < dpd->interp_lut.size() - 1; n++) {
+                    ss << dpd->interp_lut[n].real() << endl;
+                    ss << dpd->interp_lut[n].imag() << endl;
+                }
+                break;
         }
     }
 
@@ -189,16 +190,14 @@ void MemlessPoly::load_coefficients(std::istream& coef_stream)
             }
         }
 
-        {
-            std::lock_guard<std::mutex> lock(m_coefs_mutex);
+        dpd_settings_t dpd;
+        dpd.valid = true;
+        dpd.type = dpd_type_t::odd_only_poly;
+        dpd.coefs_am = std::move(coefs_am);
+        dpd.coefs_pm = std::move(coefs_pm);
+        m_dpd_settings.store(std::move(dpd));
 
-            m_dpd_type = dpd_type_t::odd_only_poly;
-            m_coefs_am = coefs_am;
-            m_coefs_pm = coefs_pm;
-            m_dpd_settings_valid = true;
-        }
-        etiLog.log(info, "MemlessPoly loaded %zu poly coefs",
-                m_coefs_am.size() + m_coefs_pm.size());
+        etiLog.log(info, "MemlessPoly loaded %d poly coefs", n_entries);
     }
     else if (file_format_indicator == file_format_lut) {
         float scalefactor;
@@ -213,21 +212,65 @@ void MemlessPoly::load_coefficients(std::istream& coef_stream)
             lut[n] = a;
         }
 
-        {
-            std::lock_guard<std::mutex> lock(m_coefs_mutex);
+        dpd_settings_t dpd;
+        dpd.valid = true;
+        dpd.type = dpd_type_t::lookup_table;
+        dpd.lut_scalefactor = scalefactor;
+        dpd.lut = lut;
+        m_dpd_settings.store(std::move(dpd));
+
+        etiLog.log(info, "MemlessPoly loaded %zu LUT entries", lut.size());
+    }
+    else if (file_format_indicator == file_format_interp_lut) {
+        size_t n_entries = 0;
+        coef_stream >> n_entries;
+
+        if (n_entries < interp_lut_min_entries or
+                n_entries > interp_lut_max_entries) {
+            throw std::runtime_error("MemlessPoly: invalid number of LUT entries: " +
+                    std::to_string(n_entries) + " expected between " +
+                    std::to_string(interp_lut_min_entries) + " and " +
+                    std::to_string(interp_lut_max_entries));
+        }
+
+        float scalefactor;
+        coef_stream >> scalefactor;
+
+        if (not (scalefactor > 0)) {
+            throw std::runtime_error("MemlessPoly: invalid LUT scalefactor");
+        }
+
+        std::vector<complexf> lut(n_entries + 1);
+
+        for (size_t n = 0; n < n_entries; n++) {
+            float re, im;
+            coef_stream >> re >> im;
+
+            if (coef_stream.fail()) {
+                etiLog.log(error, "MemlessPoly: LUT should contain %zu entries, "
+                        "but could only read %zu entries !",
+                        n_entries, n);
+                throw std::runtime_error("MemlessPoly: coefs file invalid !");
+            }
 
-            m_dpd_type = dpd_type_t::lookup_table;
-            m_lut_scalefactor = scalefactor;
-            m_lut = lut;
-            m_dpd_settings_valid = true;
+            lut[n] = complexf(re, im);
         }
+        lut[n_entries] = lut[n_entries - 1];
 
-        etiLog.log(info, "MemlessPoly loaded %zu LUT entries", m_lut.size());
+        dpd_settings_t dpd;
+        dpd.valid = true;
+        dpd.type = dpd_type_t::interpolated_lookup_table;
+        dpd.lut_scalefactor = scalefactor;
+        dpd.interp_lut = std::move(lut);
+        m_dpd_settings.store(std::move(dpd));
+
+        etiLog.log(info, "MemlessPoly loaded %zu interpolated LUT entries",
+                n_entries);
     }
     else {
         etiLog.log(error, "MemlessPoly: coef file has unknown format %d",
                 file_format_indicator);
-        m_dpd_settings_valid = false;
+        m_dpd_settings.update([](dpd_settings_t& dpd) { dpd.valid = false; });
     }
 }
 
@@ -284,8 +327,12 @@ static void apply_lut(
         const float in_mag = std::abs(in[i]);
 
         // The scalefactor is chosen so as to map the input magnitude
-        // to the range of uint32_t
-        const uint32_t scaled_in = lrintf(in_mag * scalefactor);
+        // to the range of uint32_t. Larger magnitudes go into the last
+        // bin, instead of wrapping around to the first ones. The clamp is
+        // done in float, 4294967040 being the largest float below 2^32,
+        // because long is only 32 bits wide on some platforms.
+        const uint32_t scaled_in = llrintf(
+                std::min(4294967040.0f, in_mag * scalefactor));
 
         // lut_ix contains the number of leading 0-bits of the
         // scaled value, starting at the most significant bit position.
@@ -308,35 +355,217 @@ static void apply_lut(
     }
 }
 
-void MemlessPoly::worker_thread(MemlessPoly::worker_t *workerdata)
+static void apply_interp_lut(
+        const complexf *__restrict lut, size_t lut_size, const float scalefactor,
+        const complexf *__restrict in,
+        size_t start, size_t stop, complexf *__restrict out)
 {
-    set_realtime_prio(1);
-    set_thread_name("MemlessPoly");
+    // Inputs beyond the range of the LUT get the correction of the
+    // last entry.
+    const float max_pos = lut_size - 1;
 
-    while (true) {
-        worker_t::input_data_t in_data = {};
-        try {
-            workerdata->in_queue.wait_and_pop(in_data);
-        }
-        catch (const ThreadsafeQueueWakeup&) {
-            break;
-        }
+    for (size_t i = start; i < stop; i++) {
+        // Indexing with the magnitude squared avoids the square root, and
+        // gives more resolution to large amplitudes, where the PA
+        // compresses.
+        const float in_mag_sq = in[i].real() * in[i].real() +
+                                in[i].imag() * in[i].imag();
+
+        // Clamped in float, like in apply_interp_lut_avx2
+        const float pos = std::min(max_pos, in_mag_sq * scalefactor);
+        const size_t ix = pos;
+        const float frac = pos - ix;
+
+        // lut[ix + 1] is valid because the last entry is duplicated
+        const complexf correction = lut[ix] + frac * (lut[ix + 1] - lut[ix]);
+        out[i] = in[i] * correction;
+    }
+}
 
-        switch (in_data.dpd_type) {
-            case dpd_type_t::odd_only_poly:
-                apply_coeff(in_data.coefs_am, in_data.coefs_pm,
-                        in_data.in, in_data.start, in_data.stop,
-                        in_data.out);
-                break;
-            case dpd_type_t::lookup_table:
-                apply_lut(in_data.lut, in_data.lut_scalefactor,
-                        in_data.in, in_data.start, in_data.stop,
-                        in_data.out);
-                break;
-        }
+#if defined(MEMLESSPOLY_AVX2_KERNELS)
+/* The AVX2 kernels process eight samples per iteration. The samples are
+ * deinterleaved into one register holding the real parts and one holding
+ * the imaginary parts. The deinterleaving shuffle does not keep the sample
+ * order, but as all operations are element-wise, the interleaving at the
+ * end restores it.
+ *
+ * These functions are compiled for AVX2 and FMA regardless of the compiler
+ * flags, and are only called if the CPU supports them.
+ *
+ * Their output is not bit-identical to the scalar kernels, because FMA
+ * changes the rounding of the complex products. Measured with 4M random
+ * samples, the difference stays below 3e-7 of the output magnitude,
+ * about two ulp.
+ */
+__attribute__((target("avx2,fma")))
+static inline void deinterleave8(const complexf *in, __m256& re, __m256& im)
+{
+    const float *f = reinterpret_cast<const float*>(in);
+    const __m256 a = _mm256_loadu_ps(f);
+    const __m256 b = _mm256_loadu_ps(f + 8);
+    re = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    im = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+__attribute__((target("avx2,fma")))
+static inline void interleave8(const __m256& re, const __m256& im, complexf *out)
+{
+    float *f = reinterpret_cast<float*>(out);
+    _mm256_storeu_ps(f, _mm256_unpacklo_ps(re, im));
+    _mm256_storeu_ps(f + 8, _mm256_unpackhi_ps(re, im));
+}
 
-        workerdata->out_queue.push(1);
+__attribute__((target("avx2,fma")))
+static inline __m256 horner5(const float *c, const __m256& x)
+{
+    __m256 r = _mm256_set1_ps(c[4]);
+    r = _mm256_fmadd_ps(r, x, _mm256_set1_ps(c[3]));
+    r = _mm256_fmadd_ps(r, x, _mm256_set1_ps(c[2]));
+    r = _mm256_fmadd_ps(r, x, _mm256_set1_ps(c[1]));
+    r = _mm256_fmadd_ps(r, x, _mm256_set1_ps(c[0]));
+    return r;
+}
+
+__attribute__((target("avx2,fma")))
+static void apply_coeff_avx2(
+        const float *__restrict coefs_am, const float *__restrict coefs_pm,
+        const complexf *__restrict in, size_t start, size_t stop,
+        complexf *__restrict out)
+{
+    size_t i = start;
+    for (; i + 8 <= stop; i += 8) {
+        __m256 re, im;
+        deinterleave8(&in[i], re, im);
+
+        const __m256 mag_sq = _mm256_fmadd_ps(re, re, _mm256_mul_ps(im, im));
+
+        const __m256 amplitude_correction = horner5(coefs_am, mag_sq);
+        const __m256 phase_correction = _mm256_sub_ps(
+                _mm256_setzero_ps(), horner5(coefs_pm, mag_sq));
+        const __m256 phase_sq = _mm256_mul_ps(phase_correction, phase_correction);
+
+        // Same approximations for cos and sin as apply_coeff
+        __m256 c = _mm256_fmadd_ps(phase_sq, _mm256_set1_ps(-0.00138888f),
+                _mm256_set1_ps(0.486666f));
+        c = _mm256_fmadd_ps(phase_sq, c, _mm256_set1_ps(-0.5f));
+        c = _mm256_fnmadd_ps(phase_sq, c, _mm256_set1_ps(1.0f));
+
+        __m256 s = _mm256_fmadd_ps(phase_sq, _mm256_set1_ps(0.00833333f),
+                _mm256_set1_ps(0.166666f));
+        s = _mm256_fmadd_ps(phase_sq, s, _mm256_set1_ps(1.0f));
+        s = _mm256_mul_ps(phase_correction, s);
+
+        // out = in * amplitude_correction * (c + js)
+        c = _mm256_mul_ps(c, amplitude_correction);
+        s = _mm256_mul_ps(s, amplitude_correction);
+        const __m256 out_re = _mm256_fmsub_ps(re, c, _mm256_mul_ps(im, s));
+        const __m256 out_im = _mm256_fmadd_ps(re, s, _mm256_mul_ps(im, c));
+
+        interleave8(out_re, out_im, &out[i]);
+    }
+
+    apply_coeff(coefs_am, coefs_pm, in, i, stop, out);
+}
+
+__attribute__((target("avx2,fma")))
+static void apply_lut_avx2(
+        const complexf *__restrict lut, const float scalefactor,
+        const complexf *__restrict in,
+        size_t start, size_t stop, complexf *__restrict out)
+{
+    const float *lut_f = reinterpret_cast<const float*>(lut);
+
+    // Computing the bin directly in floating point avoids the conversion
+    // to uint32_t, which does not exist in AVX2. Floats above 2^24 have no
+    // fractional part, which makes this equivalent to the rounding in
+    // apply_lut. Magnitudes outside the range of the LUT end up in the last
+    // bin. The magnitude comes from a square root instead of std::abs, a
+    // sample within one ulp of a bin boundary can therefore get the
+    // neighbouring entry.
+    const __m256 bin_scale = _mm256_set1_ps(scalefactor / (float)(1u << 27));
+    const __m256 max_bin = _mm256_set1_ps(31.0f); // The LUT has 32 entries
+
+    size_t i = start;
+    for (; i + 8 <= stop; i += 8) {
+        __m256 re, im;
+        deinterleave8(&in[i], re, im);
+
+        const __m256 mag = _mm256_sqrt_ps(
+                _mm256_fmadd_ps(re, re, _mm256_mul_ps(im, im)));
+        const __m256 bin = _mm256_min_ps(
+                _mm256_floor_ps(_mm256_mul_ps(mag, bin_scale)), max_bin);
+
+        // Index of the real part of each complex LUT entry
+        const __m256i ix = _mm256_slli_epi32(_mm256_cvttps_epi32(bin), 1);
+        const __m256 lut_re = _mm256_i32gather_ps(lut_f, ix, 4);
+        const __m256 lut_im = _mm256_i32gather_ps(lut_f + 1, ix, 4);
+
+        const __m256 out_re = _mm256_fmsub_ps(re, lut_re, _mm256_mul_ps(im, lut_im));
+        const __m256 out_im = _mm256_fmadd_ps(re, lut_im, _mm256_mul_ps(im, lut_re));
+
+        interleave8(out_re, out_im, &out[i]);
     }
+
+    apply_lut(lut, scalefactor, in, i, stop, out);
+}
+
+__attribute__((target("avx2,fma")))
+static void apply_interp_lut_avx2(
+        const complexf *__restrict lut, size_t lut_size, const float scalefactor,
+        const complexf *__restrict in,
+        size_t start, size_t stop, complexf *__restrict out)
+{
+    const float *lut_f = reinterpret_cast<const float*>(lut);
+
+    const __m256 scale = _mm256_set1_ps(scalefactor);
+    const __m256 max_pos = _mm256_set1_ps(lut_size - 1);
+
+    size_t i = start;
+    for (; i + 8 <= stop; i += 8) {
+        __m256 re, im;
+        deinterleave8(&in[i], re, im);
+
+        const __m256 mag_sq = _mm256_fmadd_ps(re, re, _mm256_mul_ps(im, im));
+        const __m256 pos = _mm256_min_ps(_mm256_mul_ps(mag_sq, scale), max_pos);
+        const __m256 pos_floor = _mm256_floor_ps(pos);
+        const __m256 frac = _mm256_sub_ps(pos, pos_floor);
+
+        // Index of the real part of each complex LUT entry
+        const __m256i ix = _mm256_slli_epi32(_mm256_cvttps_epi32(pos_floor), 1);
+        const __m256 lut0_re = _mm256_i32gather_ps(lut_f, ix, 4);
+        const __m256 lut0_im = _mm256_i32gather_ps(lut_f + 1, ix, 4);
+        const __m256 lut1_re = _mm256_i32gather_ps(lut_f + 2, ix, 4);
+        const __m256 lut1_im = _mm256_i32gather_ps(lut_f + 3, ix, 4);
+
+        const __m256 corr_re = _mm256_fmadd_ps(frac,
+                _mm256_sub_ps(lut1_re, lut0_re), lut0_re);
+        const __m256 corr_im = _mm256_fmadd_ps(frac,
+                _mm256_sub_ps(lut1_im, lut0_im), lut0_im);
+
+        const __m256 out_re = _mm256_fmsub_ps(re, corr_re, _mm256_mul_ps(im, corr_im));
+        const __m256 out_im = _mm256_fmadd_ps(re, corr_im, _mm256_mul_ps(im, corr_re));
+
+        interleave8(out_re, out_im, &out[i]);
+    }
+
+    apply_interp_lut(lut, lut_size, scalefactor, in, i, stop, out);
+}
+#endif // defined(MEMLESSPOLY_AVX2_KERNELS)
+
+void MemlessPoly::select_kernels()
+{
+    m_apply_coeff = apply_coeff;
+    m_apply_lut = apply_lut;
+    m_apply_interp_lut = apply_interp_lut;
+
+#if defined(MEMLESSPOLY_AVX2_KERNELS)
+    if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma")) {
+        m_apply_coeff = apply_coeff_avx2;
+        m_apply_lut = apply_lut_avx2;
+        m_apply_interp_lut = apply_interp_lut_avx2;
+        etiLog.level(info) << "Digital Predistorter will use AVX2 kernels";
+    }
+#endif
 }
 
 int MemlessPoly::internal_process(Buffer* const dataIn, Buffer* dataOut)
@@ -347,64 +576,50 @@ int MemlessPoly::internal_process(Buffer* const dataIn, Buffer* dataOut)
     complexf* out = reinterpret_cast<complexf*>(dataOut->getData());
     size_t sizeOut = dataOut->getLength() / sizeof(complexf);
 
-    if (m_dpd_settings_valid) {
-        std::lock_guard<std::mutex> lock(m_coefs_mutex);
-        const size_t num_threads = m_workers.size();
-
-        if (num_threads > 0) {
-            const size_t step = sizeOut / num_threads;
-
-            size_t start = 0;
-            for (auto& worker : m_workers) {
-                worker_t::input_data_t dat;
-                dat.dpd_type = m_dpd_type;
-                dat.lut_scalefactor = m_lut_scalefactor;
-                dat.lut = m_lut.data();
-                dat.coefs_am = m_coefs_am.data();
-                dat.coefs_pm = m_coefs_pm.data();
-                dat.in = in;
-                dat.start = start;
-                dat.stop = start + step;
-                dat.out = out;
-
-                worker.in_queue.push(dat);
-
-                start += step;
-            }
-
-            // Do the last in this thread
-            switch (m_dpd_type) {
-                case dpd_type_t::odd_only_poly:
-                    apply_coeff(m_coefs_am.data(), m_coefs_pm.data(),
-                            in, start, sizeOut, out);
-                    break;
-                case dpd_type_t::lookup_table:
-                    apply_lut(m_lut.data(), m_lut_scalefactor,
-                            in, start, sizeOut, out);
-                    break;
-            }
+    // The settings stay the same for the whole frame, even if the remote
+    // control loads new ones in the meantime.
+    const auto dpd = m_dpd_settings.load();
 
-            // Wait for completion of the tasks
-            for (auto& worker : m_workers) {
-                int ret = 0;
-                worker.out_queue.wait_and_pop(ret);
-            }
-        }
-        else {
-            switch (m_dpd_type) {
-                case dpd_type_t::odd_only_poly:
-                    apply_coeff(m_coefs_am.data(), m_coefs_pm.data(),
-                            in, 0, sizeOut, out);
-                    break;
-                case dpd_type_t::lookup_table:
-                    apply_lut(m_lut.data(), m_lut_scalefactor,
-                            in, 0, sizeOut, out);
-                    break;
-            }
+    if (dpd->valid) {
+        switch (dpd->type) {
+            case dpd_type_t::odd_only_poly:
+                {
+                    const float *coefs_am = dpd->coefs_am.data();
+                    const float *coefs_pm = dpd->coefs_pm.data();
+                    m_workers.run(sizeOut, chunk_size,
+                            [&](size_t start, size_t stop) {
+                                m_apply_coeff(coefs_am, coefs_pm,
+                                        in, start, stop, out);
+                            });
+                }
+                break;
+            case dpd_type_t::lookup_table:
+                {
+                    const complexf *lut = dpd->lut.data();
+                    const float scalefactor = dpd->lut_scalefactor;
+                    m_workers.run(sizeOut, chunk_size,
+                            [&](size_t start, size_t stop) {
+                                m_apply_lut(lut, scalefactor,
+                                        in, start, stop, out);
+                            });
+                }
+                break;
+            case dpd_type_t::interpolated_lookup_table:
+                {
+                    const complexf *lut = dpd->interp_lut.data();
+                    const size_t lut_size = dpd->interp_lut.size() - 1;
+                    const float scalefactor = dpd->lut_scalefactor;
+                    m_workers.run(sizeOut, chunk_size,
+                            [&](size_t start, size_t stop) {
+                                m_apply_interp_lut(lut, lut_size, scalefactor,
+                                        in, start, stop, out);
+                            });
+                }
+                break;
         }
     }
     else {
-        memcpy(dataOut->getData(), dataIn->getData(), sizeOut);
+        memcpy(dataOut->getData(), dataIn->getData(), dataIn->getLength());
     }
 
     return dataOut->getLength();
@@ -451,7 +666,7 @@ const string MemlessPoly::get_parameter(const string& parameter) const
 {
     stringstream ss;
     if (parameter == "ncoefs") {
-        ss << m_coefs_am.size();
+        ss << m_dpd_settings.load()->coefs_am.size();
     }
     else if (parameter == "coefs") {
         ss << serialise_coefficients();
@@ -470,7 +685,7 @@ const string MemlessPoly::get_parameter(const string& parameter) const
 const json::map_t MemlessPoly::get_all_values() const
 {
     json::map_t map;
-    map["ncoefs"].v = m_coefs_am.size();
+    map["ncoefs"].v = m_dpd_settings.load()->coefs_am.size();
     map["coefs"].v = serialise_coefficients();
     map["coeffile"].v = m_coefs_file;
     return map;
@@ -32,12 +32,12 @@
 
 #include "RemoteControl.h"
 #include "ModPlugin.h"
-#include "ThreadsafeQueue.h"
+#include "WorkerPool.h"
+#include "Rcu.h"
 
 #include <sys/types.h>
 #include <array>
 #include <string>
-#include <thread>
 #include <vector>
 #include <ctime>
 #include <cstdio>
@@ -46,14 +46,15 @@
 
 enum class dpd_type_t {
     odd_only_poly,
-    lookup_table
+    lookup_table,
+    interpolated_lookup_table
 };
 
 
 class MemlessPoly : public PipelinedModCodec, public RemoteControllable
 {
 public:
-    MemlessPoly(std::string& coefs_file, unsigned int num_threads);
+    MemlessPoly(std::string& coefs_file, unsigned int num_threads, bool pin_threads);
     MemlessPoly(const MemlessPoly& other) = delete;
     MemlessPoly& operator=(const MemlessPoly& other) = delete;
     virtual ~MemlessPoly();
@@ -70,66 +71,50 @@ private:
     void load_coefficients(std::istream& coefData);
     std::string serialise_coefficients() const;
 
-    struct worker_t {
-        struct input_data_t {
-            dpd_type_t dpd_type;
-
-            // Valid for polynomial types
-            const float *coefs_am = nullptr;
-            const float *coefs_pm = nullptr;
-
-            // Valid for LUT
-            float lut_scalefactor = 0.0f;
-            const complexf *lut = nullptr;
-
-            const complexf *in = nullptr;
-            size_t start = 0;
-            size_t stop = 0;
-            complexf *out = nullptr;
-        };
-
-        worker_t() {}
-        worker_t(const worker_t& other) = delete;
-        worker_t operator=(const worker_t& other) = delete;
-        worker_t operator=(worker_t&& other) = delete;
-
-        // The move constructor creates a new in_queue and out_queue,
-        // because ThreadsafeQueue is neither copy- nor move-constructible.
-        // Not an issue because creating the workers happens at startup, before
-        // the first work item.
-        worker_t(worker_t&& other) :
-            in_queue(),
-            out_queue(),
-            thread(std::move(other.thread)) {}
-
-        ~worker_t() {
-            if (thread.joinable()) {
-                in_queue.trigger_wakeup();
-                thread.join();
-            }
-        }
-
-        ThreadsafeQueue<input_data_t> in_queue;
-        ThreadsafeQueue<int> out_queue;
-
-        std::thread thread;
-    };
+    // Choose the fastest implementation supported by the CPU
+    void select_kernels();
 
-    std::vector<worker_t> m_workers;
+    using apply_coeff_func_t = void (*)(
+            const float *coefs_am, const float *coefs_pm,
+            const complexf *in, size_t start, size_t stop, complexf *out);
+    using apply_lut_func_t = void (*)(
+            const complexf *lut, const float scalefactor,
+            const complexf *in, size_t start, size_t stop, complexf *out);
 
-    static void worker_thread(worker_t *workerdata);
+    using apply_interp_lut_func_t = void (*)(
+            const complexf *lut, size_t lut_size, const float scalefactor,
+            const complexf *in, size_t start, size_t stop, complexf *out);
 
-    bool m_dpd_settings_valid = false;
-    dpd_type_t m_dpd_type;
-    std::vector<float> m_coefs_am; // AM/AM coefficients
-    std::vector<float> m_coefs_pm; // AM/PM coefficients
+    apply_coeff_func_t m_apply_coeff = nullptr;
+    apply_lut_func_t m_apply_lut = nullptr;
+    apply_interp_lut_func_t m_apply_interp_lut = nullptr;
 
-    float m_lut_scalefactor; // Scale value applied before looking up in LUT
+    // Number of samples processed at once by one thread
+    static constexpr size_t chunk_size = 4096;
+    WorkerPool m_workers;
 
     static constexpr size_t lut_entries = 32;
-    std::array<complexf, lut_entries> m_lut; // Lookup table correction factors
+    static constexpr size_t interp_lut_min_entries = 256;
+    static constexpr size_t interp_lut_max_entries = 4096;
+
+    struct dpd_settings_t {
+        bool valid = false;
+        dpd_type_t type = dpd_type_t::odd_only_poly;
+        std::vector<float> coefs_am; // AM/AM coefficients
+        std::vector<float> coefs_pm; // AM/PM coefficients
+
+        float lut_scalefactor = 0; // Scale value applied before looking up in LUT
+
+        std::array<complexf, lut_entries> lut; // Lookup table correction factors
+
+        // The interpolated lookup table is indexed by the magnitude squared
+        // multiplied by lut_scalefactor. Its last entry is stored twice,
+        // so that interpolation never reads past the end.
+        std::vector<complexf> interp_lut;
+    };
+
+    Rcu<dpd_settings_t> m_dpd_settings;
 
     std::string& m_coefs_file;
-    mutable std::mutex m_coefs_mutex;
 };
 
@@ -0,0 +1,380 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+
+   This block implements a generalised memory polynomial predistorter.
+   Like MemlessPoly, processing is done in another thread, leading to a
+   pipeline delay of two calls to process(), and every frame is shared out
+   in chunks to a WorkerPool.
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma GCC optimize ("O3")
+
+#include "MemoryPoly.h"
+#include "PcDebug.h"
+#include "Log.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+constexpr uint8_t file_format_gmp = 1;
+
+MemoryPoly::MemoryPoly(std::string& coefs_file, unsigned int num_threads, bool pin_threads) :
+    PipelinedModCodec(),
+    RemoteControllable("memorypoly"),
+    // Same meaning as poly.num_threads: the threads in addition to the
+    // one calling process().
+    m_workers("MemoryPoly", num_threads == 0 ? 0 : num_threads + 1, pin_threads),
+    m_coefs_file(coefs_file)
+{
+    PDEBUG("MemoryPoly::MemoryPoly(%s) @ %p\n",
+            coefs_file.c_str(), this);
+
+    RC_ADD_PARAMETER(ncoefs, "(Read-only) number of coefficients.");
+    RC_ADD_PARAMETER(coefs, "Predistortion coefficients, same format as file.");
+    RC_ADD_PARAMETER(coeffile, "Filename containing coefficients. "
+            "When set, the file gets loaded.");
+
+    if (num_threads == 0) {
+        etiLog.level(info) << "Memory polynomial predistorter will use " <<
+            m_workers.num_threads() << " threads (auto detected)";
+    }
+    else {
+        etiLog.level(info) << "Memory polynomial predistorter will use " <<
+            m_workers.num_threads() << " threads (set in config file)";
+    }
+
+    ifstream coefs_fstream(m_coefs_file);
+    load_coefficients(coefs_fstream);
+
+    start_pipeline_thread();
+}
+
+MemoryPoly::~MemoryPoly()
+{
+    stop_pipeline_thread();
+}
+
+std::string MemoryPoly::serialise_coefficients() const
+{
+    stringstream ss;
+
+    const auto coefs = m_coefs.load();
+
+    ss << (int)file_format_gmp << endl;
+    ss << coefs->order << endl;
+    ss << coefs->memory_depth << endl;
+    ss << coefs->lag_depth << endl;
+    for (const auto& c : coefs->aligned) {
+        ss << c.real() << endl;
+        ss << c.imag() << endl;
+    }
+    for (const auto& c : coefs->lagging) {
+        ss << c.real() << endl;
+        ss << c.imag() << endl;
+    }
+
+    return ss.str();
+}
+
+void MemoryPoly::load_coefficients(std::istream& coef_stream)
+{
+    if (!coef_stream) {
+        throw std::runtime_error("MemoryPoly: Could not open file with coefs!");
+    }
+
+    uint32_t file_format_indicator = 0;
+    coef_stream >> file_format_indicator;
+
+    if (file_format_indicator != file_format_gmp) {
+        throw std::runtime_error("MemoryPoly: coef file has unknown format " +
+                std::to_string(file_format_indicator));
+    }
+
+    coefs_t coefs;
+    coef_stream >> coefs.order >> coefs.memory_depth >> coefs.lag_depth;
+
+    if (coef_stream.fail()) {
+        throw std::runtime_error("MemoryPoly: coefs file has invalid format.");
+    }
+    else if (coefs.order < 1 or coefs.order > max_order) {
+        throw std::runtime_error("MemoryPoly: invalid order " +
+                std::to_string(coefs.order) + ", must be between 1 and " +
+                std::to_string(max_order));
+    }
+    else if (coefs.memory_depth < 1 or coefs.memory_depth > max_memory_depth) {
+        throw std::runtime_error("MemoryPoly: invalid memory depth " +
+                std::to_string(coefs.memory_depth) + ", must be between 1 and " +
+                std::to_string(max_memory_depth));
+    }
+    else if (coefs.lag_depth > max_lag_depth) {
+        throw std::runtime_error("MemoryPoly: invalid lag depth " +
+                std::to_string(coefs.lag_depth) + ", must be at most " +
+                std::to_string(max_lag_depth));
+    }
+
+    coefs.aligned.resize(coefs.order * coefs.memory_depth);
+    coefs.lagging.resize(
+            (coefs.order - 1) * coefs.memory_depth * coefs.lag_depth);
+
+    const size_t n_coefs = coefs.num_coefs();
+    for (size_t n = 0; n < n_coefs; n++) {
+        float re, im;
+        coef_stream >> re >> im;
+
+        if (coef_stream.fail()) {
+            etiLog.log(error, "MemoryPoly: coefs should contain %zu coefs, "
+                    "but could only read %zu coefs !", n_coefs, n);
+            throw std::runtime_error("MemoryPoly: coefs file invalid !");
+        }
+
+        if (n < coefs.aligned.size()) {
+            coefs.aligned[n] = complexf(re, im);
+        }
+        else {
+            coefs.lagging[n - coefs.aligned.size()] = complexf(re, im);
+        }
+    }
+
+    etiLog.log(info, "MemoryPoly loaded %zu coefs, order %zu, "
+            "memory depth %zu, lag depth %zu", n_coefs, coefs.order,
+            coefs.memory_depth, coefs.lag_depth);
+
+    m_coefs.store(std::move(coefs));
+}
+
+/* The restrict keyword is C99, g++ and clang++ however support __restrict
+ * instead, and this allows the compiler to auto-vectorize the loops.
+ */
+static inline void accumulate_basis(
+        const complexf coef, const float *__restrict mag_pow, size_t len,
+        float *__restrict gain_re, float *__restrict gain_im)
+{
+    const float c_re = coef.real();
+    const float c_im = coef.imag();
+
+    for (size_t n = 0; n < len; n++) {
+        gain_re[n] += c_re * mag_pow[n];
+        gain_im[n] += c_im * mag_pow[n];
+    }
+}
+
+static inline void accumulate_output(
+        const float *__restrict x_re, const float *__restrict x_im,
+        const float *__restrict gain_re, const float *__restrict gain_im,
+        size_t len, float *__restrict acc_re, float *__restrict acc_im)
+{
+    for (size_t n = 0; n < len; n++) {
+        acc_re[n] += x_re[n] * gain_re[n] - x_im[n] * gain_im[n];
+        acc_im[n] += x_re[n] * gain_im[n] + x_im[n] * gain_re[n];
+    }
+}
+
+void MemoryPoly::process_chunk(const coefs_t& coefs,
+        size_t start, size_t stop, complexf *out) const
+{
+    const size_t len = stop - start;
+
+    std::array<float, chunk_size> acc_re;
+    std::array<float, chunk_size> acc_im;
+    std::array<float, chunk_size> gain_re;
+    std::array<float, chunk_size> gain_im;
+
+    std::fill_n(acc_re.begin(), len, 0.0f);
+    std::fill_n(acc_im.begin(), len, 0.0f);
+
+    const size_t order = coefs.order;
+    const size_t memory_depth = coefs.memory_depth;
+    const size_t lag_depth = coefs.lag_depth;
+
+    // For every delay m, sum up all terms multiplied to x[n-m] into one
+    // complex gain, and then multiply it to x[n-m]. This needs one
+    // complex multiplication per delay instead of one per term.
+    for (size_t m = 0; m < memory_depth; m++) {
+        const size_t offset = history_len + start - m;
+
+        std::fill_n(gain_re.begin(), len, coefs.aligned[m].real());
+        std::fill_n(gain_im.begin(), len, coefs.aligned[m].imag());
+
+        for (size_t k = 1; k < order; k++) {
+            const float *mag_pow = m_mag_pow.data() + (k-1) * m_stride + offset;
+
+            const complexf a = coefs.aligned[k * memory_depth + m];
+            if (a != 0.0f) {
+                accumulate_basis(a, mag_pow, len, gain_re.data(), gain_im.data());
+            }
+
+            for (size_t l = 1; l <= lag_depth; l++) {
+                const complexf b = coefs.lagging[
+                    ((k-1) * memory_depth + m) * lag_depth + (l-1)];
+                if (b != 0.0f) {
+                    accumulate_basis(b, mag_pow - l, len,
+                            gain_re.data(), gain_im.data());
+                }
+            }
+        }
+
+        accumulate_output(m_in_re.data() + offset, m_in_im.data() + offset,
+                gain_re.data(), gain_im.data(), len,
+                acc_re.data(), acc_im.data());
+    }
+
+    for (size_t n = 0; n < len; n++) {
+        out[start + n] = complexf(acc_re[n], acc_im[n]);
+    }
+}
+
+int MemoryPoly::internal_process(Buffer* const dataIn, Buffer* dataOut)
+{
+    dataOut->setLength(dataIn->getLength());
+
+    const complexf* in = reinterpret_cast<const complexf*>(dataIn->getData());
+    complexf* out = reinterpret_cast<complexf*>(dataOut->getData());
+    const size_t sizeIn = dataIn->getLength() / sizeof(complexf);
+
+    // Use the same coefficients for the whole frame
+    const auto coefs = m_coefs.load();
+
+    // The history is at the beginning of the vectors, and is kept when
+    // the frame length changes.
+    m_stride = history_len + sizeIn;
+    m_in_re.resize(m_stride);
+    m_in_im.resize(m_stride);
+
+    const size_t num_pow = coefs->order - 1;
+    m_mag_pow.resize(num_pow * m_stride);
+
+    float *in_re = m_in_re.data();
+    float *in_im = m_in_im.data();
+    float *mag_pow = m_mag_pow.data();
+    const size_t stride = m_stride;
+
+    // The magnitude powers are also computed for the history, as the
+    // order might have changed since the previous frame.
+    m_workers.run(stride, chunk_size,
+            [&](size_t start, size_t stop) {
+                for (size_t i = std::max(start, history_len); i < stop; i++) {
+                    in_re[i] = in[i - history_len].real();
+                    in_im[i] = in[i - history_len].imag();
+                }
+
+                if (num_pow == 0) {
+                    return;
+                }
+
+                float *mag = mag_pow;
+                for (size_t i = start; i < stop; i++) {
+                    mag[i] = sqrtf(in_re[i] * in_re[i] + in_im[i] * in_im[i]);
+                }
+
+                for (size_t k = 1; k < num_pow; k++) {
+                    const float *prev = mag_pow + (k-1) * stride;
+                    float *pow = mag_pow + k * stride;
+                    for (size_t i = start; i < stop; i++) {
+                        pow[i] = prev[i] * mag[i];
+                    }
+                }
+            });
+
+    m_workers.run(sizeIn, chunk_size,
+            [&](size_t start, size_t stop) {
+                process_chunk(*coefs, start, stop, out);
+            });
+
+    // Keep the end of this frame for the next one
+    memmove(in_re, in_re + sizeIn, history_len * sizeof(float));
+    memmove(in_im, in_im + sizeIn, history_len * sizeof(float));
+
+    return dataOut->getLength();
+}
+
+void MemoryPoly::set_parameter(const string& parameter, const string& value)
+{
+    if (parameter == "ncoefs") {
+        throw ParameterError("Parameter 'ncoefs' is read-only");
+    }
+    else if (parameter == "coeffile") {
+        try {
+            ifstream coefs_fstream(value);
+            load_coefficients(coefs_fstream);
+            m_coefs_file = value;
+        }
+        catch (const std::runtime_error &e) {
+            throw ParameterError(e.what());
+        }
+    }
+    else if (parameter == "coefs") {
+        try {
+            stringstream ss(value);
+            load_coefficients(ss);
+
+            // Write back to the file to ensure we will start up
+            // with the same settings next time
+            ofstream coefs_fstream(m_coefs_file);
+            coefs_fstream << value;
+        }
+        catch (const std::runtime_error &e) {
+            throw ParameterError(e.what());
+        }
+    }
+    else {
+        stringstream ss;
+        ss << "Parameter '" << parameter <<
+            "' is not exported by controllable " << get_rc_name();
+        throw ParameterError(ss.str());
+    }
+}
+
+const string MemoryPoly::get_parameter(const string& parameter) const
+{
+    stringstream ss;
+    if (parameter == "ncoefs") {
+        ss << m_coefs.load()->num_coefs();
+    }
+    else if (parameter == "coefs") {
+        ss << serialise_coefficients();
+    }
+    else if (parameter == "coeffile") {
+        ss << m_coefs_file;
+    }
+    else {
+        ss << "Parameter '" << parameter <<
+            "' is not exported by controllable " << get_rc_name();
+        throw ParameterError(ss.str());
+    }
+    return ss.str();
+}
+
+const json::map_t MemoryPoly::get_all_values() const
+{
+    json::map_t map;
+    map["ncoefs"].v = m_coefs.load()->num_coefs();
+    map["coefs"].v = serialise_coefficients();
+    map["coeffile"].v = m_coefs_file;
+    return map;
+}
+
@@ -0,0 +1,113 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifdef HAVE_CONFIG_H
+#   include <config.h>
+#endif
+
+#include "RemoteControl.h"
+#include "ModPlugin.h"
+#include "WorkerPool.h"
+#include "Rcu.h"
+
+#include <string>
+#include <vector>
+
+/* Digital predistortion using a generalised memory polynomial (GMP),
+ * which can correct PAs whose distortion depends on past samples, unlike
+ * MemlessPoly. The output is
+ *
+ *  y[n] = sum_k sum_m a[k][m] x[n-m] |x[n-m]|^k
+ *       + sum_k sum_m sum_l b[k][m][l] x[n-m] |x[n-m-l]|^k
+ *
+ * with k in [0, order), m in [0, memory depth), and l in [1, lag depth]
+ * for the terms with a lagging envelope, where k starts at 1.
+ *
+ * The last input samples are kept from one frame to the next, so that the
+ * memory terms are continuous over frame boundaries.
+ */
+class MemoryPoly : public PipelinedModCodec, public RemoteControllable
+{
+public:
+    MemoryPoly(std::string& coefs_file, unsigned int num_threads, bool pin_threads);
+    MemoryPoly(const MemoryPoly& other) = delete;
+    MemoryPoly& operator=(const MemoryPoly& other) = delete;
+    virtual ~MemoryPoly();
+
+    virtual const char* name() override { return "MemoryPoly"; }
+
+    /******* REMOTE CONTROL ********/
+    virtual void set_parameter(const std::string& parameter, const std::string& value) override;
+    virtual const std::string get_parameter(const std::string& parameter) const override;
+    virtual const json::map_t get_all_values() const override;
+
+    static constexpr size_t max_order = 9;
+    static constexpr size_t max_memory_depth = 16;
+    static constexpr size_t max_lag_depth = 8;
+
+private:
+    int internal_process(Buffer* const dataIn, Buffer* dataOut) override;
+    void load_coefficients(std::istream& coefData);
+    std::string serialise_coefficients() const;
+
+    // Number of samples processed at once by one thread
+    static constexpr size_t chunk_size = 4096;
+    WorkerPool m_workers;
+
+    struct coefs_t {
+        size_t order = 0;
+        size_t memory_depth = 0;
+        size_t lag_depth = 0;
+
+        // a[k][m] at index k * memory_depth + m
+        std::vector<complexf> aligned;
+
+        // b[k][m][l] at index ((k-1) * memory_depth + m) * lag_depth + (l-1)
+        std::vector<complexf> lagging;
+
+        size_t num_coefs() const { return aligned.size() + lagging.size(); }
+    };
+
+    Rcu<coefs_t> m_coefs;
+
+    void process_chunk(const coefs_t& coefs,
+            size_t start, size_t stop, complexf *out) const;
+
+    // Number of past samples needed by the largest supported model
+    static constexpr size_t history_len = max_memory_depth - 1 + max_lag_depth;
+
+    // Input samples split into real and imaginary parts, preceded by
+    // history_len samples of the previous frame.
+    std::vector<float> m_in_re;
+    std::vector<float> m_in_im;
+
+    // Powers 1 to order-1 of the input magnitude, one row of
+    // history_len + frame length entries per power.
+    std::vector<float> m_mag_pow;
+    size_t m_stride = 0;
+
+    std::string& m_coefs_file;
+};
+
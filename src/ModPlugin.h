@@ -33,6 +33,7 @@
 #include "Buffer.h"
 #include "ThreadsafeQueue.h"
 #include "TimestampDecoder.h"
+#include <deque>
 #include <vector>
 #include <thread>
 #include <atomic>
@@ -37,6 +37,7 @@
 
 #include <cstddef>
 #include <atomic>
+#include <deque>
 #include <fftw3.h>
 
 #ifdef HAVE_DEXTER
@@ -44,6 +45,10 @@
 #endif
 
 // Complex Float uses FFTW
+//
+// The IFFT size is given by spacing. When it is a multiple of the nominal
+// spacing of the transmission mode, the carriers are zero-padded and the
+// output is directly generated at a multiple of 2048000 sps.
 class OfdmGeneratorCF32 : public ModCodec, public RemoteControllable
 {
     public:
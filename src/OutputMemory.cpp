@@ -64,11 +64,13 @@ int OutputMemory::process(Buffer* dataIn)
     PDEBUG("OutputMemory::process(dataIn: %p)\n",
             dataIn);
 
-    *m_dataOut = *dataIn;
+    // Hand the frame over without copying it, the node that writes into
+    // dataIn overwrites it completely every frame.
+    m_dataOut->swap(*dataIn);
 
 #if OUTPUT_MEM_HISTOGRAM
-    const float* in = (const float*)dataIn->getData();
-    const size_t len = dataIn->getLength() / sizeof(float);
+    const float* in = (const float*)m_dataOut->getData();
+    const size_t len = m_dataOut->getLength() / sizeof(float);
 
     for (size_t i = 0; i < len; i++) {
         float absval = fabsf(in[i]);
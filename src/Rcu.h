@@ -0,0 +1,96 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+/* Read-copy-update holder for the settings of a DSP block, which the
+ * processing thread reads every frame, and the remote control changes
+ * from time to time.
+ *
+ * The processing thread takes a snapshot with load() once per frame, and
+ * keeps using it until the end of the frame. Writers build a new value,
+ * possibly after a slow file parse, and publish it with store() or
+ * update(). Writers are serialised among themselves, but only the
+ * exchange of the pointer is synchronised with the readers, a writer
+ * therefore never holds up the processing for longer than that.
+ *
+ * The reads are not lock-free: the atomic operations on shared_ptr
+ * take a short internal lock in libstdc++. This lock is only held
+ * while the pointer and its reference count are copied.
+ *
+ * A snapshot is immutable, and gets freed when the last reader releases
+ * it.
+ */
+template<typename T>
+class Rcu
+{
+public:
+    using snapshot_t = std::shared_ptr<const T>;
+
+    Rcu() : m_ptr(std::make_shared<const T>()) {}
+    explicit Rcu(T initial) : m_ptr(std::make_shared<const T>(std::move(initial))) {}
+
+    Rcu(const Rcu& other) = delete;
+    Rcu& operator=(const Rcu& other) = delete;
+
+    // Get the current value
+    snapshot_t load() const {
+        return std::atomic_load_explicit(&m_ptr, std::memory_order_acquire);
+    }
+
+    // Replace the current value
+    void store(T value) {
+        snapshot_t p = std::make_shared<const T>(std::move(value));
+        std::lock_guard<std::mutex> lock(m_update_mutex);
+        publish(std::move(p));
+    }
+
+    /* Publish a modified copy of the current value. func gets called with
+     * a reference to the copy. Concurrent calls to update() and store()
+     * are serialised, so that no modification gets lost. */
+    template<typename F>
+    void update(F&& func) {
+        std::lock_guard<std::mutex> lock(m_update_mutex);
+        T copy = *load();
+        func(copy);
+        publish(std::make_shared<const T>(std::move(copy)));
+    }
+
+private:
+    // Must be called with m_update_mutex held
+    void publish(snapshot_t p) {
+        std::atomic_store_explicit(&m_ptr, std::move(p), std::memory_order_release);
+    }
+
+    snapshot_t m_ptr;
+    std::mutex m_update_mutex;
+};
+
@@ -26,6 +26,7 @@
 
 #include "Resampler.h"
 #include "PcDebug.h"
+#include "Log.h"
 
 #include <string>
 #include <stdexcept>
@@ -33,6 +34,12 @@
 #include <sys/types.h>
 #include <string.h>
 #include <assert.h>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <immintrin.h>
+#    define RESAMPLER_AVX2_KERNELS 1
+#endif
 
 #define FFT_REAL(x) x[0]
 #define FFT_IMAG(x) x[1]
@@ -194,3 +201,222 @@ int Resampler::process(Buffer* const dataIn, Buffer* dataOut)
     return 1;
 }
 
+
+// Zeroth order modified Bessel function of the first kind, for the
+// Kaiser window
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < 1e-12 * sum) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/* Dot product of the interleaved complex input with the duplicated taps.
+ * len counts floats, and is a multiple of 8. */
+static inline complexf dot_product(
+        const float *__restrict taps, const float *__restrict in, size_t len)
+{
+    float re[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float im[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (size_t j = 0; j < len; j += 8) {
+        for (size_t k = 0; k < 4; k++) {
+            re[k] += in[j + 2*k] * taps[j + 2*k];
+            im[k] += in[j + 2*k + 1] * taps[j + 2*k + 1];
+        }
+    }
+    return complexf(re[0] + re[1] + re[2] + re[3],
+            im[0] + im[1] + im[2] + im[3]);
+}
+
+/* Compute num_out output samples, the first one being at position pos of
+ * the upsampled signal. Every output uses the branch of the taps for its
+ * phase, which is 2*taps_per_phase floats long. */
+static void resample(const float *taps, size_t taps_per_phase, size_t L, size_t M,
+        const float *buf, size_t pos, size_t num_out, complexf *out)
+{
+    const size_t len = 2 * taps_per_phase;
+    for (size_t i = 0; i < num_out; i++, pos += M) {
+        const size_t base = pos / L;
+        const size_t phase = pos % L;
+
+        // The window of input samples for this output starts at
+        // base - history in the frame, which is index base in the buffer
+        out[i] = dot_product(&taps[phase * len], buf + 2 * base, len);
+    }
+}
+
+#if defined(RESAMPLER_AVX2_KERNELS)
+/* These functions are compiled for AVX2 and FMA regardless of the compiler
+ * flags, and are only called if the CPU supports them. */
+__attribute__((target("avx2,fma")))
+static inline complexf dot_product_avx2(
+        const float *__restrict taps, const float *__restrict in, size_t len)
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t j = 0;
+    for (; j + 16 <= len; j += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(in + j),
+                _mm256_loadu_ps(taps + j), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(in + j + 8),
+                _mm256_loadu_ps(taps + j + 8), acc1);
+    }
+    for (; j < len; j += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(in + j),
+                _mm256_loadu_ps(taps + j), acc0);
+    }
+    acc0 = _mm256_add_ps(acc0, acc1);
+
+    // Lanes contain re, im, re, im, ... : sum the even and odd lanes
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc0),
+            _mm256_extractf128_ps(acc0, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    return complexf(_mm_cvtss_f32(s),
+            _mm_cvtss_f32(_mm_shuffle_ps(s, s, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+static void resample_avx2(const float *taps, size_t taps_per_phase, size_t L, size_t M,
+        const float *buf, size_t pos, size_t num_out, complexf *out)
+{
+    const size_t len = 2 * taps_per_phase;
+    for (size_t i = 0; i < num_out; i++, pos += M) {
+        const size_t base = pos / L;
+        const size_t phase = pos % L;
+        out[i] = dot_product_avx2(&taps[phase * len], buf + 2 * base, len);
+    }
+}
+#endif // defined(RESAMPLER_AVX2_KERNELS)
+
+PolyphaseResampler::PolyphaseResampler(
+        size_t inputRate, size_t outputRate,
+        size_t tapsPerPhase, float stopbandAttenuation_dB) :
+    ModCodec(),
+    myNextPosition(0)
+{
+    PDEBUG("PolyphaseResampler::PolyphaseResampler(%zu, %zu, %zu, %f) @ %p\n",
+            inputRate, outputRate, tapsPerPhase,
+            (double)stopbandAttenuation_dB, this);
+
+    // The upper bound keeps the prototype filter length tapsPerPhase * L
+    // reasonable
+    if (tapsPerPhase < 2 or tapsPerPhase > 1024) {
+        throw std::runtime_error("PolyphaseResampler: invalid number of taps");
+    }
+
+    size_t divisor = gcd(inputRate, outputRate);
+    L = outputRate / divisor;
+    M = inputRate / divisor;
+
+    myTapsPerPhase = ((tapsPerPhase + 3) / 4) * 4;
+
+    // Prototype filter runs at the upsampled rate L * inputRate. Its
+    // transition band is placed below the Nyquist frequency of the lower
+    // of the two rates, so that both images and aliases are attenuated
+    // by the requested stopband attenuation.
+    const size_t N = tapsPerPhase * L;
+    const double A = stopbandAttenuation_dB;
+
+    double beta = 0.0;
+    if (A > 50.0) {
+        beta = 0.1102 * (A - 8.7);
+    }
+    else if (A >= 21.0) {
+        beta = 0.5842 * pow(A - 21.0, 0.4) + 0.07886 * (A - 21.0);
+    }
+
+    // Transition width in cycles per sample at the upsampled rate, from
+    // the Kaiser design formula
+    const double transition = std::max(A - 7.95, 0.0) / (2.285 * 2.0 * M_PI * (N - 1));
+    const double stopband_edge = 0.5 / std::max(L, M);
+    const double cutoff = stopband_edge - transition / 2.0;
+
+    if (cutoff <= 0.0) {
+        throw std::runtime_error("PolyphaseResampler: not enough taps for the "
+                "requested stopband attenuation");
+    }
+
+    etiLog.level(info) << "PolyphaseResampler " << L << "/" << M <<
+        " using " << N << " taps, passband up to " <<
+        (cutoff - transition / 2.0) * inputRate * L << " Hz";
+
+    std::vector<double> h(N);
+    double sum = 0.0;
+    for (size_t n = 0; n < N; n++) {
+        const double t = n - (N - 1) / 2.0;
+        const double x = 2.0 * cutoff * t;
+        const double sinc = (t == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+        const double r = 2.0 * n / (N - 1) - 1.0;
+        const double w = bessel_i0(beta * sqrt(std::max(1.0 - r * r, 0.0))) /
+            bessel_i0(beta);
+        h[n] = sinc * w;
+        sum += h[n];
+    }
+
+    // Each branch gets unity DC gain when upsampling. When downsampling, the
+    // gain is L/M to stay compatible with the FFT-based Resampler, so that
+    // the digital_gain does not need to be changed when switching.
+    const double gain = (L >= M) ? L / sum : L / sum * L / M;
+
+    // Branch p contains h[p], h[p + L], h[p + 2L], ..., stored in reverse
+    // order and zero-padded in front to myTapsPerPhase taps.
+    myTaps.resize(L * 2 * myTapsPerPhase, 0.0f);
+    const size_t padding = myTapsPerPhase - tapsPerPhase;
+    for (size_t p = 0; p < L; p++) {
+        float *branch = &myTaps[p * 2 * myTapsPerPhase];
+        for (size_t k = 0; k < tapsPerPhase; k++) {
+            const size_t j = padding + (tapsPerPhase - 1 - k);
+            const float tap = h[p + k * L] * gain;
+            branch[2*j] = tap;
+            branch[2*j + 1] = tap;
+        }
+    }
+
+    myBuffer.resize(myTapsPerPhase - 1);
+
+    myResample = resample;
+#if defined(RESAMPLER_AVX2_KERNELS)
+    if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma")) {
+        myResample = resample_avx2;
+    }
+#endif
+}
+
+int PolyphaseResampler::process(Buffer* const dataIn, Buffer* dataOut)
+{
+    PDEBUG("PolyphaseResampler::process(dataIn: %p, dataOut: %p)\n",
+            dataIn, dataOut);
+
+    const complexf* in = reinterpret_cast<const complexf*>(dataIn->getData());
+    const size_t sizeIn = dataIn->getLength() / sizeof(complexf);
+    const size_t history = myTapsPerPhase - 1;
+
+    myBuffer.resize(history + sizeIn);
+    std::copy(in, in + sizeIn, myBuffer.begin() + history);
+
+    // Output sample at position pos needs the input samples up to
+    // index pos / L, which must be inside this frame.
+    const size_t sizeInUp = sizeIn * L;
+    const size_t sizeOut = (myNextPosition < sizeInUp) ?
+        (sizeInUp - myNextPosition + M - 1) / M : 0;
+    dataOut->setLength(sizeOut * sizeof(complexf));
+    complexf* out = reinterpret_cast<complexf*>(dataOut->getData());
+
+    const float *buf = reinterpret_cast<const float*>(myBuffer.data());
+    myResample(myTaps.data(), myTapsPerPhase, L, M,
+            buf, myNextPosition, sizeOut, out);
+
+    myNextPosition = myNextPosition + sizeOut * M - sizeInUp;
+
+    std::copy(myBuffer.end() - history, myBuffer.end(), myBuffer.begin());
+    myBuffer.resize(history);
+
+    return 1;
+}
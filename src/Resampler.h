@@ -33,6 +33,7 @@
 #include "ModPlugin.h"
 #include <sys/types.h>
 #include <fftw3.h>
+#include <vector>
 
 #define FFT_TYPE fftwf_complex
 #define FFT_PLAN fftwf_plan
@@ -68,3 +69,46 @@ protected:
 };
 
 
+/* Rational L/M resampler using a polyphase decomposition of a
+ * Kaiser-windowed sinc prototype filter. The number of taps per
+ * polyphase branch and the stopband attenuation are configurable.
+ * Contrary to the FFT-based Resampler, the filter state is carried
+ * from one frame to the next, there are no block edges.
+ */
+class PolyphaseResampler : public ModCodec
+{
+public:
+    PolyphaseResampler(size_t inputRate, size_t outputRate,
+            size_t tapsPerPhase, float stopbandAttenuation_dB);
+    PolyphaseResampler(const PolyphaseResampler&) = delete;
+    PolyphaseResampler& operator=(const PolyphaseResampler&) = delete;
+
+    int process(Buffer* const dataIn, Buffer* dataOut) override;
+    const char* name() override { return "PolyphaseResampler"; }
+
+protected:
+    size_t L;
+    size_t M;
+
+    // Number of taps per phase, rounded up to a multiple of 4
+    size_t myTapsPerPhase;
+
+    // The taps of each polyphase branch, in reverse order, and
+    // every tap duplicated so that they can be directly multiplied
+    // with the interleaved real and imaginary parts of the input.
+    // L branches of 2*myTapsPerPhase floats.
+    std::vector<float> myTaps;
+
+    // Position of the next output sample, at the upsampled rate, relative
+    // to the first sample of the next input frame.
+    size_t myNextPosition;
+
+    // Last myTapsPerPhase-1 input samples, followed by the input frame
+    std::vector<complexf> myBuffer;
+
+    // Scalar or AVX2 filter loop, selected according to the CPU
+    using resample_func_t = void (*)(const float *taps, size_t taps_per_phase,
+            size_t L, size_t M, const float *buf, size_t pos,
+            size_t num_out, complexf *out);
+    resample_func_t myResample;
+};
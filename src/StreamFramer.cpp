@@ -0,0 +1,169 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "StreamFramer.h"
+#include "Log.h"
+#include "edi/buffer_unpack.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+// The tag packet of an AF packet carrying ETI is a few kB at most, a larger
+// length field means we are not aligned on an AF packet.
+static constexpr size_t MAX_AF_TAGLENGTH = 65536;
+
+size_t StreamFramer::edi_framing(const uint8_t *data, size_t len)
+{
+    if (len < 2) {
+        return 0;
+    }
+
+    if (data[0] == 'A' and data[1] == 'F') {
+        // SYNC, LEN, SEQ, AR, PT, then the payload and a CRC
+        const size_t header_len = 10;
+        const size_t crc_len = 2;
+        if (len < header_len) {
+            return 0;
+        }
+
+        const uint32_t taglength = EdiDecoder::read_32b(data + 2);
+        if (taglength > MAX_AF_TAGLENGTH) {
+            return NO_SYNC;
+        }
+
+        const size_t af_len = header_len + taglength + crc_len;
+        return len < af_len ? 0 : af_len;
+    }
+    else if (data[0] == 'P' and data[1] == 'F') {
+        // Psync, Pseq, Findex, Fcount, FEC, Addr and Plen, followed by the
+        // optional RS and transport headers, and the header CRC
+        const size_t header_len = 12;
+        if (len < header_len) {
+            return 0;
+        }
+
+        const bool fec = data[10] & 0x80;
+        const bool addr = data[10] & 0x40;
+        const size_t plen = EdiDecoder::read_16b(data + 10) & 0x3FFF;
+
+        const size_t fragment_len = header_len +
+            (fec ? 2 : 0) + (addr ? 4 : 0) + 2 + plen;
+        return len < fragment_len ? 0 : fragment_len;
+    }
+
+    return NO_SYNC;
+}
+
+size_t StreamFramer::eti_framing(const uint8_t *data, size_t len)
+{
+    const size_t frame_len = 6144;
+
+    // ERR, followed by FSYNC which alternates between two values
+    if (len < 4) {
+        return 0;
+    }
+
+    const uint32_t fsync = (data[1] << 16) | (data[2] << 8) | data[3];
+    if (fsync != 0x073AB6 and fsync != 0xF8C549) {
+        return NO_SYNC;
+    }
+
+    return len < frame_len ? 0 : frame_len;
+}
+
+StreamFramer::StreamFramer(const string& name, const framing_func_t& framing,
+        size_t read_size) :
+    m_name(name),
+    m_framing(framing),
+    m_read_size(read_size),
+    m_buf(2 * read_size)
+{ }
+
+ssize_t StreamFramer::fill(Socket::TCPClient& client, int timeout_ms)
+{
+    if (m_start == m_end) {
+        m_start = 0;
+        m_end = 0;
+    }
+    else if (m_buf.size() - m_end < m_read_size) {
+        // Move the incomplete packet to the beginning
+        if (m_start > 0) {
+            memmove(m_buf.data(), m_buf.data() + m_start, m_end - m_start);
+            m_end -= m_start;
+            m_start = 0;
+        }
+
+        // Only happens for packets larger than read_size
+        if (m_buf.size() - m_end < m_read_size) {
+            m_buf.resize(m_end + m_read_size);
+        }
+    }
+
+    const ssize_t ret = client.recv(m_buf.data() + m_end, m_read_size, 0, timeout_ms);
+    if (ret > (ssize_t)m_read_size) {
+        throw logic_error("StreamFramer: invalid recv() return value");
+    }
+    else if (ret > 0) {
+        m_end += ret;
+    }
+    return ret;
+}
+
+bool StreamFramer::next_packet(const uint8_t*& data, size_t& len)
+{
+    while (m_start < m_end) {
+        const size_t packet_len = m_framing(m_buf.data() + m_start, m_end - m_start);
+
+        if (packet_len == 0) {
+            return false;
+        }
+        else if (packet_len == NO_SYNC) {
+            m_start++;
+            m_num_skipped++;
+            continue;
+        }
+
+        if (m_num_skipped > 0) {
+            etiLog.level(warn) << m_name << ": skipped " << m_num_skipped <<
+                " bytes to find the next packet";
+            m_num_skipped = 0;
+        }
+
+        data = m_buf.data() + m_start;
+        len = packet_len;
+        m_start += packet_len;
+        return true;
+    }
+
+    return false;
+}
+
+void StreamFramer::reset()
+{
+    m_start = 0;
+    m_end = 0;
+    m_num_skipped = 0;
+}
+
@@ -0,0 +1,94 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include "Socket.h"
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+/* Splits the byte stream of a TCP input into packets.
+ *
+ * The data is read from the socket in large blocks into a buffer, and the
+ * packets are handed out in place, as pointers into that buffer. Consumed
+ * data is only discarded when the free space at the end of the buffer runs
+ * out, by moving the incomplete packet that remains to the beginning.
+ *
+ * Where a packet starts and how long it is gets decided by a framing
+ * function, there is one for EDI and one for ETI.
+ */
+class StreamFramer
+{
+public:
+    /* Look at the data at the current position, and return the length of
+     * the packet that starts there, 0 if more data is needed to tell, or
+     * NO_SYNC if no packet starts at the first byte. */
+    using framing_func_t = std::function<size_t(const uint8_t *data, size_t len)>;
+    static constexpr size_t NO_SYNC = std::numeric_limits<size_t>::max();
+
+    // EDI AF packets and PFT fragments, ETSI TS 102 821
+    static size_t edi_framing(const uint8_t *data, size_t len);
+
+    // ETI(NI) frames of 6144 bytes, ETSI EN 300 799
+    static size_t eti_framing(const uint8_t *data, size_t len);
+
+    /* name is used in the log messages. read_size is the largest block
+     * read from the socket at once. */
+    StreamFramer(const std::string& name, const framing_func_t& framing,
+            size_t read_size = 65536);
+
+    /* Read what is available from the socket, waiting at most
+     * timeout_ms. Returns the number of bytes read, 0 on timeout or
+     * reconnection, -1 on interruption. Throws a runtime_error on error. */
+    ssize_t fill(Socket::TCPClient& client, int timeout_ms);
+
+    /* Get the next complete packet. Returns false if there is none. The
+     * packet data stays valid until the next call to fill() or reset(). */
+    bool next_packet(const uint8_t*& data, size_t& len);
+
+    // Drop all buffered data
+    void reset(void);
+
+private:
+    std::string m_name;
+    framing_func_t m_framing;
+    size_t m_read_size;
+
+    // Buffered data is in [m_start, m_end)
+    std::vector<uint8_t> m_buf;
+    size_t m_start = 0;
+    size_t m_end = 0;
+
+    // Number of bytes skipped since the stream lost sync
+    size_t m_num_skipped = 0;
+};
+
@@ -1051,6 +1051,11 @@ void SubchannelSource::loadSubchannelData(Buffer&& data)
     d_buffer = std::move(data);
 }
 
+void SubchannelSource::swapSubchannelData(Buffer& data)
+{
+    d_buffer.swap(data);
+}
+
 int SubchannelSource::process(Buffer* outputData)
 {
     PDEBUG("SubchannelSource::process(outputData: %p, outputSize: %zu)\n",
@@ -60,6 +60,10 @@ public:
     const std::vector<PuncturingRule>& get_rules() const;
 
     void loadSubchannelData(Buffer&& data);
+
+    /* Exchange the subchannel data with the content of data, which
+     * receives the buffer of the previous frame. */
+    void swapSubchannelData(Buffer& data);
     int process(Buffer* outputData);
     const char* name() { return "SubchannelSource"; }
 
@@ -151,8 +151,10 @@ TII::TII(unsigned int dabmode, tii_config_t& tii_config, bool fixedPoint) :
         throw TIIError("TII::TII comb not valid!");
     }
 
-    m_Acp.clear();
-    m_Acp.resize(m_carriers);
+    m_state.update([&](state_t& s) {
+                s.enable = m_conf.enable;
+                s.old_variant = m_conf.old_variant;
+            });
     prepare_pattern();
 }
 
@@ -224,16 +226,16 @@ int TII::process(Buffer* dataIn, Buffer* dataOut)
     dataOut->setLength(m_carriers * sizeof_samples);
     memset(dataOut->getData(), 0, dataOut->getLength());
 
-    if (m_conf.enable and m_insert) {
-        std::lock_guard<std::mutex> lock(m_enabled_carriers_mutex);
+    const auto state = m_state.load();
+    if (state->enable and m_insert) {
         if (m_fixedPoint) {
             do_process<complexfix>(
-                    m_carriers, m_conf.old_variant, m_Acp,
+                    m_carriers, state->old_variant, state->Acp,
                     dataIn, dataOut);
         }
         else {
             do_process<complexf>(
-                    m_carriers, m_conf.old_variant, m_Acp,
+                    m_carriers, state->old_variant, state->Acp,
                     dataIn, dataOut);
         }
     }
@@ -244,7 +246,7 @@ int TII::process(Buffer* dataIn, Buffer* dataOut)
     return 1;
 }
 
-void TII::enable_carrier(int k)
+void TII::enable_carrier(std::vector<bool>& Acp, int k) const
 {
     /* The OFDMGenerator shifts all positive frequencies by one,
      * i.e. index 0 is not the DC component, it's the first positive
@@ -255,23 +257,18 @@ void TII::enable_carrier(int k)
      */
     int ix = m_carriers/2 + k + (k>=0 ? -1 : 0);
 
-    if (ix < 0 or ix+1 >= (ssize_t)m_Acp.size()) {
+    if (ix < 0 or ix+1 >= (ssize_t)Acp.size()) {
         throw TIIError("TII::enable_carrier invalid k!");
     }
 
-    m_Acp[ix] = true;
+    Acp[ix] = true;
 }
 
 void TII::prepare_pattern()
 {
     int comb = m_conf.comb; // Convert from unsigned to signed
 
-    std::lock_guard<std::mutex> lock(m_enabled_carriers_mutex);
-
-    // Clear previous pattern
-    for (size_t i = 0; i < m_Acp.size(); i++) {
-        m_Acp[i] = false;
-    }
+    std::vector<bool> Acp(m_carriers, false);
 
     // This could be written more efficiently, but since it is
     // not performance-critial, it makes sense to write it
@@ -282,7 +279,7 @@ void TII::prepare_pattern()
             for (int b = 0; b < 8; b++) {
                 if (    k == -768 + 2 * comb + 48 * b and
                         pattern_tm1_2_4[m_conf.pattern][b]) {
-                    enable_carrier(k);
+                    enable_carrier(Acp, k);
                 }
             }
         }
@@ -291,7 +288,7 @@ void TII::prepare_pattern()
             for (int b = 0; b < 8; b++) {
                 if (    k == -384 + 2 * comb + 48 * b and
                         pattern_tm1_2_4[m_conf.pattern][b]) {
-                    enable_carrier(k);
+                    enable_carrier(Acp, k);
                 }
             }
         }
@@ -300,7 +297,7 @@ void TII::prepare_pattern()
             for (int b = 0; b < 8; b++) {
                 if (    k == 1 + 2 * comb + 48 * b and
                         pattern_tm1_2_4[m_conf.pattern][b]) {
-                    enable_carrier(k);
+                    enable_carrier(Acp, k);
                 }
             }
         }
@@ -309,7 +306,7 @@ void TII::prepare_pattern()
             for (int b = 0; b < 8; b++) {
                 if (    k == 385 + 2 * comb + 48 * b and
                         pattern_tm1_2_4[m_conf.pattern][b]) {
-                    enable_carrier(k);
+                    enable_carrier(Acp, k);
                 }
             }
         }
@@ -319,14 +316,14 @@ void TII::prepare_pattern()
             for (int b = 0; b < 4; b++) {
                 if (    k == -192 + 2 * comb + 48 * b and
                         pattern_tm1_2_4[m_conf.pattern][b]) {
-                    enable_carrier(k);
+                    enable_carrier(Acp, k);
                 }
             }
 
             for (int b = 4; b < 8; b++) {
                 if (    k == -191 + 2 * comb + 48 * b and
                         pattern_tm1_2_4[m_conf.pattern][b]) {
-                    enable_carrier(k);
+                    enable_carrier(Acp, k);
                 }
             }
         }
@@ -334,6 +331,8 @@ void TII::prepare_pattern()
     else {
         throw TIIError("TII::TII DAB mode not valid!");
     }
+
+    m_state.update([&](state_t& s) { s.Acp = std::move(Acp); });
 }
 
 void TII::set_parameter(const std::string& parameter, const std::string& value)
@@ -344,6 +343,7 @@ void TII::set_parameter(const std::string& parameter, const std::string& value)
 
     if (parameter == "enable") {
         ss >> m_conf.enable;
+        m_state.update([&](state_t& s) { s.enable = m_conf.enable; });
     }
     else if (parameter == "pattern") {
         int new_pattern;
@@ -366,6 +366,7 @@ void TII::set_parameter(const std::string& parameter, const std::string& value)
     }
     else if (parameter == "old_variant") {
         ss >> m_conf.old_variant;
+        m_state.update([&](state_t& s) { s.old_variant = m_conf.old_variant; });
     }
     else {
         stringstream ss_err;
@@ -34,6 +34,7 @@
 
 #include "ModPlugin.h"
 #include "RemoteControl.h"
+#include "Rcu.h"
 
 #include <cstddef>
 #include <vector>
@@ -91,12 +92,11 @@ class TII : public ModCodec, public RemoteControllable
         virtual const json::map_t get_all_values() const override;
 
     protected:
-        // Fill m_Acp with the correct carriers for the pattern/comb
+        // Publish the correct carriers for the pattern/comb
         // combination
         void prepare_pattern(void);
 
-        // prerequisites: calling thread must hold m_Acp mutex
-        void enable_carrier(int k);
+        void enable_carrier(std::vector<bool>& Acp, int k) const;
 
         // Configuration settings
         unsigned int m_dabmode;
@@ -113,13 +113,17 @@ class TII : public ModCodec, public RemoteControllable
 
         std::string m_name;
 
-        // m_Acp is read by modulator thread, and written
+        // The settings used by the modulator thread, written
         // to by RC thread.
-        mutable std::mutex m_enabled_carriers_mutex;
-
-        // m_Acp corresponds to the A_{c,p}(k) function from the spec, except
-        // that the leftmost carrier is at index 0, and not at -m_carriers/2 like
-        // in the spec.
-        std::vector<bool> m_Acp;
+        struct state_t {
+            bool enable = false;
+            bool old_variant = false;
+
+            // Acp corresponds to the A_{c,p}(k) function from the spec, except
+            // that the leftmost carrier is at index 0, and not at -m_carriers/2 like
+            // in the spec.
+            std::vector<bool> Acp;
+        };
+        Rcu<state_t> m_state;
 };
 
@@ -98,6 +98,7 @@ void printUsage(const char* progName)
             " [-m dabMode]"
             " [-r samplingRate]"
             " [-l]"
+            " [-I]"
             " [-h]"
             "\n", progName);
     fprintf(out, "Where:\n");
@@ -123,6 +124,7 @@ void printUsage(const char* progName)
     fprintf(out, "-m mode:       Set DAB mode: (0: auto, 1-4: force).\n");
     fprintf(out, "-r rate:       Set output sampling rate (default: 2048000).\n\n");
     fprintf(out, "-l:            Loop file when reach end of file.\n");
+    fprintf(out, "-I:            Build the frame index of the ETI input file, used to seek in it, and exit.\n");
     fprintf(out, "-h:            Print this help.\n");
 }
 
@@ -191,7 +193,8 @@ void printModSettings(const mod_settings_t& mod_settings)
         ss << " SoapySDR\n"
             "  Device: " << mod_settings.sdr_device_config.device << "\n" <<
             "  master_clock_rate: " <<
-                mod_settings.sdr_device_config.masterClockRate << "\n";
+                mod_settings.sdr_device_config.masterClockRate << "\n" <<
+            "  Format: " << mod_settings.sdr_device_config.sampleFormat << "\n";
     }
 #endif
 #if defined(HAVE_DEXTER)
@@ -214,10 +217,16 @@ void printModSettings(const mod_settings_t& mod_settings)
             "  refclk: " << mod_settings.sdr_device_config.refclk_src << "\n";
     }
 #endif
+    else if (mod_settings.useSimulatedOutput) {
+        ss << " Simulated\n" <<
+            "  FIFO: " << mod_settings.simulated_config.fifo_ms << " ms\n" <<
+            "  IQ file: " << mod_settings.simulated_config.iq_filename << "\n";
+    }
     else if (mod_settings.useZeroMQOutput) {
         ss << " ZeroMQ\n" <<
             "  Listening on: " << mod_settings.outputName << "\n" <<
-            "  Socket type : " << mod_settings.zmqOutputSocketType << "\n";
+            "  Socket type : " << mod_settings.zmqOutputSocketType << "\n" <<
+            "  Format      : " << mod_settings.zmqOutputFormat << "\n";
     }
 
     ss << "  Sampling rate: ";
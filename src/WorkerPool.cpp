@@ -0,0 +1,214 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WorkerPool.h"
+#include "Utils.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <climits>
+#include <pthread.h>
+
+#if defined(__linux__)
+#  include <linux/futex.h>
+#  include <sched.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+// How many times to poll a counter before going to sleep on the futex.
+static constexpr int SPIN_ITERATIONS = 4000;
+
+// Pinned workers of all pools get distributed over the CPUs in turn.
+static std::atomic<unsigned> next_cpu_to_pin = ATOMIC_VAR_INIT(0);
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+static void futex_wait(std::atomic<uint32_t>& word, uint32_t expected)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+            FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)expected;
+    std::this_thread::yield();
+#endif
+}
+
+static void futex_wake_all(std::atomic<uint32_t>& word)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+            FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+// Block until word no longer contains value
+static void wait_while_equal(std::atomic<uint32_t>& word, uint32_t value)
+{
+    for (int i = 0; i < SPIN_ITERATIONS; i++) {
+        if (word.load(std::memory_order_acquire) != value) {
+            return;
+        }
+        cpu_relax();
+    }
+
+    while (word.load(std::memory_order_acquire) == value) {
+        futex_wait(word, value);
+    }
+}
+
+WorkerPool::WorkerPool(const std::string& name, unsigned num_threads, bool pin_threads) :
+    m_name(name),
+    m_pin_threads(pin_threads)
+{
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+    }
+
+    // The thread calling run() also processes chunks
+    for (size_t i = 1; i < num_threads; i++) {
+        m_workers.emplace_back(&WorkerPool::worker_thread, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    m_stop.store(true);
+    m_generation.fetch_add(1, std::memory_order_release);
+    futex_wake_all(m_generation);
+
+    for (auto& t : m_workers) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+void WorkerPool::run(size_t size, size_t chunk_size, const work_func_t& func)
+{
+    if (size == 0) {
+        return;
+    }
+
+    m_func = &func;
+    m_size = size;
+    m_chunk_size = (chunk_size == 0) ? size : chunk_size;
+    m_next_chunk.store(0, std::memory_order_relaxed);
+
+    if (not m_workers.empty()) {
+        m_active.store(m_workers.size(), std::memory_order_relaxed);
+        m_generation.fetch_add(1, std::memory_order_release);
+        futex_wake_all(m_generation);
+    }
+
+    process_chunks();
+
+    // Completion barrier
+    uint32_t active = 0;
+    while ((active = m_active.load(std::memory_order_acquire)) != 0) {
+        wait_while_equal(m_active, active);
+    }
+
+    m_func = nullptr;
+}
+
+void WorkerPool::process_chunks()
+{
+    const size_t num_chunks = (m_size + m_chunk_size - 1) / m_chunk_size;
+
+    while (true) {
+        const size_t chunk = m_next_chunk.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= num_chunks) {
+            break;
+        }
+
+        const size_t start = chunk * m_chunk_size;
+        (*m_func)(start, std::min(start + m_chunk_size, m_size));
+    }
+}
+
+void WorkerPool::worker_thread(size_t worker_ix)
+{
+    set_realtime_prio(1);
+    set_thread_name(m_name.c_str());
+
+#if defined(__linux__)
+    if (m_pin_threads) {
+        // Only use the CPUs we are allowed to run on, which can be a subset
+        // of the machine when started with taskset or in a cgroup.
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        std::vector<int> cpus;
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &allowed)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+
+        if (cpus.empty()) {
+            etiLog.level(warn) << m_name << " worker " << worker_ix <<
+                ": could not get the allowed CPUs, not pinning";
+        }
+        else {
+            const int cpu = cpus[next_cpu_to_pin.fetch_add(1) % cpus.size()];
+
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(cpu, &cpuset);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0) {
+                etiLog.level(warn) << m_name << " worker " << worker_ix <<
+                    ": could not pin to CPU " << cpu;
+            }
+        }
+    }
+#endif
+
+    uint32_t generation = 0;
+    while (true) {
+        wait_while_equal(m_generation, generation);
+        generation = m_generation.load(std::memory_order_acquire);
+
+        if (m_stop.load()) {
+            break;
+        }
+
+        process_chunks();
+
+        if (m_active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            futex_wake_all(m_active);
+        }
+    }
+}
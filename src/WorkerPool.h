@@ -0,0 +1,100 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* A set of persistent worker threads that share the processing of one
+ * frame, used by the DSP blocks that split their work over several cores.
+ *
+ * The range of samples to process is divided into chunks of a fixed size.
+ * The workers and the calling thread claim chunks from an atomic counter
+ * until none are left, which balances the load without any locking.
+ *
+ * Both the start of a job and its completion are signalled through atomic
+ * counters. Waiting threads first spin for a short while, and then sleep
+ * on a futex, so that no mutex nor condition variable is involved when
+ * the frames follow each other quickly.
+ */
+class WorkerPool
+{
+public:
+    // The work function gets called with the bounds [start, stop)
+    // of one chunk.
+    using work_func_t = std::function<void(size_t start, size_t stop)>;
+
+    /* Create a pool where num_threads threads take part in processing,
+     * including the thread calling run(). If num_threads is 0, use one
+     * thread per core. If pin_threads is set, every worker gets bound
+     * to one CPU. */
+    WorkerPool(const std::string& name, unsigned num_threads, bool pin_threads = false);
+    WorkerPool(const WorkerPool& other) = delete;
+    WorkerPool& operator=(const WorkerPool& other) = delete;
+    ~WorkerPool();
+
+    // Number of threads that process chunks, including the caller of run()
+    size_t num_threads() const { return m_workers.size() + 1; }
+
+    /* Process the range [0, size) in chunks of chunk_size elements, and
+     * return once all chunks have been processed. The last chunk might
+     * be shorter. func must not throw. */
+    void run(size_t size, size_t chunk_size, const work_func_t& func);
+
+private:
+    void worker_thread(size_t worker_ix);
+    void process_chunks();
+
+    std::string m_name;
+    bool m_pin_threads;
+
+    // Description of the current job, written by run() before the
+    // generation counter is incremented.
+    const work_func_t *m_func = nullptr;
+    size_t m_size = 0;
+    size_t m_chunk_size = 0;
+
+    // Put the counters on separate cache lines, they are all written
+    // to by several threads.
+    alignas(64) std::atomic<size_t> m_next_chunk = ATOMIC_VAR_INIT(0);
+
+    // Incremented for every job, the workers wait on it
+    alignas(64) std::atomic<uint32_t> m_generation = ATOMIC_VAR_INIT(0);
+
+    // Number of workers that have not yet finished the current job,
+    // run() waits on it
+    alignas(64) std::atomic<uint32_t> m_active = ATOMIC_VAR_INIT(0);
+
+    std::atomic<bool> m_stop = ATOMIC_VAR_INIT(false);
+
+    std::vector<std::thread> m_workers;
+};
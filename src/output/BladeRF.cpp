@@ -302,9 +302,9 @@ std::optional<double> BladeRF::get_temperature(void) const
 
 void BladeRF::transmit_frame(struct FrameData&& frame) // SC16 frames
 {
-    const size_t num_samples = frame.buf.size() / (2*sizeof(int16_t));
+    const size_t num_samples = frame.buf->getLength() / (2*sizeof(int16_t));
 
-    const int status = bladerf_sync_tx(m_device, frame.buf.data(), num_samples, NULL, 0);
+    const int status = bladerf_sync_tx(m_device, frame.buf->getData(), num_samples, NULL, 0);
     if (status < 0) {
         etiLog.level(error) << "Error transmitting samples with BladeRF: %s " << bladerf_strerror(status);
         throw runtime_error("Cannot transmit TX samples");
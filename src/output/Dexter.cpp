@@ -535,9 +535,9 @@ std::optional<double> Dexter::get_temperature(void) const
 void Dexter::transmit_frame(struct FrameData&& frame)
 {
     constexpr size_t frame_len_bytes = TRANSMISSION_FRAME_LEN_SAMPS * sizeof(int16_t);
-    if (frame.buf.size() != frame_len_bytes) {
+    if (frame.buf->getLength() != frame_len_bytes) {
         etiLog.level(debug) << "Dexter::transmit_frame Expected " <<
-            frame_len_bytes << " got " << frame.buf.size();
+            frame_len_bytes << " got " << frame.buf->getLength();
         throw std::runtime_error("Dexter: invalid buffer size");
     }
 
@@ -600,15 +600,14 @@ void Dexter::transmit_frame(struct FrameData&& frame)
     }
 
     // DabMod::launch_modulator ensures we get int16_t IQ here
-    //const size_t num_samples = frame.buf.size() / (2*sizeof(int16_t));
-    //const int16_t *buf = reinterpret_cast<const int16_t*>(frame.buf.data());
+    const uint8_t *buf = reinterpret_cast<const uint8_t*>(frame.buf->getData());
 
     if (m_channel_is_up) {
         for (size_t i = 0; i < IIO_BUFFERS; i++) {
             constexpr size_t buflen_samps = TRANSMISSION_FRAME_LEN_SAMPS / IIO_BUFFERS;
             constexpr size_t buflen = buflen_samps * sizeof(int16_t);
 
-            memcpy(iio_buffer_start(m_buffer), frame.buf.data() + (i * buflen), buflen);
+            memcpy(iio_buffer_start(m_buffer), buf + (i * buflen), buflen);
             ssize_t pushed = iio_buffer_push(m_buffer);
             if (pushed < 0) {
                 etiLog.level(error) << "Dexter: failed to push buffer " << get_iio_error(pushed) <<
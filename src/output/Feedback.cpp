@@ -82,8 +82,14 @@ DPDFeedbackServer::~DPDFeedbackServer()
     }
 }
 
+bool DPDFeedbackServer::tx_frame_requested() const
+{
+    unique_lock<mutex> lock(burstRequest.mutex);
+    return burstRequest.state == BurstRequestState::SaveTransmitFrame;
+}
+
 void DPDFeedbackServer::set_tx_frame(
-        const std::vector<uint8_t> &buf,
+        const Buffer::sptr& buf,
         const frame_timestamp &buf_ts)
 {
     if (not m_running) {
@@ -92,24 +98,23 @@ void DPDFeedbackServer::set_tx_frame(
 
     unique_lock<mutex> lock(burstRequest.mutex);
 
-    if (buf.size() % sizeof(complexf) != 0) {
+    if (buf->getLength() % sizeof(complexf) != 0) {
         throw logic_error("Buffer for tx frame has incorrect size");
     }
 
     if (burstRequest.state == BurstRequestState::SaveTransmitFrame) {
         const size_t n = std::min(
-                burstRequest.num_samples * sizeof(complexf), buf.size());
+                burstRequest.num_samples * sizeof(complexf), buf->getLength());
 
         burstRequest.num_samples = n / sizeof(complexf);
 
-        burstRequest.tx_samples.clear();
-        burstRequest.tx_samples.resize(n);
         // A frame will always begin with the NULL symbol, which contains
         // no power. Instead of taking n samples at the beginning of the
         // frame, we take them at the end and adapt the timestamp accordingly.
-
-        const size_t start_ix = buf.size() - n;
-        copy(buf.begin() + start_ix, buf.end(), burstRequest.tx_samples.begin());
+        // The samples are not copied, we keep a reference to the frame.
+        const size_t start_ix = buf->getLength() - n;
+        burstRequest.tx_frame = buf;
+        burstRequest.tx_offset = start_ix;
 
         frame_timestamp ts = buf_ts;
         ts += (1.0 * start_ix) / (sizeof(complexf) * m_sampleRate);
@@ -257,9 +262,12 @@ void DPDFeedbackServer::ServeFeedback()
         burstRequest.state = BurstRequestState::None;
         lock.unlock();
 
+        const size_t tx_frame_len = burstRequest.tx_frame ?
+            burstRequest.tx_frame->getLength() - burstRequest.tx_offset : 0;
+
         burstRequest.num_samples = std::min(burstRequest.num_samples,
                 std::min(
-                    burstRequest.tx_samples.size() / sizeof(complexf),
+                    tx_frame_len / sizeof(complexf),
                     burstRequest.rx_samples.size() / sizeof(complexf)));
 
         uint32_t num_samples_32 = burstRequest.num_samples;
@@ -287,18 +295,22 @@ void DPDFeedbackServer::ServeFeedback()
 
         const size_t frame_bytes = burstRequest.num_samples * sizeof(complexf);
 
-        if (burstRequest.tx_samples.size() < frame_bytes) {
+        if (tx_frame_len < frame_bytes) {
             throw logic_error("DPD Feedback burstRequest invalid: not enough TX samples");
         }
 
         if (client_sock.sendall(
-                    &burstRequest.tx_samples[0],
+                    reinterpret_cast<const uint8_t*>(burstRequest.tx_frame->getData()) +
+                        burstRequest.tx_offset,
                     frame_bytes) < 0) {
             etiLog.level(info) <<
                 "DPD Feedback Server Client send tx_frame failed";
             break;
         }
 
+        // Let the frame buffer return to its pool
+        burstRequest.tx_frame.reset();
+
         if (client_sock.sendall(
                     &burstRequest.rx_second,
                     sizeof(burstRequest.rx_second)) < 0) {
@@ -71,9 +71,10 @@ struct FeedbackBurstRequest {
     uint32_t tx_second = 0;
     uint32_t tx_pps = 0; // in units of 1/16384000s
 
-    // Samples contain complexf, but since our internal representation is uint8_t
-    // we keep it like that
-    std::vector<uint8_t> tx_samples;
+    // Reference to the transmitted frame, which contains complexf samples.
+    // The TX samples start at byte tx_offset.
+    std::shared_ptr<const Buffer> tx_frame;
+    size_t tx_offset = 0;
 
     // The timestamp of the first sample of the RX buffers
     uint32_t rx_second = 0;
@@ -93,7 +94,12 @@ class DPDFeedbackServer {
         DPDFeedbackServer& operator=(const DPDFeedbackServer& other) = delete;
         ~DPDFeedbackServer();
 
-        void set_tx_frame(const std::vector<uint8_t> &buf,
+        // True if a TX frame is awaited by set_tx_frame()
+        bool tx_frame_requested() const;
+
+        // Keeps a reference to the buffer only if a TX frame is awaited,
+        // the buffer must not be modified afterwards.
+        void set_tx_frame(const Buffer::sptr& buf,
                 const frame_timestamp& ts);
 
     private:
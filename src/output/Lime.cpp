@@ -388,19 +388,28 @@ void Lime::transmit_frame(struct FrameData&& frame)
     if (not m_device)
         throw runtime_error("Lime device not set up");
 
-    // The frame buffer contains bytes representing FC32 samples
-    const complexf *buf = reinterpret_cast<const complexf *>(frame.buf.data());
-    const size_t numSamples = frame.buf.size() / sizeof(complexf);
-
-    m_i16samples.resize(numSamples * 2);
-    short *buffi16 = &m_i16samples[0];
-    
-    conv_s16_from_float(numSamples * 2, (const float *)buf, buffi16);
-    if ((frame.buf.size() % sizeof(complexf)) != 0)
+    // The frame buffer contains bytes representing FC32 samples,
+    // or S16 samples for the compact queue
+    const size_t numSamples = frame.buf->getLength() / frame.sampleSize;
+    if ((frame.buf->getLength() % frame.sampleSize) != 0)
     {
         throw runtime_error("Lime: invalid buffer size");
     }
 
+    short *buffi16 = nullptr;
+    if (m_conf.compactQueue)
+    {
+        buffi16 = reinterpret_cast<short *>(frame.buf->getData());
+    }
+    else
+    {
+        const complexf *buf = reinterpret_cast<const complexf *>(frame.buf->getData());
+        m_i16samples.resize(numSamples * 2);
+        buffi16 = &m_i16samples[0];
+
+        conv_s16_from_float(numSamples * 2, (const float *)buf, buffi16);
+    }
+
     lms_stream_status_t LimeStatus;
     LMS_GetStreamStatus(&m_tx_stream, &LimeStatus);
     overflows += LimeStatus.overrun;
@@ -28,7 +28,9 @@
 #include "output/UHD.h"
 #include "output/Lime.h"
 #include "output/Dexter.h"
+#include "output/Simulated.h"
 
+#include "FormatConverter.h"
 #include "PcDebug.h"
 #include "Log.h"
 #include "RemoteControl.h"
@@ -55,6 +57,10 @@ namespace Output {
 static constexpr size_t FRAMES_MAX_SIZE_UNSYNC = 8;
 static constexpr size_t FRAMES_MAX_SIZE_SYNC = 250;
 
+// Number of released frame buffers that are kept for reuse. In the steady
+// state, the device thread releases one buffer for every frame it gets.
+static constexpr size_t FRAME_BUFFERS_KEPT = 4;
+
 // If the timestamp is further in the future than
 // 100 seconds, abort
 static constexpr double TIMESTAMP_ABORT_FUTURE = 100;
@@ -62,6 +68,7 @@ static constexpr double TIMESTAMP_ABORT_FUTURE = 100;
 SDR::SDR(SDRDeviceConfig& config, std::shared_ptr<SDRDevice> device) :
     ModOutput(), ModMetadata(), RemoteControllable("sdr"),
     m_config(config),
+    m_buffer_pool(FRAME_BUFFERS_KEPT),
     m_device(device)
 {
     // muting is remote-controllable
@@ -98,6 +105,7 @@ SDR::SDR(SDRDeviceConfig& config, std::shared_ptr<SDRDevice> device) :
 #endif // HAVE_OUTPUT_UHD
 
     RC_ADD_PARAMETER(queued_frames_ms, "Number of frames queued, represented in milliseconds");
+    RC_ADD_PARAMETER(queued_frames_bytes, "Memory used by the queued frames, in bytes");
 
 #ifdef HAVE_LIMESDR
     if (std::dynamic_pointer_cast<Lime>(device)) {
@@ -105,6 +113,10 @@ SDR::SDR(SDRDeviceConfig& config, std::shared_ptr<SDRDevice> device) :
     }
 #endif // HAVE_LIMESDR
 
+    if (std::dynamic_pointer_cast<Simulated>(device)) {
+        RC_ADD_PARAMETER(fifo_fill, "A value representing the simulated FIFO fullness [percent]");
+    }
+
 #ifdef HAVE_DEXTER
     if (std::dynamic_pointer_cast<Dexter>(device)) {
         RC_ADD_PARAMETER(in_holdover_since, "DEXTER timestamp when holdover began");
@@ -138,19 +150,19 @@ int SDR::process(Buffer *dataIn)
         throw std::runtime_error("SDR thread failed");
     }
 
-    const uint8_t* pDataIn = (uint8_t*)dataIn->getData();
-    m_frame.resize(dataIn->getLength());
-    std::copy(pDataIn, pDataIn + dataIn->getLength(),
-            m_frame.begin());
+    // Take over the samples without copying them, and give the flowgraph
+    // a recycled buffer to write the next frame into.
+    m_frame = m_buffer_pool.get();
+    m_frame->swap(*dataIn);
 
     // We will effectively transmit the frame once we got the metadata.
 
-    return dataIn->getLength();
+    return m_frame->getLength();
 }
 
 meta_vec_t SDR::process_metadata(const meta_vec_t& metadataIn)
 {
-    if (m_device and m_running) {
+    if (m_device and m_running and m_frame) {
         FrameData frame;
         frame.buf = std::move(m_frame);
         frame.sampleSize = m_size;
@@ -172,7 +184,20 @@ meta_vec_t SDR::process_metadata(const meta_vec_t& metadataIn)
             // TODO check device running
 
             try {
-                if (m_dpd_feedback_server) {
+                if (m_dpd_feedback_server and m_config.compactQueue) {
+                    // The feedback server works on complexf samples, convert
+                    // the frame only if it is waiting for one.
+                    if (m_dpd_feedback_server->tx_frame_requested()) {
+                        const size_t num_values = frame.buf->getLength() / sizeof(int16_t);
+                        auto converted = make_shared<Buffer>(num_values * sizeof(float));
+                        FormatConverter::s16_to_float(
+                                reinterpret_cast<const int16_t*>(frame.buf->getData()),
+                                reinterpret_cast<float*>(converted->getData()),
+                                num_values, 1.0f / 32767.0f);
+                        m_dpd_feedback_server->set_tx_frame(converted, frame.ts);
+                    }
+                }
+                else if (m_dpd_feedback_server) {
                     m_dpd_feedback_server->set_tx_frame(frame.buf, frame.ts);
                 }
             }
@@ -187,6 +212,8 @@ meta_vec_t SDR::process_metadata(const meta_vec_t& metadataIn)
             }
 
 
+            m_queued_frame_bytes.store(frame.buf->getLength());
+
             const auto max_size = m_config.enableSync ? FRAMES_MAX_SIZE_SYNC : FRAMES_MAX_SIZE_UNSYNC;
             auto r = m_queue.push_overflow(std::move(frame), max_size);
             etiLog.log(trace, "SDR,push %d %zu", r.overflowed, r.new_size);
@@ -290,7 +317,7 @@ void SDR::handle_frame(struct FrameData&& frame)
         }
 
         if (last_tx_time_initialised) {
-            const size_t sizeIn = frame.buf.size() / frame.sampleSize;
+            const size_t sizeIn = frame.buf->getLength() / frame.sampleSize;
 
             // Checking units for the increment calculation:
             // samps  * ticks/s  / (samps/s)
@@ -460,6 +487,9 @@ const string SDR::get_parameter(const string& parameter) const
             chrono::duration_cast<chrono::milliseconds>(transmission_frame_duration(m_config.dabMode))
             .count();
     }
+    else if (parameter == "queued_frames_bytes") {
+        ss << m_queue.size() * m_queued_frame_bytes.load();
+    }
     else if (parameter == "synchronous") {
         ss << m_config.enableSync;
     }
@@ -533,6 +563,7 @@ const json::map_t SDR::get_all_values() const
     stat["queued_frames_ms"].v = m_queue.size() *
             (size_t)chrono::duration_cast<chrono::milliseconds>(transmission_frame_duration(m_config.dabMode))
             .count();
+    stat["queued_frames_bytes"].v = m_queue.size() * m_queued_frame_bytes.load();
 
     stat["synchronous"].v = m_config.enableSync;
     stat["max_gps_holdover_time"].v = (size_t)m_config.maxGPSHoldoverTime;
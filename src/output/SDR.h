@@ -35,6 +35,7 @@ DESCRIPTION:
 #endif
 
 #include "ModPlugin.h"
+#include "BufferPool.h"
 #include "output/SDRDevice.h"
 #include "output/Feedback.h"
 
@@ -74,9 +75,17 @@ class SDR : public ModOutput, public ModMetadata, public RemoteControllable {
         std::atomic<bool> m_running = ATOMIC_VAR_INIT(false);
         std::thread m_device_thread;
         size_t m_size = sizeof(complexf);
-        std::vector<uint8_t> m_frame;
+
+        // The frames are passed to the device thread in buffers from
+        // this pool, which avoids copying them.
+        BufferPool m_buffer_pool;
+        Buffer::sptr m_frame;
         ThreadsafeQueue<FrameData> m_queue;
 
+        // Size of the buffer of the last queued frame, all queued frames
+        // have the same size.
+        std::atomic<size_t> m_queued_frame_bytes = ATOMIC_VAR_INIT(0);
+
         std::shared_ptr<SDRDevice> m_device;
         std::string m_name;
 
@@ -41,6 +41,7 @@ DESCRIPTION:
 #include <optional>
 
 #include "TimestampDecoder.h"
+#include "Buffer.h"
 
 namespace Output {
 
@@ -59,6 +60,10 @@ struct SDRDeviceConfig {
 
     bool fixedPoint = false;
 
+    // Sample format of the TX stream, complexf or sc12. Only
+    // SoapySDR supports sc12.
+    std::string sampleFormat = "complexf";
+
     long masterClockRate = 32768000;
     unsigned sampleRate = 2048000;
     double frequency = 0.0;
@@ -72,6 +77,12 @@ struct SDRDeviceConfig {
     // When working with timestamps, mute the frames that
     // do not have a timestamp
     bool muteNoTimestamps = false;
+
+    // Quantise the frames to sc16 before they get queued for the
+    // device, which halves the memory used by the queue. The devices
+    // then get sc16 frames instead of complexf.
+    bool compactQueue = false;
+
     unsigned dabMode = 0;
     unsigned maxGPSHoldoverTime = 0;
 
@@ -96,11 +107,47 @@ struct SDRDeviceConfig {
     uint16_t dpdFeedbackServerPort = 0;
 };
 
+// Settings specific to the Simulated device
+struct SimulatedConfig {
+    // If not empty, all transmitted samples get written to this file
+    std::string iq_filename;
+
+    // Size of the FIFO of the device, in milliseconds of samples
+    unsigned fifo_ms = 200;
+
+    /* Model of the power amplifier between the TX and the RX loopback.
+     * Rapp: A(r) = r / (1 + (r/sat)^(2p))^(1/(2p)), without AM/PM
+     * Saleh: A(r) = alpha_a r / (1 + beta_a r^2),
+     *        phi(r) = alpha_phi r^2 / (1 + beta_phi r^2)
+     */
+    enum class pa_model_t { None, Rapp, Saleh };
+    pa_model_t pa_model = pa_model_t::None;
+
+    double rapp_smoothness = 2.0;
+    double rapp_saturation = 1.0;
+
+    double saleh_alpha_a = 2.1587;
+    double saleh_beta_a = 1.1517;
+    double saleh_alpha_phi = 4.0033;
+    double saleh_beta_phi = 9.1040;
+
+    // FIR filter applied after the nonlinearity, to model the
+    // memory of the PA. Empty means no filter.
+    std::vector<float> memory_taps;
+
+    // Delay of the loopback in samples, can be fractional
+    double rx_delay = 0.0;
+
+    // Standard deviation of the noise added to I and Q of the RX samples
+    double rx_noise = 0.0;
+};
+
 // Each frame contains one OFDM frame, and its
 // associated timestamp
 struct FrameData {
-    // Buffer holding frame data
-    std::vector<uint8_t> buf;
+    // Buffer holding frame data. It comes from the buffer pool of the
+    // SDR output, and returns to it once the last reference is dropped.
+    Buffer::sptr buf;
     size_t sampleSize = sizeof(complexf);
 
     // A full timestamp contains a TIST according to standard
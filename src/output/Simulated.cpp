@@ -0,0 +1,418 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "output/Simulated.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include "Log.h"
+
+using namespace std;
+
+namespace Output {
+
+// How long the transmitted frames are kept for the DPD feedback
+static constexpr int64_t TX_HISTORY_NS = 1000000000LL;
+
+Simulated::Simulated(SDRDeviceConfig& config, const SimulatedConfig& sim_config) :
+    SDRDevice(),
+    m_conf(config),
+    m_sim_conf(sim_config),
+    m_rng(std::random_device()()),
+    m_noise_dist(0.0f, 1.0f)
+{
+    if (m_conf.sampleRate == 0) {
+        throw runtime_error("Simulated: invalid sample rate");
+    }
+
+    if (m_sim_conf.rx_delay < 0) {
+        throw runtime_error("Simulated: invalid rx_delay");
+    }
+
+    m_fifo_size = std::max<size_t>(1,
+            (size_t)m_conf.sampleRate * m_sim_conf.fifo_ms / 1000);
+
+    const auto& iq_filename = m_sim_conf.iq_filename;
+    if (not iq_filename.empty()) {
+        FILE* fd = fopen(iq_filename.c_str(), "w");
+        if (fd == nullptr) {
+            perror(iq_filename.c_str());
+            throw runtime_error("Simulated: unable to open IQ file!");
+        }
+        m_iq_file.reset(fd);
+    }
+
+    // The integer part of the delay shifts the samples, the fractional
+    // part gets combined with the memory taps into one filter, using
+    // linear interpolation between two samples.
+    m_rx_delay_samples = (int64_t)std::floor(m_sim_conf.rx_delay);
+    const float frac = m_sim_conf.rx_delay - m_rx_delay_samples;
+
+    std::vector<complexf> taps;
+    for (const float t : m_sim_conf.memory_taps) {
+        taps.emplace_back(t, 0.0f);
+    }
+    if (taps.empty()) {
+        taps.emplace_back(1.0f, 0.0f);
+    }
+
+    if (frac > 0) {
+        m_rx_filter.assign(taps.size() + 1, 0.0f);
+        for (size_t i = 0; i < taps.size(); i++) {
+            m_rx_filter[i] += (1.0f - frac) * taps[i];
+            m_rx_filter[i + 1] += frac * taps[i];
+        }
+    }
+    else {
+        m_rx_filter = taps;
+    }
+
+    etiLog.level(info) << "Simulated: device with sample rate " <<
+        m_conf.sampleRate << " and FIFO of " << m_fifo_size << " samples" <<
+        (iq_filename.empty() ? "" : ", writing IQ to " + iq_filename);
+}
+
+void Simulated::tune(double lo_offset, double frequency)
+{
+    m_conf.lo_offset = lo_offset;
+    m_conf.frequency = frequency;
+}
+
+double Simulated::get_tx_freq(void) const
+{
+    return m_conf.frequency;
+}
+
+void Simulated::set_txgain(double txgain)
+{
+    m_conf.txgain = txgain;
+}
+
+double Simulated::get_txgain(void) const
+{
+    return m_conf.txgain;
+}
+
+void Simulated::set_bandwidth(double bandwidth)
+{
+    m_conf.bandwidth = bandwidth;
+}
+
+double Simulated::get_bandwidth(void) const
+{
+    return m_conf.bandwidth;
+}
+
+SDRDevice::run_statistics_t Simulated::get_run_statistics(void) const
+{
+    run_statistics_t rs;
+    rs["underruns"].v = underflows.load();
+    rs["latepackets"].v = num_late.load();
+    rs["frames"].v = num_frames_modulated.load();
+    rs["fifo_fill"].v = m_last_fifo_fill_percent.load() * 100;
+    return rs;
+}
+
+int64_t Simulated::now_ns(void)
+{
+    // The simulated device is synchronised to the system time, like an
+    // SDR with a GPSDO would be.
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+double Simulated::get_real_secs(void) const
+{
+    return now_ns() / 1e9;
+}
+
+void Simulated::set_rxgain(double rxgain)
+{
+    m_conf.rxgain = rxgain;
+}
+
+double Simulated::get_rxgain(void) const
+{
+    return m_conf.rxgain;
+}
+
+size_t Simulated::receive_frame(
+        complexf *buf,
+        size_t num_samples,
+        frame_timestamp& ts,
+        double timeout_secs)
+{
+    // The samples at the RX port are only complete once the
+    // device time has passed the end of the requested interval.
+    const int64_t start_ns = ts.get_ns();
+    const int64_t end_ns = start_ns +
+        (int64_t)num_samples * 1000000000LL / m_conf.sampleRate;
+    const int64_t deadline_ns = now_ns() + (int64_t)(timeout_secs * 1e9);
+
+    if (end_ns > deadline_ns) {
+        this_thread::sleep_for(chrono::nanoseconds(deadline_ns - now_ns()));
+        return 0;
+    }
+
+    const int64_t wait_ns = end_ns - now_ns();
+    if (wait_ns > 0) {
+        this_thread::sleep_for(chrono::nanoseconds(wait_ns));
+    }
+
+    // RX sample i is the PA output for TX samples i - delay - k,
+    // k going over the filter taps.
+    const size_t num_taps = m_rx_filter.size();
+    const int64_t first = -m_rx_delay_samples - (int64_t)(num_taps - 1);
+    std::vector<complexf> pa_out(num_samples + num_taps - 1);
+    gather_tx(start_ns, first, pa_out.size(), pa_out.data());
+    apply_pa_model(pa_out.data(), pa_out.size());
+
+    const float rx_scale = std::pow(10.0, m_conf.rxgain / 20.0);
+    const float noise_stddev = m_sim_conf.rx_noise;
+
+    for (size_t i = 0; i < num_samples; i++) {
+        complexf acc = 0.0f;
+        for (size_t k = 0; k < num_taps; k++) {
+            acc += m_rx_filter[k] * pa_out[i + num_taps - 1 - k];
+        }
+
+        if (noise_stddev > 0) {
+            acc += complexf(
+                    noise_stddev * m_noise_dist(m_rng),
+                    noise_stddev * m_noise_dist(m_rng));
+        }
+
+        buf[i] = rx_scale * acc;
+    }
+
+    return num_samples;
+}
+
+void Simulated::gather_tx(int64_t t0_ns, int64_t first, size_t len, complexf *out)
+{
+    std::fill(out, out + len, complexf(0.0f, 0.0f));
+
+    std::lock_guard<std::mutex> lock(m_tx_history_mutex);
+    for (const auto& burst : m_tx_history) {
+        const int64_t burst_len = burst.buf->getLength() / burst.sample_size;
+
+        // out[m] corresponds to the sample at index m + offset of the burst
+        const int64_t offset = first + llrint(
+                (double)(t0_ns - burst.start_ns) * m_conf.sampleRate / 1e9);
+
+        const int64_t m_begin = std::max<int64_t>(0, -offset);
+        const int64_t m_end = std::min<int64_t>(len, burst_len - offset);
+
+        if (burst.sample_size == sizeof(complexf)) {
+            const complexf *in = reinterpret_cast<const complexf*>(burst.buf->getData());
+            for (int64_t m = m_begin; m < m_end; m++) {
+                out[m] = in[m + offset];
+            }
+        }
+        else {
+            // With compact_queue, the frames contain sc16 samples
+            const int16_t *in = reinterpret_cast<const int16_t*>(burst.buf->getData());
+            for (int64_t m = m_begin; m < m_end; m++) {
+                out[m] = complexf(in[2 * (m + offset)], in[2 * (m + offset) + 1]) /
+                    32767.0f;
+            }
+        }
+    }
+}
+
+void Simulated::apply_pa_model(complexf *buf, size_t len) const
+{
+    const float tx_scale = std::pow(10.0, m_conf.txgain / 20.0);
+
+    switch (m_sim_conf.pa_model) {
+        case SimulatedConfig::pa_model_t::None:
+            for (size_t i = 0; i < len; i++) {
+                buf[i] *= tx_scale;
+            }
+            break;
+        case SimulatedConfig::pa_model_t::Rapp:
+        {
+            const float two_p = 2.0 * m_sim_conf.rapp_smoothness;
+            const float inv_sat = 1.0 / m_sim_conf.rapp_saturation;
+            for (size_t i = 0; i < len; i++) {
+                const complexf x = buf[i] * tx_scale;
+                const float r = std::abs(x);
+                const float gain = 1.0f /
+                    std::pow(1.0f + std::pow(r * inv_sat, two_p), 1.0f / two_p);
+                buf[i] = x * gain;
+            }
+            break;
+        }
+        case SimulatedConfig::pa_model_t::Saleh:
+        {
+            const float alpha_a = m_sim_conf.saleh_alpha_a;
+            const float beta_a = m_sim_conf.saleh_beta_a;
+            const float alpha_phi = m_sim_conf.saleh_alpha_phi;
+            const float beta_phi = m_sim_conf.saleh_beta_phi;
+            for (size_t i = 0; i < len; i++) {
+                const complexf x = buf[i] * tx_scale;
+                const float r2 = std::norm(x);
+                const float gain = alpha_a / (1.0f + beta_a * r2);
+                const float phi = alpha_phi * r2 / (1.0f + beta_phi * r2);
+                buf[i] = x * std::polar(gain, phi);
+            }
+            break;
+        }
+    }
+}
+
+bool Simulated::is_clk_source_ok(void)
+{
+    return true;
+}
+
+const char* Simulated::device_name(void) const
+{
+    return "Simulated";
+}
+
+std::optional<double> Simulated::get_temperature(void) const
+{
+    return std::nullopt;
+}
+
+size_t Simulated::update_fifo(int64_t now)
+{
+    while (not m_fifo.empty() and m_fifo.front().end_ns <= now) {
+        m_fifo.pop_front();
+    }
+
+    size_t num_queued = 0;
+    for (const auto& burst : m_fifo) {
+        if (now <= burst.start_ns) {
+            num_queued += burst.num_samples;
+        }
+        else {
+            num_queued += (burst.end_ns - now) * m_conf.sampleRate / 1000000000LL;
+        }
+    }
+    return num_queued;
+}
+
+void Simulated::transmit_frame(struct FrameData&& frame)
+{
+    const size_t num_samples = frame.buf->getLength() / frame.sampleSize;
+    if ((frame.buf->getLength() % frame.sampleSize) != 0) {
+        throw runtime_error("Simulated: invalid buffer size");
+    }
+
+    const int64_t duration_ns = (int64_t)num_samples * 1000000000LL / m_conf.sampleRate;
+
+    // A timestamp within one sample of the end of the previous frame
+    // continues the stream.
+    const int64_t tolerance_ns = 1000000000LL / m_conf.sampleRate;
+
+    int64_t now = now_ns();
+    update_fifo(now);
+
+    // muting and mutenotimestamp is handled by SDR
+    const bool has_time_spec = (m_conf.enableSync and frame.ts.timestamp_valid);
+
+    int64_t start_ns = 0;
+    if (has_time_spec) {
+        start_ns = frame.ts.get_ns();
+
+        const bool overlaps_previous = (m_stream_end_ns != 0 and
+                start_ns + tolerance_ns < m_stream_end_ns);
+
+        if (start_ns < now or overlaps_previous) {
+            // The device would only get to this frame after its
+            // transmission time, it drops it.
+            num_late++;
+            etiLog.level(debug) << "Simulated: late packet at FCT=" <<
+                frame.ts.fct << " by " <<
+                (std::max(now, m_stream_end_ns) - start_ns) / 1000 << " us";
+            return;
+        }
+
+        if (m_stream_end_ns != 0 and not m_require_timestamp_refresh and
+                start_ns > m_stream_end_ns + tolerance_ns) {
+            // The FIFO ran empty between the previous frame and this one
+            underflows++;
+        }
+        m_require_timestamp_refresh = false;
+    }
+    else if (m_stream_end_ns < now) {
+        if (m_stream_end_ns != 0) {
+            underflows++;
+        }
+        start_ns = now;
+    }
+    else {
+        start_ns = m_stream_end_ns;
+    }
+
+    // Block while the FIFO cannot take the whole frame
+    size_t num_queued = update_fifo(now);
+    while (not m_fifo.empty() and num_queued + num_samples > m_fifo_size) {
+        const auto& front = m_fifo.front();
+        if (now < front.start_ns) {
+            this_thread::sleep_for(chrono::nanoseconds(front.start_ns - now));
+        }
+        else {
+            const size_t excess = num_queued + num_samples - m_fifo_size;
+            this_thread::sleep_for(chrono::nanoseconds(
+                        1 + (int64_t)excess * 1000000000LL / m_conf.sampleRate));
+        }
+
+        now = now_ns();
+        num_queued = update_fifo(now);
+    }
+
+    m_fifo.push_back({start_ns, start_ns + duration_ns, num_samples});
+    m_stream_end_ns = start_ns + duration_ns;
+    num_queued += num_samples;
+
+    m_last_fifo_fill_percent.store(
+            std::min(1.0f, (float)num_queued / (float)m_fifo_size));
+
+    if (m_iq_file) {
+        if (fwrite(frame.buf->getData(), frame.buf->getLength(), 1, m_iq_file.get()) == 0) {
+            throw runtime_error("Simulated: unable to write to IQ file!");
+        }
+    }
+
+    if (m_conf.dpdFeedbackServerPort > 0) {
+        std::lock_guard<std::mutex> lock(m_tx_history_mutex);
+        while (not m_tx_history.empty() and
+                m_tx_history.front().end_ns + TX_HISTORY_NS < now) {
+            m_tx_history.pop_front();
+        }
+        m_tx_history.push_back({start_ns, start_ns + duration_ns,
+                std::move(frame.buf), frame.sampleSize});
+    }
+
+    num_frames_modulated++;
+}
+
+} // namespace Output
+
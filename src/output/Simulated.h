@@ -0,0 +1,152 @@
+/*
+   Copyright (C) 2026
+   Matthias P. Braendli, matthias.braendli@mpb.li
+
+    http://opendigitalradio.org
+ */
+/*
+   This file is part of ODR-DabMod.
+
+   ODR-DabMod is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   ODR-DabMod is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with ODR-DabMod.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifdef HAVE_CONFIG_H
+#   include <config.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "output/SDR.h"
+#include "ModPlugin.h"
+
+namespace Output {
+
+/* A software SDR device that does not talk to any hardware. It consumes the
+ * samples at the configured sample rate, following the system clock, and
+ * behaves like the TX path of a real device: timestamps are honoured, late
+ * frames get dropped, and the caller gets blocked while the FIFO is full.
+ *
+ * It makes it possible to benchmark and test the timed transmission path
+ * of the modulator on a machine without any SDR hardware.
+ *
+ * When the DPD feedback server is enabled, the device keeps the recently
+ * transmitted frames, and receive_frame() returns them as they would
+ * appear at the output of a PA, according to the SimulatedConfig.
+ * The txgain drives the PA, and the rxgain scales the RX samples, both
+ * in dB. This closes the DPD loop without any hardware.
+ */
+
+class Simulated : public Output::SDRDevice
+{
+    public:
+        Simulated(SDRDeviceConfig& config, const SimulatedConfig& sim_config);
+        Simulated(const Simulated& other) = delete;
+        Simulated& operator=(const Simulated& other) = delete;
+        ~Simulated() = default;
+
+        virtual void tune(double lo_offset, double frequency) override;
+        virtual double get_tx_freq(void) const override;
+        virtual void set_txgain(double txgain) override;
+        virtual double get_txgain(void) const override;
+        virtual void set_bandwidth(double bandwidth) override;
+        virtual double get_bandwidth(void) const override;
+        virtual void transmit_frame(struct FrameData&& frame) override;
+        virtual run_statistics_t get_run_statistics(void) const override;
+        virtual double get_real_secs(void) const override;
+
+        virtual void set_rxgain(double rxgain) override;
+        virtual double get_rxgain(void) const override;
+        virtual size_t receive_frame(
+                complexf *buf,
+                size_t num_samples,
+                frame_timestamp& ts,
+                double timeout_secs) override;
+
+        // The simulated clock is always ok
+        virtual bool is_clk_source_ok(void) override;
+        virtual const char* device_name(void) const override;
+
+        virtual std::optional<double> get_temperature(void) const override;
+
+    private:
+        // Device time in nanoseconds since the epoch
+        static int64_t now_ns(void);
+
+        // Remove the bursts that have been transmitted entirely, and
+        // return the number of samples still waiting in the FIFO.
+        size_t update_fifo(int64_t now);
+
+        /* Fill out[0..len) with the transmitted samples, where out[m]
+         * is the sample that was transmitted first + m sample periods
+         * after t0_ns. Times at which nothing was transmitted give zeros. */
+        void gather_tx(int64_t t0_ns, int64_t first, size_t len, complexf *out);
+
+        // Apply the txgain and the nonlinearity of the PA in place
+        void apply_pa_model(complexf *buf, size_t len) const;
+
+        SDRDeviceConfig& m_conf;
+        SimulatedConfig m_sim_conf;
+        size_t m_fifo_size = 0; // in samples
+
+        struct FILEDeleter{ void operator()(FILE* fd){ if (fd) fclose(fd); }};
+        std::unique_ptr<FILE, FILEDeleter> m_iq_file;
+
+        // The bursts accepted into the FIFO, in transmission order
+        struct burst_t {
+            int64_t start_ns;
+            int64_t end_ns;
+            size_t num_samples;
+        };
+        std::deque<burst_t> m_fifo;
+
+        // Time at which the last accepted sample gets transmitted,
+        // 0 before the first frame.
+        int64_t m_stream_end_ns = 0;
+
+        // The frames transmitted during the last second, kept only if
+        // the DPD feedback server needs them.
+        struct tx_burst_t {
+            int64_t start_ns;
+            int64_t end_ns;
+            Buffer::sptr buf;
+            size_t sample_size;
+        };
+        std::deque<tx_burst_t> m_tx_history;
+        std::mutex m_tx_history_mutex;
+
+        // Memory taps combined with the fractional part of the delay
+        std::vector<complexf> m_rx_filter;
+        int64_t m_rx_delay_samples = 0;
+
+        std::mt19937 m_rng;
+        std::normal_distribution<float> m_noise_dist;
+
+        std::atomic<size_t> underflows = ATOMIC_VAR_INIT(0);
+        std::atomic<size_t> num_late = ATOMIC_VAR_INIT(0);
+        std::atomic<size_t> num_frames_modulated = ATOMIC_VAR_INIT(0);
+        std::atomic<float> m_last_fifo_fill_percent = ATOMIC_VAR_INIT(0);
+};
+
+} // namespace Output
+
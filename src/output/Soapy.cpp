@@ -34,6 +34,7 @@ DESCRIPTION:
 #ifdef HAVE_SOAPYSDR
 
 #include <SoapySDR/Errors.hpp>
+#include <algorithm>
 #include <chrono>
 #include <limits>
 #include <cstdio>
@@ -116,8 +117,21 @@ Soapy::Soapy(SDRDeviceConfig& config) :
         m_device->setHardwareTime(ticks);
     }
 
+    std::string tx_format = "CF32";
+    if (m_conf.sampleFormat == "sc12") {
+        tx_format = "CS12";
+    }
+    else if (m_conf.compactQueue) {
+        tx_format = "CS16";
+    }
+    const auto tx_formats = m_device->getStreamFormats(SOAPY_SDR_TX, 0);
+    if (std::find(tx_formats.begin(), tx_formats.end(), tx_format) == tx_formats.end()) {
+        throw std::runtime_error("SoapySDR: device does not support TX stream format " +
+                tx_format);
+    }
+
     const std::vector<size_t> channels({0});
-    m_tx_stream = m_device->setupStream(SOAPY_SDR_TX, "CF32", channels);
+    m_tx_stream = m_device->setupStream(SOAPY_SDR_TX, tx_format, channels);
     m_rx_stream = m_device->setupStream(SOAPY_SDR_RX, "CF32", channels);
 }
 
@@ -291,10 +305,10 @@ void Soapy::transmit_frame(struct FrameData&& frame)
         m_tx_stream_active = true;
     }
 
-    // The frame buffer contains bytes representing FC32 samples
-    const complexf *buf = reinterpret_cast<const complexf*>(frame.buf.data());
-    const size_t numSamples = frame.buf.size() / sizeof(complexf);
-    if ((frame.buf.size() % sizeof(complexf)) != 0) {
+    // The frame buffer contains bytes representing FC32, CS16 or CS12 samples
+    const uint8_t *buf = reinterpret_cast<const uint8_t*>(frame.buf->getData());
+    const size_t numSamples = frame.buf->getLength() / frame.sampleSize;
+    if ((frame.buf->getLength() % frame.sampleSize) != 0) {
         throw std::runtime_error("Soapy: invalid buffer size");
     }
 
@@ -305,7 +319,7 @@ void Soapy::transmit_frame(struct FrameData&& frame)
     while (num_acc_samps < numSamples) {
 
         const void *buffs[1];
-        buffs[0] = buf + num_acc_samps;
+        buffs[0] = buf + num_acc_samps * frame.sampleSize;
 
         const size_t samps_to_send = std::min(numSamples - num_acc_samps, mtu);
 
@@ -233,7 +233,11 @@ UHD::UHD(SDRDeviceConfig& config) :
     const uhd::stream_args_t stream_args(
             m_conf.fixedPoint ? "sc16" : "fc32");
     m_rx_stream = m_usrp->get_rx_stream(stream_args);
-    m_tx_stream = m_usrp->get_tx_stream(stream_args);
+
+    // The frames of the compact queue are already sc16
+    const uhd::stream_args_t tx_stream_args(
+            (m_conf.fixedPoint or m_conf.compactQueue) ? "sc16" : "fc32");
+    m_tx_stream = m_usrp->get_tx_stream(tx_stream_args);
 
     m_running.store(true);
     m_async_rx_thread = std::thread(&UHD::print_async_thread, this);
@@ -316,8 +320,10 @@ void UHD::transmit_frame(struct FrameData&& frame)
 {
     const double tx_timeout = 20.0;
 
-    const size_t sample_size = m_conf.fixedPoint ? (2 * sizeof(int16_t)) : sizeof(complexf);
-    const size_t sizeIn = frame.buf.size() / sample_size;
+    const size_t sample_size = (m_conf.fixedPoint or m_conf.compactQueue) ?
+        (2 * sizeof(int16_t)) : sizeof(complexf);
+    const size_t sizeIn = frame.buf->getLength() / sample_size;
+    const uint8_t *buf = reinterpret_cast<const uint8_t*>(frame.buf->getData());
 
     uhd::tx_metadata_t md_tx;
 
@@ -352,7 +358,7 @@ void UHD::transmit_frame(struct FrameData&& frame)
 
         // send a single packet
         size_t num_tx_samps = m_tx_stream->send(
-                frame.buf.data() + sample_size * num_acc_samps,
+                buf + sample_size * num_acc_samps,
                 samps_to_send, md_tx, tx_timeout);
         etiLog.log(trace, "UHD,sent %zu of %zu", num_tx_samps, samps_to_send);
 